@@ -1,5 +1,26 @@
 #include <stddef.h>
 #include <limits.h>
+#include <stdatomic.h>
+#include "player_api.h"
+
+/* A thin thread layer: pthreads on POSIX, _beginthreadex with MSVC. */
+typedef struct { void *(*fn)(void *); void *arg; } WorkerCall;
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+typedef HANDLE worker_t;
+static unsigned __stdcall worker_entry(void *p){ WorkerCall *c = p; c->fn(c->arg); return 0; }
+static int worker_start(worker_t *w, WorkerCall *c){
+    *w = (HANDLE)_beginthreadex(NULL, 0, worker_entry, c, 0, NULL);
+    return *w != 0;
+}
+static void worker_join(worker_t w){ WaitForSingleObject(w, INFINITE); CloseHandle(w); }
+#else
+#include <pthread.h>
+typedef pthread_t worker_t;
+static int worker_start(worker_t *w, WorkerCall *c){ return pthread_create(w, NULL, c->fn, c->arg) == 0; }
+static void worker_join(worker_t w){ pthread_join(w, NULL); }
+#endif
 
 int sum_array(const int *a, size_t n){
     long long acc = 0;
@@ -7,4 +28,97 @@ int sum_array(const int *a, size_t n){
     if (acc > INT_MAX) acc = INT_MAX;
     if (acc < INT_MIN) acc = INT_MIN;
     return (int)acc;
-} 
\ No newline at end of file
+}
+
+#define MAX_WORKERS 256
+
+typedef struct { const int *a; size_t lo, hi; long long acc; char pad[64]; } SumSlice;
+
+static void *sum_worker(void *p){
+    SumSlice *s = p;
+    long long acc = 0;
+    for (size_t i = s->lo; i < s->hi; ++i) acc += s->a[i];
+    s->acc = acc;
+    return NULL;
+}
+
+long long parallel_sum(const int *a, size_t n, int threads){
+    if (threads < 1) threads = 1;
+    if (threads > MAX_WORKERS) threads = MAX_WORKERS;
+    SumSlice sl[MAX_WORKERS];
+    WorkerCall call[MAX_WORKERS];
+    worker_t tid[MAX_WORKERS];
+    int started[MAX_WORKERS];
+    for (int t = 0; t < threads; ++t) {
+        sl[t].a = a; sl[t].lo = n * t / threads; sl[t].hi = n * (t + 1) / threads; sl[t].acc = 0;
+    }
+    for (int t = 1; t < threads; ++t) {
+        call[t] = (WorkerCall){ sum_worker, &sl[t] };
+        started[t] = worker_start(&tid[t], &call[t]);
+        if (!started[t]) sum_worker(&sl[t]); /* no thread: do that slice here */
+    }
+    sum_worker(&sl[0]);
+    long long acc = sl[0].acc;
+    for (int t = 1; t < threads; ++t) { if (started[t]) worker_join(tid[t]); acc += sl[t].acc; }
+    return acc;
+}
+
+typedef struct { const int *in; int *out; size_t n; atomic_size_t next; } MapJob;
+
+#define MAP_CHUNK 4096
+
+static void *map_worker(void *p){
+    MapJob *j = p;
+    for (;;) {
+        size_t lo = atomic_fetch_add(&j->next, MAP_CHUNK);
+        if (lo >= j->n) break;
+        size_t hi = lo + MAP_CHUNK < j->n ? lo + MAP_CHUNK : j->n;
+        for (size_t i = lo; i < hi; ++i) j->out[i] = collatz_steps(j->in[i]);
+    }
+    return NULL;
+}
+
+void parallel_collatz(const int *in, int *out, size_t n, int threads){
+    if (threads < 1) threads = 1;
+    if (threads > MAX_WORKERS) threads = MAX_WORKERS;
+    MapJob j = { in, out, n, 0 };
+    WorkerCall call = { map_worker, &j };
+    worker_t tid[MAX_WORKERS];
+    int started[MAX_WORKERS];
+    /* Chunks are claimed from a shared counter, so a worker that failed to
+       start leaves nothing undone: the others, this thread included, take it. */
+    for (int t = 1; t < threads; ++t) started[t] = worker_start(&tid[t], &call);
+    map_worker(&j);
+    for (int t = 1; t < threads; ++t) if (started[t]) worker_join(tid[t]);
+}
+
+/* Vectorization zone: scalar starting points. */
+
+int sum_checked(const int32_t *a, size_t n, int32_t *out){
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += a[i];
+    if (acc > INT32_MAX || acc < INT32_MIN) return 0;
+    *out = (int32_t)acc;
+    return 1;
+}
+
+int64_t dot_i16(const int16_t *a, const int16_t *b, size_t n){
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += (int32_t)a[i] * b[i];
+    return acc;
+}
+
+void prefix_sum_u32(const uint32_t *in, uint32_t *out, size_t n){
+    uint32_t run = 0;
+    for (size_t i = 0; i < n; ++i) { run += in[i]; out[i] = run; }
+}
+
+size_t find_byte(const uint8_t *s, size_t n, uint8_t c){
+    for (size_t i = 0; i < n; ++i) if (s[i] == c) return i;
+    return n;
+}
+
+void histogram_u8(const uint8_t *s, size_t n, uint32_t hist[256]){
+    for (int b = 0; b < 256; ++b) hist[b] = 0;
+    for (size_t i = 0; i < n; ++i) hist[s[i]]++;
+}
@@ -1,6 +1,7 @@
 #include "common.h"
 #include "save.h"
 #include "analytics.h"
+#include "trace.h"
 
 static int file_exists(const char *p){ FILE*f=fopen(p,"r"); if(!f) return 0; fclose(f); return 1; }
 
@@ -24,9 +25,11 @@ void analytics_log_header_if_needed(void){
 }
 
 void analytics_log_event(const char *kind,const char *detail,int v){
+    TraceSpan sp=trace_begin("analytics.log",kind);
     char path[512]; get_analytics_path(path,sizeof path);
-    FILE*f=fopen(path,"a"); if(!f) return;
+    FILE*f=fopen(path,"a"); if(!f){ trace_end(&sp); return; }
     char ts[32]; now_iso(ts,sizeof ts);
     fprintf(f,"%s,%s,%s,%d\n",ts,kind?kind:"",detail?detail:"",v);
     fclose(f);
+    trace_end(&sp);
 } 
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "challenge.h"
+#include "scaling.h"
+#include "cpu_features.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define MAX_CHALLENGES 64
 static Challenge g_chals[MAX_CHALLENGES];
@@ -21,9 +26,155 @@ const Challenge* challenges_get(int idx) {
     return &g_chals[idx];
 }
 
+/* ---- parallel scaling ---- */
+
+typedef struct { ChallengeSig sig; void *fn; const int *in; int *out; size_t n; long long sum; } ParRun;
+
+static void par_run(void *ctx, int threads) {
+    ParRun *p = (ParRun*)ctx;
+    if (p->sig == SIG_PARALLEL_SUM) p->sum = ((fn_parallel_sum)p->fn)(p->in, p->n, threads);
+    else ((fn_parallel_map)p->fn)(p->in, p->out, p->n, threads);
+}
+
+static int par_same(const ParRun *got, const ParRun *want) {
+    if (got->sig == SIG_PARALLEL_SUM) return got->sum == want->sum;
+    return got->n == 0 || memcmp(got->out, want->out, got->n * sizeof(int)) == 0;
+}
+
+static void fill_input(int *a, size_t n) {
+    unsigned s = 12345u; /* fixed seed: every player grades against the same data */
+    for (size_t i = 0; i < n; ++i) { s = s * 1103515245u + 12345u; a[i] = 1 + (int)((s >> 8) & 0xFFFF); }
+}
+
+static int par_award(const Challenge *c, const ScalingSpec *sp, const ScalingPoint *last, int npts) {
+    if (npts == 1) {
+        printf("  (one CPU available: scaling not measurable, base XP only)\n");
+        return c->xp_reward / 2;
+    }
+    double e = last->efficiency;
+    const char *tier = "none";
+    int xp = c->xp_reward / 4;
+    if (e >= sp->eff_gold)        { tier = "gold";   xp = c->xp_reward; }
+    else if (e >= sp->eff_silver) { tier = "silver"; xp = c->xp_reward * 3 / 4; }
+    else if (e >= sp->eff_bronze) { tier = "bronze"; xp = c->xp_reward / 2; }
+    printf("  efficiency at %d threads: %.0f%% -> tier %s\n", last->threads, e * 100.0, tier);
+    return xp;
+}
+
+static GradeResult grade_parallel(const Challenge *c, int visibility) {
+    GradeResult r = (GradeResult){0, 0, 0};
+    const ScalingSpec *sp = c->scaling;
+    if (!sp || !sp->reference_fn) return r;
+
+    /* Edge cases first: empty, single element, more threads than elements. */
+    static const size_t EDGE_N[] = {0, 1, 7};
+    static const int EDGE_T[] = {1, 3, 8};
+    int small[7], small_out[7], small_ref[7];
+    fill_input(small, 7);
+    for (size_t i = 0; i < sizeof EDGE_N / sizeof EDGE_N[0]; ++i) {
+        for (size_t k = 0; k < sizeof EDGE_T / sizeof EDGE_T[0]; ++k) {
+            ParRun got = { c->sig, c->solution_fn, small, small_out, EDGE_N[i], 0 };
+            ParRun want = { c->sig, sp->reference_fn, small, small_ref, EDGE_N[i], 0 };
+            par_run(&want, 1);
+            par_run(&got, EDGE_T[k]);
+            r.total++;
+            if (par_same(&got, &want)) r.passed++;
+            else if (visibility > 0) printf("  * Edge case n=%zu threads=%d failed\n", EDGE_N[i], EDGE_T[k]);
+        }
+    }
+
+    size_t n = sp->n;
+    int *in = (int*)malloc(n * sizeof(int));
+    int *out = (int*)malloc(n * sizeof(int));
+    int *ref = (int*)malloc(n * sizeof(int));
+    if (!in || !out || !ref) { free(in); free(out); free(ref); printf("  out of memory\n"); return r; }
+    fill_input(in, n);
+    ParRun want = { c->sig, sp->reference_fn, in, ref, n, 0 };
+    par_run(&want, 1);
+
+    int max_t = sp->max_threads > 0 ? sp->max_threads : scaling_cpu_count();
+    int counts[SCALING_MAX_POINTS];
+    int npts = scaling_thread_counts(max_t, counts, SCALING_MAX_POINTS);
+    ScalingPoint pts[SCALING_MAX_POINTS];
+    int curve_ok = 1;
+
+    printf("  threads   best ms   speedup   efficiency\n");
+    for (int i = 0; i < npts; ++i) {
+        ParRun got = { c->sig, c->solution_fn, in, out, n, 0 };
+        memset(out, 0, n * sizeof(int));
+        pts[i].threads = counts[i];
+        pts[i].best_ms = scaling_time_best(par_run, &got, counts[i], sp->reps);
+        pts[i].speedup = pts[i].best_ms > 0 ? pts[0].best_ms / pts[i].best_ms : 1.0;
+        pts[i].efficiency = pts[i].speedup / counts[i];
+        r.total++;
+        int ok = par_same(&got, &want);
+        if (ok) r.passed++; else curve_ok = 0;
+        printf("  %7d %9.2f %8.2fx %11.0f%%%s\n", pts[i].threads, pts[i].best_ms,
+               pts[i].speedup, pts[i].efficiency * 100.0, ok ? "" : "  WRONG RESULT");
+    }
+    if (r.passed != r.total && visibility > 1 && sp->hint) printf("    hint: %s\n", sp->hint);
+
+    if (r.passed == r.total && curve_ok) r.xp = par_award(c, sp, &pts[npts - 1], npts);
+    free(in); free(out); free(ref);
+    return r;
+}
+
+/* ---- vector kernels ---- */
+
+typedef struct { const KernelSpec *k; void *bench; void *fn; } KernelRun;
+
+static void kernel_run(void *ctx, int threads) {
+    (void)threads;
+    KernelRun *kr = (KernelRun*)ctx;
+    kr->k->bench_run(kr->bench, kr->fn);
+}
+
+static GradeResult grade_kernel(const Challenge *c, int visibility) {
+    GradeResult r = (GradeResult){0, 0, 0};
+    const KernelSpec *k = c->kernel;
+    if (!k || !k->refs[0]) return r;
+
+    r.passed = k->check(c->solution_fn, visibility, &r.total);
+    if (r.passed != r.total) {
+        if (visibility > 1 && k->hint) printf("    hint: %s\n", k->hint);
+        return r;
+    }
+    void *bench = k->bench_setup(k->bench_n);
+    if (!bench) { printf("  out of memory\n"); return r; }
+
+    static const char *VARIANT[3] = {"scalar ref", "sse2 ref", "avx2 ref"};
+    int have[3] = {1, cpu_has_sse2(), cpu_has_avx2()};
+    double base = 0;
+    printf("  kernel        best ms   vs scalar\n");
+    for (int v = 0; v < 3; ++v) {
+        if (!k->refs[v] || !have[v]) continue;
+        KernelRun kr = { k, bench, k->refs[v] };
+        double ms = scaling_time_best(kernel_run, &kr, 1, k->reps);
+        if (v == 0) base = ms;
+        printf("  %-12s %8.3f %10.2fx\n", VARIANT[v], ms, ms > 0 ? base / ms : 1.0);
+    }
+    KernelRun kr = { k, bench, c->solution_fn };
+    double ms = scaling_time_best(kernel_run, &kr, 1, k->reps);
+    double speedup = ms > 0 ? base / ms : 1.0;
+    printf("  %-12s %8.3f %10.2fx\n", "yours", ms, speedup);
+    k->bench_free(bench);
+
+    /* Speed is graded like a case: below bronze the kernel is correct but not solved. */
+    const char *tier = "none";
+    r.total++;
+    if (speedup >= k->speedup_target)                     { tier = "gold";   r.xp = c->xp_reward; }
+    else if (speedup >= (1.0 + k->speedup_target) / 2.0)  { tier = "silver"; r.xp = c->xp_reward * 3 / 4; }
+    else if (speedup >= 0.9)                               { tier = "bronze"; r.xp = c->xp_reward / 2; }
+    if (r.xp) r.passed++;
+    else if (visibility > 0) printf("  * Too slow: below 0.9x of the scalar reference\n");
+    printf("  speedup %.2fx (target %.1fx) -> tier %s\n", speedup, k->speedup_target, tier);
+    return r;
+}
+
 GradeResult challenges_grade(const Challenge *c, int visibility) {
-    GradeResult r = (GradeResult){0, 0};
+    GradeResult r = (GradeResult){0, 0, 0};
     if (!c) return r;
+    TraceSpan sp = trace_begin("grade", c->slug);
 
     if (c->sig == SIG_SUM_ARRAY) {
         fn_sum_array fn = (fn_sum_array)c->solution_fn;
@@ -38,6 +189,12 @@ GradeResult challenges_grade(const Challenge *c, int visibility) {
                 if (visibility > 1 && tc->hint) printf("    hint: %s\n", tc->hint);
             }
         }
+        if (r.passed == r.total) r.xp = c->xp_reward;
+    } else if (c->sig == SIG_PARALLEL_SUM || c->sig == SIG_PARALLEL_MAP) {
+        r = grade_parallel(c, visibility);
+    } else if (c->sig == SIG_SIMD_KERNEL) {
+        r = grade_kernel(c, visibility);
     }
+    trace_end(&sp);
     return r;
-}
\ No newline at end of file
+}
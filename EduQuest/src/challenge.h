@@ -2,11 +2,38 @@
 #define EDUQ_CHALLENGE_H
 #include <stddef.h>
 
-typedef enum { SIG_SUM_ARRAY = 1 } ChallengeSig;
+typedef enum { SIG_SUM_ARRAY = 1, SIG_PARALLEL_SUM, SIG_PARALLEL_MAP, SIG_SIMD_KERNEL } ChallengeSig;
 typedef int (*fn_sum_array)(const int *a, size_t n);
+typedef long long (*fn_parallel_sum)(const int *a, size_t n, int threads);
+typedef void (*fn_parallel_map)(const int *in, int *out, size_t n, int threads);
 
 typedef struct { const int *input; size_t n; int expected; const char *hint; } SumArrayCase;
 
+/* Scaling run for SIG_PARALLEL_*: timed at 1,2,4..max_threads (0 = online CPUs).
+   XP scales with the parallel efficiency reached at the largest thread count.
+   reference_fn has the challenge's signature and is called single-threaded. */
+typedef struct {
+    size_t n; int reps; int max_threads;
+    double eff_gold, eff_silver, eff_bronze;
+    void *reference_fn;
+    const char *hint;
+} ScalingSpec;
+
+/* SIG_SIMD_KERNEL: check() runs the correctness cases (returns passed, adds to *total),
+   then the bench_* hooks time the player against refs[] (scalar, SSE2, AVX2; NULL
+   when a variant does not exist). Full XP at speedup_target over the scalar ref;
+   below 0.9x the timing counts as a failed case, so the quest is not solved. */
+typedef struct {
+    int   (*check)(void *fn, int visibility, int *total);
+    void *(*bench_setup)(size_t n);
+    void  (*bench_run)(void *bench, void *fn);
+    void  (*bench_free)(void *bench);
+    void *refs[3];
+    size_t bench_n; int reps;
+    double speedup_target;
+    const char *hint;
+} KernelSpec;
+
 typedef struct Challenge {
     int id;
     const char *slug;
@@ -16,15 +43,17 @@ typedef struct Challenge {
     void *solution_fn;
     const SumArrayCase *cases;
     size_t case_count;
+    const ScalingSpec *scaling;
+    const KernelSpec *kernel;
     int xp_reward;
     int visibility;
 } Challenge;
 
-typedef struct { int passed, total; } GradeResult;
+typedef struct { int passed, total, xp; } GradeResult;
 
 void challenges_init(void);
 int  challenges_register(const Challenge *c);
 int  challenges_count(void);
 const Challenge* challenges_get(int idx);
 GradeResult challenges_grade(const Challenge *c, int visibility);
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,57 @@
+#include "challenge.h"
+#include "player_api.h"
+
+static long long ref_sum(const int *a, size_t n, int threads){
+    (void)threads;
+    long long acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += a[i];
+    return acc;
+}
+
+static void ref_collatz(const int *in, int *out, size_t n, int threads){
+    (void)threads;
+    for (size_t i = 0; i < n; ++i) out[i] = collatz_steps(in[i]);
+}
+
+/* Memory bound: expect good but not perfect scaling. */
+static const ScalingSpec SUM_SCALING = {
+    .n = 1u << 24, .reps = 5, .max_threads = 0,
+    .eff_gold = 0.70, .eff_silver = 0.50, .eff_bronze = 0.30,
+    .reference_fn = (void*)ref_sum,
+    .hint = "give each thread a contiguous slice and a private accumulator; combine after join",
+};
+
+/* Compute bound with uneven per-element cost: static slices leave threads idle. */
+static const ScalingSpec MAP_SCALING = {
+    .n = 1u << 20, .reps = 3, .max_threads = 0,
+    .eff_gold = 0.85, .eff_silver = 0.65, .eff_bronze = 0.40,
+    .reference_fn = (void*)ref_collatz,
+    .hint = "out[i] depends only on in[i]; hand out work in small chunks so no thread idles",
+};
+
+void register_content_pack_parallel(void){
+    static Challenge sumc = {
+        .slug="parallel.sum",
+        .name="Parallel Reduction",
+        .description="Implement parallel_sum(const int*, size_t, int threads) using exactly `threads` workers.\n"
+                     "Graded at 1,2,4..N threads for correctness and parallel efficiency.",
+        .sig=SIG_PARALLEL_SUM,
+        .solution_fn=(void*)parallel_sum,
+        .scaling=&SUM_SCALING,
+        .xp_reward=200,
+        .visibility=1,
+    };
+    static Challenge mapc = {
+        .slug="parallel.map",
+        .name="Parallel Map",
+        .description="Implement parallel_collatz(const int*, int*, size_t, int threads): out[i] = collatz_steps(in[i]).\n"
+                     "Graded at 1,2,4..N threads for correctness and parallel efficiency.",
+        .sig=SIG_PARALLEL_MAP,
+        .solution_fn=(void*)parallel_collatz,
+        .scaling=&MAP_SCALING,
+        .xp_reward=250,
+        .visibility=2,
+    };
+    challenges_register(&sumc);
+    challenges_register(&mapc);
+}
@@ -0,0 +1,4 @@
+#ifndef EDUQ_CONTENT_PARALLEL_H
+#define EDUQ_CONTENT_PARALLEL_H
+void register_content_pack_parallel(void);
+#endif
@@ -0,0 +1,253 @@
+#include "challenge.h"
+#include "player_api.h"
+#include "simd_ref.h"
+#include "cpu_features.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+typedef int     (*fn_sum_checked)(const int32_t *a, size_t n, int32_t *out);
+typedef int64_t (*fn_dot_i16)(const int16_t *a, const int16_t *b, size_t n);
+typedef void    (*fn_prefix_u32)(const uint32_t *in, uint32_t *out, size_t n);
+typedef size_t  (*fn_find_byte)(const uint8_t *s, size_t n, uint8_t c);
+typedef void    (*fn_histogram)(const uint8_t *s, size_t n, uint32_t hist[256]);
+
+/* Odd lengths and a one-element offset catch missing tails and aligned-load bugs. */
+static const size_t SIZES[] = {0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 100, 257, 1000};
+#define NSIZES (sizeof SIZES / sizeof SIZES[0])
+#define MAXN 1001
+
+static uint32_t g_seed;
+static uint32_t rnd(void){ g_seed = g_seed * 1103515245u + 12345u; return g_seed >> 8; }
+static uint32_t rnd32(void){ return (rnd() << 16) ^ rnd(); }
+
+static int report(int ok, int visibility, int *total, const char *what, size_t n){
+    (*total)++;
+    if (!ok && visibility > 0) printf("  * Case %d failed: %s (n=%zu)\n", *total, what, n);
+    return ok;
+}
+
+/* ---- sum with overflow detection ---- */
+
+static int check_sum(void *fn, int visibility, int *total){
+    fn_sum_checked f = (fn_sum_checked)fn;
+    static int32_t buf[MAXN];
+    int passed = 0;
+    g_seed = 1;
+    for (size_t k = 0; k < NSIZES; ++k) {
+        size_t n = SIZES[k];
+        for (size_t i = 0; i < n; ++i) buf[1 + i] = (int32_t)(rnd() % 2001) - 1000;
+        int32_t want = 0, got = 0;
+        int rw = ref_sum_checked_scalar(buf + 1, n, &want), rg = f(buf + 1, n, &got);
+        passed += report(rw == rg && (!rw || want == got), visibility, total, "sum mismatch", n);
+    }
+    static const int32_t OV1[] = {INT32_MAX, 1};
+    static const int32_t OV2[] = {INT32_MAX, 1, -1};
+    static const int32_t OV3[] = {INT32_MIN, -1};
+    struct { const int32_t *a; size_t n; const char *what; } sp[] = {
+        {OV1, 2, "INT32_MAX + 1 must report overflow"},
+        {OV2, 3, "intermediate overflow that cancels out must not report"},
+        {OV3, 2, "INT32_MIN - 1 must report overflow"},
+    };
+    for (size_t k = 0; k < sizeof sp / sizeof sp[0]; ++k) {
+        int32_t want = 0, got = 0;
+        int rw = ref_sum_checked_scalar(sp[k].a, sp[k].n, &want), rg = f(sp[k].a, sp[k].n, &got);
+        passed += report(rw == rg && (!rw || want == got), visibility, total, sp[k].what, sp[k].n);
+    }
+    for (size_t i = 0; i < 40; ++i) buf[i] = 100000000; /* overflows only once all lanes are folded */
+    int32_t want = 0, got = 0;
+    int rw = ref_sum_checked_scalar(buf, 40, &want), rg = f(buf, 40, &got);
+    passed += report(rw == rg, visibility, total, "overflow spread over many lanes", 40);
+    return passed;
+}
+
+/* ---- dot product ---- */
+
+static int16_t rnd_i16(void){ return (int16_t)((int32_t)(rnd() % 65535u) - 32767); }
+
+static int check_dot(void *fn, int visibility, int *total){
+    fn_dot_i16 f = (fn_dot_i16)fn;
+    static int16_t a[MAXN], b[MAXN];
+    int passed = 0;
+    g_seed = 2;
+    for (size_t k = 0; k < NSIZES; ++k) {
+        size_t n = SIZES[k];
+        for (size_t i = 0; i < n; ++i) { a[1 + i] = rnd_i16(); b[1 + i] = rnd_i16(); }
+        passed += report(ref_dot_i16_scalar(a + 1, b + 1, n) == f(a + 1, b + 1, n),
+                         visibility, total, "dot mismatch", n);
+    }
+    for (size_t i = 0; i < 1000; ++i) { a[i] = 32767; b[i] = (i & 1) ? 32767 : -32767; }
+    passed += report(ref_dot_i16_scalar(a, b, 999) == f(a, b, 999), visibility, total, "extreme products", 999);
+    return passed;
+}
+
+/* ---- prefix sum ---- */
+
+static int check_prefix(void *fn, int visibility, int *total){
+    fn_prefix_u32 f = (fn_prefix_u32)fn;
+    static uint32_t in[MAXN], want[MAXN], got[MAXN];
+    int passed = 0;
+    g_seed = 3;
+    for (size_t k = 0; k < NSIZES; ++k) {
+        size_t n = SIZES[k];
+        for (size_t i = 0; i < n; ++i) in[1 + i] = rnd32(); /* wraps: u32 arithmetic is modular */
+        ref_prefix_u32_scalar(in + 1, want, n);
+        memset(got, 0xAB, sizeof got);
+        f(in + 1, got + 1, n);
+        passed += report(n == 0 || memcmp(want, got + 1, n * sizeof *got) == 0,
+                         visibility, total, "prefix mismatch", n);
+    }
+    return passed;
+}
+
+/* ---- byte search ---- */
+
+static int check_find(void *fn, int visibility, int *total){
+    fn_find_byte f = (fn_find_byte)fn;
+    static uint8_t s[MAXN];
+    int passed = 0;
+    g_seed = 4;
+    for (size_t k = 0; k < NSIZES; ++k) {
+        size_t n = SIZES[k];
+        for (size_t i = 0; i < n; ++i) s[1 + i] = (uint8_t)('a' + rnd() % 26);
+        passed += report(f(s + 1, n, '#') == n, visibility, total, "absent byte must return n", n);
+        if (!n) continue;
+        size_t at = rnd() % n;
+        s[1 + at] = '#';
+        if (at + 1 < n) s[1 + n - 1] = '#'; /* a later duplicate must not win */
+        passed += report(f(s + 1, n, '#') == ref_find_byte_scalar(s + 1, n, '#'),
+                         visibility, total, "first occurrence", n);
+    }
+    for (size_t i = 0; i < 64; ++i) s[i] = 0x80;
+    passed += report(f(s, 64, 0x80) == 0, visibility, total, "high-bit byte", 64);
+    return passed;
+}
+
+/* ---- histogram ---- */
+
+static int check_hist(void *fn, int visibility, int *total){
+    fn_histogram f = (fn_histogram)fn;
+    static uint8_t s[MAXN];
+    uint32_t want[256], got[256];
+    int passed = 0;
+    g_seed = 5;
+    for (size_t k = 0; k < NSIZES; ++k) {
+        size_t n = SIZES[k];
+        for (size_t i = 0; i < n; ++i) s[1 + i] = (uint8_t)rnd();
+        ref_histogram_scalar(s + 1, n, want);
+        memset(got, 0xAB, sizeof got);
+        f(s + 1, n, got);
+        passed += report(memcmp(want, got, sizeof got) == 0, visibility, total, "histogram mismatch", n);
+    }
+    memset(s, 7, MAXN);
+    ref_histogram_scalar(s, MAXN, want);
+    f(s, MAXN, got);
+    passed += report(memcmp(want, got, sizeof got) == 0, visibility, total, "every byte in one bin", MAXN);
+    return passed;
+}
+
+/* ---- timed runs ---- */
+
+typedef struct { size_t n; void *a, *b, *out; int64_t sink; } Bench;
+
+static Bench *bench_alloc(size_t n, size_t esz, int two_in, int with_out){
+    Bench *b = (Bench*)calloc(1, sizeof *b);
+    if (!b) return NULL;
+    b->n = n;
+    b->a = malloc(n * esz);
+    b->b = two_in ? malloc(n * esz) : NULL;
+    b->out = with_out ? malloc(with_out > 1 ? 256 * sizeof(uint32_t) : n * esz) : NULL;
+    if (!b->a || (two_in && !b->b) || (with_out && !b->out)) { free(b->a); free(b->b); free(b->out); free(b); return NULL; }
+    return b;
+}
+
+static void bench_free(void *p){ Bench *b = (Bench*)p; if (!b) return; free(b->a); free(b->b); free(b->out); free(b); }
+
+static void *setup_sum(size_t n){
+    Bench *b = bench_alloc(n, sizeof(int32_t), 0, 0);
+    if (b) { g_seed = 11; for (size_t i = 0; i < n; ++i) ((int32_t*)b->a)[i] = (int32_t)(rnd() % 2001) - 1000; }
+    return b;
+}
+static void run_sum(void *p, void *fn){ Bench *b = p; int32_t s = 0; ((fn_sum_checked)fn)(b->a, b->n, &s); b->sink += s; }
+
+static void *setup_dot(size_t n){
+    Bench *b = bench_alloc(n, sizeof(int16_t), 1, 0);
+    if (b) { g_seed = 12; for (size_t i = 0; i < n; ++i) { ((int16_t*)b->a)[i] = rnd_i16(); ((int16_t*)b->b)[i] = rnd_i16(); } }
+    return b;
+}
+static void run_dot(void *p, void *fn){ Bench *b = p; b->sink += ((fn_dot_i16)fn)(b->a, b->b, b->n); }
+
+static void *setup_prefix(size_t n){
+    Bench *b = bench_alloc(n, sizeof(uint32_t), 0, 1);
+    if (b) { g_seed = 13; for (size_t i = 0; i < n; ++i) ((uint32_t*)b->a)[i] = rnd32(); }
+    return b;
+}
+static void run_prefix(void *p, void *fn){ Bench *b = p; ((fn_prefix_u32)fn)(b->a, b->out, b->n); b->sink += ((uint32_t*)b->out)[b->n - 1]; }
+
+static void *setup_find(size_t n){
+    Bench *b = bench_alloc(n, 1, 0, 0);
+    if (b) { g_seed = 14; for (size_t i = 0; i < n; ++i) ((uint8_t*)b->a)[i] = (uint8_t)('a' + rnd() % 26); ((uint8_t*)b->a)[n - 1] = '#'; }
+    return b;
+}
+static void run_find(void *p, void *fn){ Bench *b = p; b->sink += (int64_t)((fn_find_byte)fn)(b->a, b->n, '#'); }
+
+static void *setup_hist(size_t n){
+    Bench *b = bench_alloc(n, 1, 0, 2);
+    if (b) { g_seed = 15; for (size_t i = 0; i < n; ++i) ((uint8_t*)b->a)[i] = (uint8_t)(rnd() % 64); }
+    return b;
+}
+static void run_hist(void *p, void *fn){ Bench *b = p; ((fn_histogram)fn)(b->a, b->n, b->out); b->sink += ((uint32_t*)b->out)[0]; }
+
+#ifdef EDUQ_X86_DISPATCH
+  #define REFS(scalar, sse2, avx2) { (void*)(scalar), (void*)(sse2), (void*)(avx2) }
+#else
+  #define REFS(scalar, sse2, avx2) { (void*)(scalar), NULL, NULL }
+#endif
+
+static const KernelSpec K_SUM = {
+    check_sum, setup_sum, run_sum, bench_free,
+    REFS(ref_sum_checked_scalar, ref_sum_checked_sse2, ref_sum_checked_avx2),
+    1u << 22, 7, 2.5, "accumulate in 64-bit lanes and range-check once at the end",
+};
+static const KernelSpec K_DOT = {
+    check_dot, setup_dot, run_dot, bench_free,
+    REFS(ref_dot_i16_scalar, ref_dot_i16_sse2, ref_dot_i16_avx2),
+    1u << 22, 7, 3.0, "pmaddwd multiplies and pair-adds 16-bit lanes into 32-bit lanes",
+};
+static const KernelSpec K_PREFIX = {
+    check_prefix, setup_prefix, run_prefix, bench_free,
+    REFS(ref_prefix_u32_scalar, ref_prefix_u32_sse2, ref_prefix_u32_avx2),
+    1u << 22, 7, 1.25, "shift-and-add inside a register, then add the carried total",
+};
+static const KernelSpec K_FIND = {
+    check_find, setup_find, run_find, bench_free,
+    REFS(ref_find_byte_scalar, ref_find_byte_sse2, ref_find_byte_avx2),
+    1u << 24, 7, 4.0, "compare 16/32 bytes at once, movemask, count trailing zeros",
+};
+static const KernelSpec K_HIST = {
+    check_hist, setup_hist, run_hist, bench_free,
+    REFS(ref_histogram_scalar, NULL, NULL),
+    1u << 24, 7, 1.0, "no gather/scatter before AVX-512: a tight scalar loop is the bar to match",
+};
+
+void register_content_pack_simd(void){
+    static Challenge chals[] = {
+        { .slug="simd.sum_checked", .name="Vector Sum (overflow-checked)",
+          .description="Implement sum_checked(a, n, &out): 1 and the sum if it fits int32, else 0.",
+          .sig=SIG_SIMD_KERNEL, .solution_fn=(void*)sum_checked, .kernel=&K_SUM, .xp_reward=150, .visibility=2 },
+        { .slug="simd.dot", .name="Dot Product",
+          .description="Implement dot_i16(a, b, n) over int16 inputs in [-32767, 32767].",
+          .sig=SIG_SIMD_KERNEL, .solution_fn=(void*)dot_i16, .kernel=&K_DOT, .xp_reward=150, .visibility=2 },
+        { .slug="simd.prefix", .name="Prefix Sum",
+          .description="Implement prefix_sum_u32(in, out, n): out[i] = in[0] + ... + in[i] (mod 2^32).",
+          .sig=SIG_SIMD_KERNEL, .solution_fn=(void*)prefix_sum_u32, .kernel=&K_PREFIX, .xp_reward=200, .visibility=2 },
+        { .slug="simd.find_byte", .name="Byte Search",
+          .description="Implement find_byte(s, n, c): index of the first c, or n if absent.",
+          .sig=SIG_SIMD_KERNEL, .solution_fn=(void*)find_byte, .kernel=&K_FIND, .xp_reward=150, .visibility=2 },
+        { .slug="simd.histogram", .name="Byte Histogram",
+          .description="Implement histogram_u8(s, n, hist): hist[b] = count of byte b (hist is overwritten).",
+          .sig=SIG_SIMD_KERNEL, .solution_fn=(void*)histogram_u8, .kernel=&K_HIST, .xp_reward=200, .visibility=2 },
+    };
+    for (size_t i = 0; i < sizeof chals / sizeof chals[0]; ++i) challenges_register(&chals[i]);
+}
@@ -0,0 +1,4 @@
+#ifndef EDUQ_CONTENT_SIMD_H
+#define EDUQ_CONTENT_SIMD_H
+void register_content_pack_simd(void);
+#endif
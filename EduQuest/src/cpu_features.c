@@ -0,0 +1,19 @@
+#include "cpu_features.h"
+
+int cpu_has_sse2(void){
+#ifdef EDUQ_X86_DISPATCH
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    return 0;
+#endif
+}
+
+int cpu_has_avx2(void){
+#ifdef EDUQ_X86_DISPATCH
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
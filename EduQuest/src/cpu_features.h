@@ -0,0 +1,12 @@
+#ifndef EDUQ_CPU_FEATURES_H
+#define EDUQ_CPU_FEATURES_H
+
+/* x86 vector kernels are compiled per function with target attributes and
+   picked at runtime, so the binary still runs on CPUs without AVX2. */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define EDUQ_X86_DISPATCH 1
+#endif
+
+int cpu_has_sse2(void);
+int cpu_has_avx2(void);
+#endif
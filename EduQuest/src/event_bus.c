@@ -1,4 +1,5 @@
 #include "event_bus.h"
+#include "trace.h"
 
 void eventbus_init(EventBus *bus) { bus->count = 0; }
 
@@ -11,5 +12,7 @@ bool eventbus_subscribe(EventBus *bus, EventHandler h, void *user) {
 }
 
 void eventbus_publish(EventBus *bus, const Event *ev) {
+    TraceSpan sp = trace_begin("event.publish", NULL);
     for (size_t i = 0; i < bus->count; ++i) bus->handlers[i](ev, bus->user[i]);
+    trace_end(&sp);
 }
\ No newline at end of file
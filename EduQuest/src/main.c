@@ -5,6 +5,9 @@
 #include "analytics.h"
 #include "challenge.h"
 #include "content_arrays.h"
+#include "content_parallel.h"
+#include "content_simd.h"
+#include "trace.h"
 
 static EventBus G_BUS;
 static Profile  G_PROFILE;
@@ -33,7 +36,7 @@ static void ensure_profile_named(void){
 }
 
 static void overworld(void){
-    printf("\n[Overworld] Zones: Arrays (1) | Recursion (locked) | OOP (locked)\n");
+    printf("\n[Overworld] Zones: Arrays (1) | Concurrency (2) | Vectorization (3) | Recursion (locked) | OOP (locked)\n");
 }
 
 static void skill_tree(void){
@@ -70,12 +73,12 @@ static void enter_quest(void){
         GradeResult r = challenges_grade(c, c->visibility);
         printf("\nResult: %d/%d passed\n", r.passed, r.total);
         if (r.passed == r.total) {
-            printf("Reward: +%d XP\n", c->xp_reward);
+            printf("Reward: +%d XP\n", r.xp);
             int lvl_before = G_PROFILE.level;
-            G_PROFILE.xp += c->xp_reward;
+            G_PROFILE.xp += r.xp;
             G_PROFILE.level = xp_to_level(G_PROFILE.xp);
             G_PROFILE.challenges_solved += 1;
-            Event ev1 = { .type = EV_XP_GAIN, .i1 = c->xp_reward, .s1 = c->slug };
+            Event ev1 = { .type = EV_XP_GAIN, .i1 = r.xp, .s1 = c->slug };
             Event ev2 = { .type = EV_CHALLENGE_PASSED, .i1 = 1, .s1 = c->slug };
             eventbus_publish(&G_BUS, &ev1);
             eventbus_publish(&G_BUS, &ev2);
@@ -94,11 +97,11 @@ static void run_default_tests(void){
     GradeResult r = challenges_grade(c, c->visibility);
     printf("\nResult: %d/%d passed\n", r.passed, r.total);
     if (r.passed == r.total) {
-        printf("Reward: +%d XP\n", c->xp_reward);
-        G_PROFILE.xp += c->xp_reward;
+        printf("Reward: +%d XP\n", r.xp);
+        G_PROFILE.xp += r.xp;
         G_PROFILE.level = xp_to_level(G_PROFILE.xp);
         G_PROFILE.challenges_solved += 1;
-        Event ev1 = { .type = EV_XP_GAIN, .i1 = c->xp_reward, .s1 = c->slug };
+        Event ev1 = { .type = EV_XP_GAIN, .i1 = r.xp, .s1 = c->slug };
         eventbus_publish(&G_BUS, &ev1);
     }
 }
@@ -114,6 +117,7 @@ static void save_now(void){
 }
 
 int main(void){
+    trace_init();
     analytics_log_header_if_needed();
     eventbus_init(&G_BUS);
     eventbus_subscribe(&G_BUS, on_event, NULL);
@@ -123,6 +127,8 @@ int main(void){
 
     challenges_init();
     register_content_pack_arrays();
+    register_content_pack_parallel();
+    register_content_pack_simd();
 
     banner();
     printf("Welcome, %s. Type number and press Enter.\n", G_PROFILE.name);
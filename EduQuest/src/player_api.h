@@ -1,5 +1,25 @@
 #ifndef EDUQ_PLAYER_API_H
 #define EDUQ_PLAYER_API_H
 #include <stddef.h>
+#include <stdint.h>
 int sum_array(const int *a, size_t n);
-#endif 
\ No newline at end of file
+
+/* Concurrency zone: use exactly `threads` workers (threads >= 1). */
+long long parallel_sum(const int *a, size_t n, int threads);
+void parallel_collatz(const int *in, int *out, size_t n, int threads);
+
+/* Vectorization zone: graded for correctness, then speedup over a scalar baseline.
+   cpu_features.h has cpu_has_sse2()/cpu_has_avx2() for runtime dispatch. */
+int     sum_checked(const int32_t *a, size_t n, int32_t *out);
+int64_t dot_i16(const int16_t *a, const int16_t *b, size_t n);
+void    prefix_sum_u32(const uint32_t *in, uint32_t *out, size_t n);
+size_t  find_byte(const uint8_t *s, size_t n, uint8_t c);
+void    histogram_u8(const uint8_t *s, size_t n, uint32_t hist[256]);
+
+/* Steps for x (> 0) to reach 1 under the Collatz map; shared by player and grader. */
+static inline int collatz_steps(int x){
+    long long v = x; int s = 0;
+    while (v > 1) { v = (v & 1) ? 3 * v + 1 : v / 2; s++; }
+    return s;
+}
+#endif
@@ -2,6 +2,7 @@
 // file: src/save.c
 // =============================================
 #include "save.h"
+#include "trace.h"
 
 static void ensure_dir(const char *path){
 #ifdef _WIN32
@@ -33,10 +34,11 @@ char *get_save_path(char *buf,size_t n){ char d[512]; get_save_dir(d,sizeof d);
 char *get_analytics_path(char *buf,size_t n){ char d[512]; get_save_dir(d,sizeof d); snprintf(buf,n,"%s%canalytics.csv",d,PATH_SEP); return buf; }
 
 bool save_profile(const Profile *p) {
+    TraceSpan sp = trace_begin("save.profile", NULL);
     char path[512];
     get_save_path(path, sizeof path);
     FILE *f = fopen(path, "w");
-    if (!f) return false;
+    if (!f) { trace_end(&sp); return false; }
 
     fprintf(f, "name=%s\n", p->name);
     fprintf(f, "xp=%d\n", p->xp);
@@ -44,10 +46,12 @@ bool save_profile(const Profile *p) {
     fprintf(f, "solved=%d\n", p->challenges_solved);
 
     fclose(f);
+    trace_end(&sp);
     return true;
 }
 
 bool load_profile(Profile *p) {
+    TraceSpan sp = trace_begin("load.profile", NULL);
     memset(p, 0, sizeof *p);
     strncpy(p->name, "Adventurer", sizeof p->name - 1);
     p->xp = 0; p->level = 1; p->challenges_solved = 0;
@@ -55,7 +59,7 @@ bool load_profile(Profile *p) {
     char path[512];
     get_save_path(path, sizeof path);
     FILE *f = fopen(path, "r");
-    if (!f) return true;
+    if (!f) { trace_end(&sp); return true; }
 
     char line[256];
     while (fgets(line, sizeof line, f)) {
@@ -70,5 +74,6 @@ bool load_profile(Profile *p) {
     }
     fclose(f);
     p->level = xp_to_level(p->xp);
+    trace_end(&sp);
     return true;
 }
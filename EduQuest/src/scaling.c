@@ -0,0 +1,86 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "scaling.h"
+#include "trace.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef __linux__
+static cpu_set_t g_orig_mask;
+static int g_have_orig = 0;
+#endif
+
+int scaling_cpu_count(void){
+#ifdef __linux__
+    cpu_set_t m;
+    if (sched_getaffinity(0, sizeof m, &m) == 0) { int n = CPU_COUNT(&m); if (n > 0) return n; }
+#endif
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    long n = (long)si.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n > 0 ? (int)n : 1;
+}
+
+int scaling_thread_counts(int max, int *out, int cap){
+    int k = 0;
+    if (max < 1) max = 1;
+    for (int t = 1; t < max && k < cap - 1; t *= 2) out[k++] = t;
+    out[k++] = max;
+    return k;
+}
+
+void scaling_pin(int n){
+#ifdef __linux__
+    if (!g_have_orig) {
+        if (sched_getaffinity(0, sizeof g_orig_mask, &g_orig_mask) != 0) return;
+        g_have_orig = 1;
+    }
+    cpu_set_t m; CPU_ZERO(&m);
+    int taken = 0;
+    for (int c = 0; c < CPU_SETSIZE && taken < n; ++c)
+        if (CPU_ISSET(c, &g_orig_mask)) { CPU_SET(c, &m); taken++; }
+    // Why: threads inherit the creator's mask, so the player's workers stay on these CPUs.
+    if (taken) sched_setaffinity(0, sizeof m, &m);
+#else
+    (void)n;
+#endif
+}
+
+void scaling_unpin(void){
+#ifdef __linux__
+    if (g_have_orig) { sched_setaffinity(0, sizeof g_orig_mask, &g_orig_mask); g_have_orig = 0; }
+#endif
+}
+
+static double now_ms(void){
+    return (double)trace_now_ns() / 1e6; /* already portable: QPC on Windows */
+}
+
+double scaling_time_best(ScalingRunFn fn, void *ctx, int threads, int reps){
+    if (reps < 1) reps = 1;
+    TraceSpan sp = trace_begin("grade.timed_runs", NULL);
+    scaling_pin(threads);
+    fn(ctx, threads); /* warmup: page faults, thread stacks, caches */
+    double best = 0;
+    for (int r = 0; r < reps; ++r) {
+        double t0 = now_ms();
+        fn(ctx, threads);
+        double dt = now_ms() - t0;
+        // Why: the minimum is the run least disturbed by other load on the box.
+        if (r == 0 || dt < best) best = dt;
+    }
+    scaling_unpin();
+    trace_end(&sp);
+    return best;
+}
@@ -0,0 +1,19 @@
+#ifndef EDUQ_SCALING_H
+#define EDUQ_SCALING_H
+#include <stddef.h>
+
+#define SCALING_MAX_POINTS 16
+
+typedef void (*ScalingRunFn)(void *ctx, int threads);
+
+typedef struct { int threads; double best_ms, speedup, efficiency; } ScalingPoint;
+
+int    scaling_cpu_count(void);
+/* 1,2,4,... capped at max, always ending at max. Returns point count. */
+int    scaling_thread_counts(int max, int *out, int cap);
+/* Restrict the calling thread (and threads it spawns) to the first n allowed CPUs. */
+void   scaling_pin(int n);
+void   scaling_unpin(void);
+/* Best-of-reps wall time in ms after one warmup run, pinned to `threads` CPUs. */
+double scaling_time_best(ScalingRunFn fn, void *ctx, int threads, int reps);
+#endif
@@ -0,0 +1,167 @@
+#include "simd_ref.h"
+#include "cpu_features.h"
+#include <limits.h>
+#include <string.h>
+
+/* ---- scalar baselines ---- */
+
+int ref_sum_checked_scalar(const int32_t *a, size_t n, int32_t *out){
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += a[i];
+    if (acc > INT32_MAX || acc < INT32_MIN) return 0;
+    *out = (int32_t)acc;
+    return 1;
+}
+
+int64_t ref_dot_i16_scalar(const int16_t *a, const int16_t *b, size_t n){
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += (int32_t)a[i] * b[i];
+    return acc;
+}
+
+void ref_prefix_u32_scalar(const uint32_t *in, uint32_t *out, size_t n){
+    uint32_t run = 0;
+    for (size_t i = 0; i < n; ++i) { run += in[i]; out[i] = run; }
+}
+
+size_t ref_find_byte_scalar(const uint8_t *s, size_t n, uint8_t c){
+    for (size_t i = 0; i < n; ++i) if (s[i] == c) return i;
+    return n;
+}
+
+void ref_histogram_scalar(const uint8_t *s, size_t n, uint32_t hist[256]){
+    memset(hist, 0, 256 * sizeof *hist);
+    for (size_t i = 0; i < n; ++i) hist[s[i]]++;
+}
+
+#ifdef EDUQ_X86_DISPATCH
+#include <immintrin.h>
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+/* ---- SSE2 ---- */
+
+SSE2 int ref_sum_checked_sse2(const int32_t *a, size_t n, int32_t *out){
+    // Why: widen to 64-bit lanes so no partial sum can wrap before the final range check.
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), v);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    int64_t lanes[2]; _mm_storeu_si128((__m128i*)lanes, acc);
+    int64_t total = lanes[0] + lanes[1];
+    for (; i < n; ++i) total += a[i];
+    if (total > INT32_MAX || total < INT32_MIN) return 0;
+    *out = (int32_t)total;
+    return 1;
+}
+
+SSE2 int64_t ref_dot_i16_sse2(const int16_t *a, const int16_t *b, size_t n){
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i p = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + i)),
+                                   _mm_loadu_si128((const __m128i*)(b + i)));
+        __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), p);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(p, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(p, sign));
+    }
+    int64_t lanes[2]; _mm_storeu_si128((__m128i*)lanes, acc);
+    int64_t total = lanes[0] + lanes[1];
+    for (; i < n; ++i) total += (int32_t)a[i] * b[i];
+    return total;
+}
+
+SSE2 void ref_prefix_u32_sse2(const uint32_t *in, uint32_t *out, size_t n){
+    __m128i carry = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128((__m128i*)(out + i), x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    uint32_t run = (uint32_t)_mm_cvtsi128_si32(carry);
+    for (; i < n; ++i) { run += in[i]; out[i] = run; }
+}
+
+SSE2 size_t ref_find_byte_sse2(const uint8_t *s, size_t n, uint8_t c){
+    __m128i needle = _mm_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + i)), needle));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    for (; i < n; ++i) if (s[i] == c) return i;
+    return n;
+}
+
+/* ---- AVX2 ---- */
+
+AVX2 int ref_sum_checked_avx2(const int32_t *a, size_t n, int32_t *out){
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4]; _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) total += a[i];
+    if (total > INT32_MAX || total < INT32_MIN) return 0;
+    *out = (int32_t)total;
+    return 1;
+}
+
+AVX2 int64_t ref_dot_i16_avx2(const int16_t *a, const int16_t *b, size_t n){
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i p = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)));
+    }
+    int64_t lanes[4]; _mm256_storeu_si256((__m256i*)lanes, acc);
+    int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) total += (int32_t)a[i] * b[i];
+    return total;
+}
+
+AVX2 void ref_prefix_u32_avx2(const uint32_t *in, uint32_t *out, size_t n){
+    const __m256i low3 = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+    const __m256i hi_mask = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+    const __m256i last = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));   /* scans within each 128-bit lane */
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        x = _mm256_add_epi32(x, _mm256_and_si256(_mm256_permutevar8x32_epi32(x, low3), hi_mask));
+        x = _mm256_add_epi32(x, carry);
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+        carry = _mm256_permutevar8x32_epi32(x, last);
+    }
+    uint32_t run = (uint32_t)_mm256_cvtsi256_si32(carry);
+    for (; i < n; ++i) { run += in[i]; out[i] = run; }
+}
+
+AVX2 size_t ref_find_byte_avx2(const uint8_t *s, size_t n, uint8_t c){
+    __m256i needle = _mm256_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + i)), needle));
+        if (m) return i + (size_t)__builtin_ctz(m);
+    }
+    for (; i < n; ++i) if (s[i] == c) return i;
+    return n;
+}
+#endif /* EDUQ_X86_DISPATCH */
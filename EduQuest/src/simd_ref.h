@@ -0,0 +1,26 @@
+#ifndef EDUQ_SIMD_REF_H
+#define EDUQ_SIMD_REF_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* Reference kernels for the vectorization zone. Scalar versions define the
+   expected results; SSE2/AVX2 versions are only called when the CPU has them.
+   The histogram has no vector reference: without a scatter (AVX-512) none
+   measured faster than the scalar loop. */
+
+int     ref_sum_checked_scalar(const int32_t *a, size_t n, int32_t *out);
+int64_t ref_dot_i16_scalar(const int16_t *a, const int16_t *b, size_t n);
+void    ref_prefix_u32_scalar(const uint32_t *in, uint32_t *out, size_t n);
+size_t  ref_find_byte_scalar(const uint8_t *s, size_t n, uint8_t c);
+void    ref_histogram_scalar(const uint8_t *s, size_t n, uint32_t hist[256]);
+
+int     ref_sum_checked_sse2(const int32_t *a, size_t n, int32_t *out);
+int64_t ref_dot_i16_sse2(const int16_t *a, const int16_t *b, size_t n);
+void    ref_prefix_u32_sse2(const uint32_t *in, uint32_t *out, size_t n);
+size_t  ref_find_byte_sse2(const uint8_t *s, size_t n, uint8_t c);
+
+int     ref_sum_checked_avx2(const int32_t *a, size_t n, int32_t *out);
+int64_t ref_dot_i16_avx2(const int16_t *a, const int16_t *b, size_t n);
+void    ref_prefix_u32_avx2(const uint32_t *in, uint32_t *out, size_t n);
+size_t  ref_find_byte_avx2(const uint8_t *s, size_t n, uint8_t c);
+#endif
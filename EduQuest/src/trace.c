@@ -0,0 +1,100 @@
+#define _POSIX_C_SOURCE 200809L
+#include "common.h"
+#include "trace.h"
+#include <stdatomic.h>
+
+#define TRACE_CHUNK 4096
+
+typedef struct { const char *name, *detail; uint64_t t0, t1; } TraceEvent;
+
+typedef struct TraceChunk { struct TraceChunk *next; size_t len; TraceEvent ev[TRACE_CHUNK]; } TraceChunk;
+
+/* One buffer per thread, so recording never takes a lock. Buffers are pushed
+   onto a global list once, on the thread's first span, and read at exit. */
+typedef struct TraceBuf { struct TraceBuf *next; int tid; TraceChunk *head, *cur; } TraceBuf;
+
+int g_trace_on = 0;
+static char g_trace_path[512];
+static uint64_t g_trace_epoch;
+static _Atomic(TraceBuf*) g_bufs = NULL;
+static atomic_int g_next_tid = 1;
+static _Thread_local TraceBuf *t_buf;
+
+uint64_t trace_now_ns(void){
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f); QueryPerformanceCounter(&c);
+    return (uint64_t)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static TraceBuf *trace_thread_buf(void){
+    if (t_buf) return t_buf;
+    TraceBuf *b = (TraceBuf*)calloc(1, sizeof *b);
+    if (!b) return NULL;
+    b->tid = atomic_fetch_add(&g_next_tid, 1);
+    TraceBuf *old = atomic_load(&g_bufs);
+    do { b->next = old; } while (!atomic_compare_exchange_weak(&g_bufs, &old, b));
+    return t_buf = b;
+}
+
+void trace_record(const char *name, const char *detail, uint64_t t0, uint64_t t1){
+    TraceBuf *b = trace_thread_buf();
+    if (!b) return;
+    if (!b->cur || b->cur->len == TRACE_CHUNK) {
+        TraceChunk *c = (TraceChunk*)malloc(sizeof *c);
+        if (!c) return;
+        c->next = NULL; c->len = 0;
+        if (b->cur) b->cur->next = c; else b->head = c;
+        b->cur = c;
+    }
+    b->cur->ev[b->cur->len++] = (TraceEvent){ name, detail, t0, t1 };
+}
+
+static void put_json_str(FILE *f, const char *s){
+    fputc('"', f);
+    for (; s && *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') { fputc('\\', f); fputc(c, f); }
+        else if (c < 0x20) fprintf(f, "\\u%04x", c);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static void trace_dump(void){
+    g_trace_on = 0;
+    FILE *f = fopen(g_trace_path, "w");
+    if (!f) { LOG("trace: cannot write %s", g_trace_path); return; }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    size_t n = 0;
+    for (TraceBuf *b = atomic_load(&g_bufs); b; b = b->next) {
+        for (TraceChunk *c = b->head; c; c = c->next) {
+            for (size_t i = 0; i < c->len; ++i, ++n) {
+                const TraceEvent *e = &c->ev[i];
+                fputs(n ? ",\n{\"name\":" : "{\"name\":", f);
+                put_json_str(f, e->name);
+                fprintf(f, ",\"cat\":\"eduq\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+                        (double)(e->t0 - g_trace_epoch) / 1e3, (double)(e->t1 - e->t0) / 1e3, b->tid);
+                if (e->detail) { fputs(",\"args\":{\"detail\":", f); put_json_str(f, e->detail); fputc('}', f); }
+                fputc('}', f);
+            }
+        }
+    }
+    fputs("\n]}\n", f);
+    fclose(f);
+    LOG("trace: %zu spans written to %s", n, g_trace_path);
+}
+
+void trace_init(void){
+    const char *p = getenv("EDUQ_TRACE");
+    if (!p || !*p || strcmp(p, "0") == 0) return;
+    snprintf(g_trace_path, sizeof g_trace_path, "%s", strcmp(p, "1") == 0 ? "eduquest_trace.json" : p);
+    g_trace_epoch = trace_now_ns();
+    g_trace_on = 1;
+    atexit(trace_dump);
+}
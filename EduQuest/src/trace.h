@@ -0,0 +1,29 @@
+#ifndef EDUQ_TRACE_H
+#define EDUQ_TRACE_H
+#include <stdint.h>
+
+/* Span tracing. Off unless EDUQ_TRACE names an output file (EDUQ_TRACE=1 uses
+   eduquest_trace.json); the trace is written at exit in Chrome trace-event JSON
+   (load it in chrome://tracing or Perfetto). When off, a span costs one branch.
+
+   Usage:  TraceSpan sp = trace_begin("save", NULL);  ...  trace_end(&sp);
+   name/detail are stored by pointer and must stay valid until exit. */
+
+typedef struct { const char *name; const char *detail; uint64_t t0; } TraceSpan;
+
+extern int g_trace_on;
+
+void     trace_init(void);
+uint64_t trace_now_ns(void);
+void     trace_record(const char *name, const char *detail, uint64_t t0, uint64_t t1);
+
+static inline TraceSpan trace_begin(const char *name, const char *detail){
+    TraceSpan s = { name, detail, 0 };
+    if (g_trace_on) s.t0 = trace_now_ns();
+    return s;
+}
+
+static inline void trace_end(TraceSpan *s){
+    if (s->t0) trace_record(s->name, s->detail, s->t0, trace_now_ns());
+}
+#endif
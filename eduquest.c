@@ -3,10 +3,10 @@
 // ============================
 // Build (POSIX: Linux/macOS):
 //   cc -std=c17 -Wall -Wextra -O2 -o eduquest \
-//      src/*.c player/*.c
+//      -pthread src/*.c player/*.c
 //
 // Build (Windows, MSVC):
-//   cl /std:c17 /W4 /O2 /Fe:eduquest.exe src\*.c player\*.c
+//   cl /std:c17 /experimental:c11atomics /W4 /O2 /Fe:eduquest.exe src\*.c player\*.c
 //
 // Run:
 //   ./eduquest
@@ -15,5 +15,5 @@
 // - Edit player/player_solutions.c to implement solutions.
 // - Save files live in OS-appropriate user folders.
 // - Analytics logs to analytics.csv next to the save file.
-
-
+// - EDUQ_TRACE=trace.json ./eduquest writes a Chrome trace of grading,
+//   events, saves and analytics at exit (open in chrome://tracing).
@@ -1,7 +1,7 @@
 // # Pseudocode
 // - Define defaults: MIN=1, MAX=100, ATTEMPTS=10
 // - Read optional CLI args: [min max attempts]; validate order and ranges
-// - Seed RNG with current time
+// - Seed RNG with current time, or --seed S for a reproducible game
 // - Pick target = random integer in [min, max]
 // - For attempt from 1..attempts
 //   - Prompt: "Guess (min-max), attempt i of attempts: "
@@ -10,27 +10,64 @@
 //   - If guess == target -> print "Win" with attempts used, exit success
 //   - Else print hint: "Higher" if guess < target else "Lower"
 // - If loop ends -> print "Lose" and reveal target; exit with code 1
+// - --simulate GAMES: play headless games with a solver strategy on T threads,
+//   then report win rate, attempts distribution and the optimal-play bound
+// - --bench-rng [DRAWS]: time the shared RNG (rng.h) against rand()
+// - --serve: host many sessions over TCP/Unix socket with one epoll loop;
+//   --load: drive a server with concurrent bots, report sessions/s and latency
+//   (both need epoll, so they are only built on Linux)
+// - --test: self-checks (the server's handling of pipelined commands)
 
 // file: src/main.c
-// build: cc -std=c99 -O2 -Wall -Wextra -pedantic -o guess src/main.c
+// build: cc -std=c99 -O2 -Wall -Wextra -pedantic -pthread -o guess src/main.c
 // why-comments: Only explain non-obvious choices.
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <limits.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#include "rng.h"
 
 #define DEFAULT_MIN 1
 #define DEFAULT_MAX 100
 #define DEFAULT_ATTEMPTS 10
 
+#define SIM_MAX_THREADS 256
+#define SERVER_DEFAULT_PORT 7777
+
 static void usage(const char *prog) {
     fprintf(stderr,
-            "Usage: %s [min max attempts]\n"
-            "Defaults: min=%d max=%d attempts=%d\n",
-            prog, DEFAULT_MIN, DEFAULT_MAX, DEFAULT_ATTEMPTS);
+            "Usage: %s [--seed S] [min max attempts]\n"
+            "       %s --simulate GAMES [--strategy binary|random|adaptive] [--threads T]\n"
+            "          [--seed S] [min max attempts]\n"
+            "       %s --bench-rng [DRAWS]\n"
+            "       %s --serve [--tcp PORT] [--socket PATH] [--seed S] [min max attempts]\n"
+            "       %s --load [--tcp PORT | --socket PATH] [--sessions N] [--concurrency C]\n"
+            "          [--games G] [--threads T]\n"
+            "       %s --test\n"
+            "Defaults: min=%d max=%d attempts=%d, port %d\n",
+            prog, prog, prog, prog, prog, prog, DEFAULT_MIN, DEFAULT_MAX, DEFAULT_ATTEMPTS, SERVER_DEFAULT_PORT);
 }
 
 static int parse_long(const char *s, long *out) {
@@ -45,6 +82,53 @@ static int parse_long(const char *s, long *out) {
     return 1;
 }
 
+// Seeds are unsigned 64-bit; digits only, since strtoull would take "-5"
+// as 2^64 - 5 and skip leading spaces (as word_scramble does).
+static int parse_seed(const char *s, uint64_t *out) {
+    if (!s || *s < '0' || *s > '9') return 0;
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (errno != 0 || *end != '\0') return 0;
+    *out = (uint64_t)v;
+    return 1;
+}
+
+// Validates [min max attempts] from argv; returns 0 after printing why not.
+static int parse_game_args(char **argv, long *min, long *max, long *attempts) {
+    long tmin, tmax, tatt;
+    if (!parse_long(argv[0], &tmin) || !parse_long(argv[1], &tmax) || !parse_long(argv[2], &tatt)) {
+        fprintf(stderr, "Argument parsing failed.\n");
+        return 0;
+    }
+    if (tmin >= tmax) {
+        fprintf(stderr, "min must be < max.\n");
+        return 0;
+    }
+    if (tatt <= 0 || tatt > 100000) { // guard absurd values
+        fprintf(stderr, "attempts must be in 1..100000.\n");
+        return 0;
+    }
+    *min = tmin; *max = tmax; *attempts = tatt;
+    return 1;
+}
+
+enum { GUESS_OK, GUESS_NOT_INT, GUESS_OUT_OF_RANGE };
+
+// Shared by the terminal game and the server, so both reject the same input.
+static int check_guess(const char *s, long min, long max, long *out) {
+    long g;
+    if (!parse_long(s, &g)) return GUESS_NOT_INT;
+    if (g < min || g > max) return GUESS_OUT_OF_RANGE;
+    *out = g;
+    return GUESS_OK;
+}
+
+static void guess_error(int rc, long min, long max, char *buf, size_t n) {
+    if (rc == GUESS_NOT_INT) snprintf(buf, n, "Invalid input. Enter an integer.");
+    else snprintf(buf, n, "Out of range. Enter a value between %ld and %ld.", min, max);
+}
+
 static int read_guess(long min, long max, long *guess_out) {
     // Reads a line and validates bounds. Returns 1 if valid guess, 0 otherwise.
     char buf[128];
@@ -53,33 +137,1079 @@ static int read_guess(long min, long max, long *guess_out) {
     size_t len = strlen(buf);
     if (len && buf[len - 1] == '\n') buf[len - 1] = '\0';
 
-    long g;
-    if (!parse_long(buf, &g)) {
-        printf("Invalid input. Enter an integer.\n");
+    int rc = check_guess(buf, min, max, guess_out);
+    if (rc != GUESS_OK) {
+        char msg[96];
+        guess_error(rc, min, max, msg, sizeof msg);
+        printf("%s\n", msg);
         return 0;
     }
-    if (g < min || g > max) {
-        printf("Out of range. Enter a value between %ld and %ld.\n", min, max);
-        return 0;
-    }
-    *guess_out = g;
     return 1;
 }
 
-static long rand_inclusive(long min, long max) {
-    // Avoid modulo bias using 64-bit range mapping when possible.
+static long rand_inclusive(Rng *rng, long min, long max) {
+    // Offsets are unsigned so [LONG_MIN, LONG_MAX] works; its size wraps to 0,
+    // which rng_below takes as the full range.
+    return (long)((uint64_t)min + rng_below(rng, (uint64_t)max - (uint64_t)min + 1));
+}
+
+// ---- Simulation ----
+// Headless games against a solver. Ranges are handled as unsigned offsets from
+// min so that [LONG_MIN, LONG_MAX] does not overflow.
+
+enum { STRAT_BINARY, STRAT_RANDOM, STRAT_ADAPTIVE };
+static const char *const strategy_names[] = { "binary", "random", "adaptive" };
+
+typedef struct {
+    long min, max, attempts;
+    int strategy;
+    unsigned long long games;
+    Rng rng;
+    unsigned long long *hist; // [0] = lost, [t] = won on attempt t
+    pthread_t th;
+    int started;
+} SimJob;
+
+// Next guess, as an offset from lo, for the targets still possible in
+// [lo, lo + span] with `left` attempts to go.
+static uint64_t sim_guess(int strategy, uint64_t span, long left, Rng *rng) {
+    if (strategy == STRAT_RANDOM) return rng_below(rng, span + 1);
+    if (strategy == STRAT_ADAPTIVE) {
+        // While left attempts still cover the interval, any split leaving at
+        // most 2^(left-1)-1 on each side keeps the win certain: pick one at
+        // random. Otherwise nothing beats halving.
+        uint64_t side = left > 64 ? UINT64_MAX / 2 : (UINT64_C(1) << (left - 1)) - 1;
+        if (span / 2 <= side && span - span / 2 <= side) {
+            uint64_t first = span > side ? span - side : 0, last = span > side ? side : span;
+            return first + rng_below(rng, last - first + 1);
+        }
+    }
+    return span / 2;
+}
+
+static void *sim_worker(void *arg) {
+    SimJob *j = (SimJob *)arg;
+    Rng rng = j->rng;
+    uint64_t range = (uint64_t)j->max - (uint64_t)j->min; // size - 1
+    for (unsigned long long g = 0; g < j->games; ++g) {
+        uint64_t target = rng_below(&rng, range + 1), lo = 0, hi = range;
+        long turn = 1;
+        for (; turn <= j->attempts; ++turn) {
+            uint64_t guess = lo + sim_guess(j->strategy, hi - lo, j->attempts - turn + 1, &rng);
+            if (guess == target) break;
+            if (guess < target) lo = guess + 1;
+            else hi = guess - 1;
+        }
+        j->hist[turn <= j->attempts ? turn : 0]++;
+    }
+    return NULL;
+}
+
+// Best possible play: k guesses can tell apart at most 2^k - 1 targets (a
+// binary search tree of depth k), and a balanced tree also minimises the
+// mean attempts over the targets it reaches.
+static void print_optimal(long min, long max, long attempts) {
+    uint64_t span = (uint64_t)max - (uint64_t)min; // size - 1, so 2^64 targets still fit
+    uint64_t tree = attempts >= 64 ? UINT64_MAX : (UINT64_C(1) << attempts) - 1;
+    uint64_t reached = span < tree ? span + 1 : tree;
+    double n = (double)span + 1.0, left = n, depth_sum = 0, level = 1;
+    long worst = 0;
+    for (long d = 1; left > 0; ++d, level *= 2) {
+        double take = level < left ? level : left;
+        if (d <= attempts) depth_sum += take * (double)d;
+        left -= take;
+        worst = d;
+    }
+    printf("Optimal play: win rate %.3f%% (%llu of %.0f targets reachable), mean attempts on a win %.3f, "
+           "worst case %ld attempt%s\n",
+           100.0 * (double)reached / n, (unsigned long long)reached, n, depth_sum / (double)reached,
+           worst, worst == 1 ? "" : "s");
+}
+
+static int run_simulation(int argc, char **argv) {
+    long min = DEFAULT_MIN, max = DEFAULT_MAX, attempts = DEFAULT_ATTEMPTS, threads = sysconf(_SC_NPROCESSORS_ONLN);
+    long games_arg;
+    int strategy = STRAT_BINARY;
+    uint64_t seed = (uint64_t)time(NULL);
+    if (argc < 3 || !parse_long(argv[2], &games_arg) || games_arg <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    int i = 3;
+    for (; i + 1 < argc && argv[i][0] == '-' && argv[i][1] == '-'; i += 2) {
+        long v;
+        if (!strcmp(argv[i], "--strategy")) {
+            for (strategy = 0; strategy < 3 && strcmp(argv[i + 1], strategy_names[strategy]); ++strategy) {}
+            if (strategy == 3) { fprintf(stderr, "Unknown strategy: %s\n", argv[i + 1]); return 2; }
+        } else if (!strcmp(argv[i], "--threads") && parse_long(argv[i + 1], &v) && v >= 1 && v <= SIM_MAX_THREADS) {
+            threads = v;
+        } else if (strcmp(argv[i], "--seed") || !parse_seed(argv[i + 1], &seed)) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - i != 0 && argc - i != 3) { usage(argv[0]); return 2; }
+    if (argc - i == 3 && !parse_game_args(argv + i, &min, &max, &attempts)) return 2;
+    if (threads < 1) threads = 1;
+    if (threads > SIM_MAX_THREADS) threads = SIM_MAX_THREADS;
+    unsigned long long games = (unsigned long long)games_arg;
+    if ((unsigned long long)threads > games) threads = (long)games;
+
+    SimJob jobs[SIM_MAX_THREADS];
+    Rng stream;
+    rng_seed(&stream, seed);
+    // Everything is allocated before the first thread starts, so running out
+    // of memory never leaves a thread to join.
+    for (long t = 0; t < threads; ++t) {
+        SimJob *j = &jobs[t];
+        j->min = min; j->max = max; j->attempts = attempts; j->strategy = strategy;
+        j->games = games / (unsigned long long)threads + ((unsigned long long)t < games % (unsigned long long)threads);
+        j->rng = stream; // non-overlapping stream per thread, same results for the same seed
+        rng_jump(&stream);
+        j->hist = calloc((size_t)attempts + 1, sizeof *j->hist);
+        if (!j->hist) {
+            fprintf(stderr, "Out of memory.\n");
+            while (t-- > 0) free(jobs[t].hist);
+            return 1;
+        }
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long t = 0; t < threads; ++t) {
+        SimJob *j = &jobs[t];
+        j->started = t > 0 && pthread_create(&j->th, NULL, sim_worker, j) == 0;
+        if (t > 0 && !j->started) sim_worker(j);
+    }
+    sim_worker(&jobs[0]);
+    unsigned long long *hist = jobs[0].hist;
+    for (long t = 1; t < threads; ++t) {
+        if (jobs[t].started) pthread_join(jobs[t].th, NULL);
+        for (long a = 0; a <= attempts; ++a) hist[a] += jobs[t].hist[a];
+        free(jobs[t].hist);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    unsigned long long won = games - hist[0];
+    double turns = 0;
+    for (long a = 1; a <= attempts; ++a) turns += (double)hist[a] * (double)a;
+    printf("Simulated %llu games of [%ld..%ld] with %ld attempts, strategy %s, %ld thread%s, seed %llu\n",
+           games, min, max, attempts, strategy_names[strategy], threads, threads == 1 ? "" : "s",
+           (unsigned long long)seed);
+    printf("Time: %.3f s (%.2f M games/s)\n", secs, secs > 0 ? (double)games / secs / 1e6 : 0.0);
+    printf("Win rate: %.3f%% (%llu of %llu)\n", 100.0 * (double)won / (double)games, won, games);
+    if (won) printf("Mean attempts on a win: %.3f\n", turns / (double)won);
+    print_optimal(min, max, attempts);
+    printf("Attempts distribution:\n  attempt          games     share  cumulative\n");
+    unsigned long long cum = 0;
+    for (long a = 1; a <= attempts; ++a) {
+        if (!hist[a]) continue;
+        cum += hist[a];
+        printf("  %7ld  %13llu  %7.3f%%  %9.3f%%\n", a, hist[a],
+               100.0 * (double)hist[a] / (double)games, 100.0 * (double)cum / (double)games);
+    }
+    printf("  %7s  %13llu  %7.3f%%\n", "lost", hist[0], 100.0 * (double)hist[0] / (double)games);
+    free(hist);
+    return 0;
+}
+
+// ---- RNG benchmark ----
+
+// The generator the game used before rng.h: two rand() calls glued into one
+// wide value, rejection, then a modulo. Kept only to measure against.
+static long libc_inclusive(long min, long max) {
     unsigned long range = (unsigned long)(max - min + 1);
-    unsigned long limit = (ULONG_MAX / range) * range; // largest multiple <= ULONG_MAX
+    unsigned long limit = (ULONG_MAX / range) * range;
     unsigned long r;
     do {
-        // Compose a wide random from two rand() calls to improve entropy portability.
         unsigned long r1 = (unsigned long)rand();
         unsigned long r2 = (unsigned long)rand();
-        r = (r1 << (sizeof(int) * 4)) ^ r2; // mix bits; keeps it simple and portable
+        r = (r1 << (sizeof(int) * 4)) ^ r2;
     } while (r >= limit);
     return (long)(min + (r % range));
 }
 
+static double seconds_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void bench_row(const char *what, long draws, double libc_s, double rng_s) {
+    printf("  %-28s %9.2f %9.2f %8.1fx\n", what, libc_s * 1e9 / (double)draws, rng_s * 1e9 / (double)draws,
+           rng_s > 0 ? libc_s / rng_s : 0.0);
+}
+
+static int run_bench_rng(int argc, char **argv) {
+    long draws = 20000000;
+    if (argc > 3 || (argc == 3 && (!parse_long(argv[2], &draws) || draws <= 0))) {
+        usage(argv[0]);
+        return 2;
+    }
+    Rng rng;
+    rng_seed(&rng, 1);
+    srand(1);
+    struct timespec t0;
+    unsigned long long sink = 0; // printed, so no loop is optimised away
+    double a, b;
+
+    printf("RNG benchmark, %ld draws each (ns per draw)\n  %-28s %9s %9s %9s\n", draws, "", "rand()", "rng.h", "speedup");
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < draws; ++i) sink += (unsigned long long)rand();
+    a = seconds_since(&t0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < draws; ++i) sink += rng_next(&rng);
+    b = seconds_since(&t0);
+    bench_row("raw draw", draws, a, b);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < draws; ++i) sink += (unsigned long long)libc_inclusive(DEFAULT_MIN, DEFAULT_MAX);
+    a = seconds_since(&t0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < draws; ++i) sink += (unsigned long long)rand_inclusive(&rng, DEFAULT_MIN, DEFAULT_MAX);
+    b = seconds_since(&t0);
+    bench_row("target in [1..100]", draws, a, b);
+
+    char word[] = "algorithm";
+    size_t len = sizeof word - 1;
+    long shuffles = draws / (long)(len - 1) + 1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long n = 0; n < shuffles; ++n)
+        for (size_t i = len - 1; i > 0; ++sink, --i) {
+            size_t j = (size_t)(rand() % (int)(i + 1));
+            char tmp = word[i]; word[i] = word[j]; word[j] = tmp;
+        }
+    a = seconds_since(&t0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long n = 0; n < shuffles; ++n)
+        for (size_t i = len - 1; i > 0; ++sink, --i) {
+            size_t j = (size_t)rng_below(&rng, i + 1);
+            char tmp = word[i]; word[i] = word[j]; word[j] = tmp;
+        }
+    b = seconds_since(&t0);
+    bench_row("shuffle swap (scrambler)", shuffles * (long)(len - 1), a, b);
+
+    // rand() % n over n = 3/4 of rand()'s range: the low third of [0, n)
+    // is hit twice as often as it should be.
+    unsigned long n = ((unsigned long)RAND_MAX + 1) / 4 * 3, third = n / 3, low_libc = 0, low_rng = 0;
+    for (long i = 0; i < draws; ++i) {
+        low_libc += (unsigned long)rand() % n < third;
+        low_rng += rng_below(&rng, n) < third;
+    }
+    printf("Bias: draws in the low third of [0, %lu): rand() %% n %.3f%%, rng.h %.3f%% (unbiased 33.333%%)\n",
+           n, 100.0 * (double)low_libc / (double)draws, 100.0 * (double)low_rng / (double)draws);
+    printf("(checksum %llu %s)\n", sink, word);
+    return 0;
+}
+
+#ifdef __linux__
+// ---- Server ----
+// One process hosts many games over TCP on localhost or a Unix socket.
+// A single-threaded epoll loop drives every session. Sessions come from a
+// slab pool. Every command is one line and gets one reply line:
+//   on connect        HELLO min max attempts
+//   N | GUESS N       HIGHER left | LOWER left | WIN target used | LOSE target | ERR why
+//   NEW               GAME min max attempts
+//   STATS             this session's counters
+//   METRICS           the server's counters
+//   QUIT              BYE, then the connection closes
+
+#define SESSION_IN 128   // longest command line, as in read_guess
+#define SESSION_OUT 1024
+#define REPLY_MAX 320    // room kept free in out[] before a line is handled
+#define SLAB_CHUNK 256
+#define SERVER_EVENTS 256
+
+typedef struct Session {
+    int fd;
+    int closing;    // QUIT seen: close once out[] drains
+    int discarding; // inside an overlong line
+    int game_over;
+    int writing;    // waiting for EPOLLOUT, not reading
+    long target, turn;
+    size_t in_len, out_off, out_len;
+    unsigned long games, wins, losses, guesses, invalid;
+    struct timespec opened;
+    struct Session *next_free;
+    char in[SESSION_IN];
+    char out[SESSION_OUT];
+} Session;
+
+// Sessions are carved from chunks and recycled through a free list, so
+// thousands of connects and disconnects do not hit malloc each time.
+typedef struct SlabChunk {
+    struct SlabChunk *next;
+    Session s[SLAB_CHUNK];
+} SlabChunk;
+
+typedef struct {
+    SlabChunk *chunks;
+    Session *free;
+    size_t nchunks;
+} SessionSlab;
+
+typedef struct {
+    unsigned long open, peak;
+    unsigned long long sessions, games, wins, losses, guesses, invalid, bytes_in, bytes_out;
+    struct timespec started;
+} ServerMetrics;
+
+typedef struct {
+    long min, max, attempts;
+    Rng rng;
+    int ep;
+    int listen_fd[2]; // TCP, Unix; -1 if not used
+    const char *unix_path;
+    SessionSlab slab;
+    ServerMetrics m;
+} Server;
+
+static volatile sig_atomic_t server_stop;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    server_stop = 1;
+}
+
+static Session *slab_alloc(SessionSlab *sl) {
+    if (!sl->free) {
+        SlabChunk *c = malloc(sizeof *c);
+        if (!c) return NULL;
+        c->next = sl->chunks;
+        sl->chunks = c;
+        sl->nchunks++;
+        for (size_t i = SLAB_CHUNK; i-- > 0;) {
+            c->s[i].fd = -1;
+            c->s[i].next_free = sl->free;
+            sl->free = &c->s[i];
+        }
+    }
+    Session *s = sl->free;
+    sl->free = s->next_free;
+    return s;
+}
+
+static void slab_free(SessionSlab *sl, Session *s) {
+    s->fd = -1;
+    s->next_free = sl->free;
+    sl->free = s;
+}
+
+static void slab_destroy(SessionSlab *sl) {
+    while (sl->chunks) {
+        SlabChunk *next = sl->chunks->next;
+        free(sl->chunks);
+        sl->chunks = next;
+    }
+    sl->free = NULL;
+}
+
+static int set_nonblock(int fd) {
+    int fl = fcntl(fd, F_GETFL);
+    return fl >= 0 && fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+// Thousands of sessions need more descriptors than the usual soft limit.
+static void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static double seconds_between(const struct timespec *a, const struct timespec *b) {
+    return (double)(b->tv_sec - a->tv_sec) + (double)(b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static int listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0), one = 1;
+    if (fd < 0) return -1;
+    struct sockaddr_in a;
+    memset(&a, 0, sizeof a);
+    a.sin_family = AF_INET;
+    a.sin_port = htons((uint16_t)port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    if (bind(fd, (struct sockaddr *)&a, sizeof a) != 0 || listen(fd, SOMAXCONN) != 0 || !set_nonblock(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int unix_addr(const char *path, struct sockaddr_un *a) {
+    memset(a, 0, sizeof *a);
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof a->sun_path) return 0;
+    strcpy(a->sun_path, path);
+    return 1;
+}
+
+static int listen_unix(const char *path) {
+    struct sockaddr_un a;
+    if (!unix_addr(path, &a)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(path); // a stale socket from an earlier run
+    if (bind(fd, (struct sockaddr *)&a, sizeof a) != 0 || listen(fd, SOMAXCONN) != 0 || !set_nonblock(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void session_reply(Session *s, const char *fmt, ...) {
+    if (s->out_off == s->out_len) s->out_off = s->out_len = 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(s->out + s->out_len, SESSION_OUT - s->out_len - 1, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n > SESSION_OUT - s->out_len - 2) n = (int)(SESSION_OUT - s->out_len - 2);
+    s->out_len += (size_t)n;
+    s->out[s->out_len++] = '\n';
+}
+
+static void session_new_game(Server *srv, Session *s) {
+    s->target = rand_inclusive(&srv->rng, srv->min, srv->max);
+    s->turn = 0;
+    s->game_over = 0;
+    s->games++;
+    srv->m.games++;
+}
+
+static void session_guess(Server *srv, Session *s, const char *arg) {
+    if (s->game_over) {
+        session_reply(s, "ERR Game over. Send NEW to play again.");
+        return;
+    }
+    long g;
+    int rc = check_guess(arg, srv->min, srv->max, &g);
+    if (rc != GUESS_OK) {
+        // As in the terminal game, a bad guess does not use an attempt.
+        char msg[96];
+        guess_error(rc, srv->min, srv->max, msg, sizeof msg);
+        s->invalid++;
+        srv->m.invalid++;
+        session_reply(s, "ERR %s", msg);
+        return;
+    }
+    long turn = ++s->turn;
+    s->guesses++;
+    srv->m.guesses++;
+    if (g == s->target) {
+        s->game_over = 1;
+        s->wins++;
+        srv->m.wins++;
+        session_reply(s, "WIN %ld %ld", s->target, turn);
+    } else if (turn == srv->attempts) {
+        s->game_over = 1;
+        s->losses++;
+        srv->m.losses++;
+        session_reply(s, "LOSE %ld", s->target);
+    } else {
+        session_reply(s, "%s %ld", g < s->target ? "HIGHER" : "LOWER", srv->attempts - turn);
+    }
+}
+
+static void session_line(Server *srv, Session *s, char *line) {
+    size_t n = strlen(line);
+    if (n && line[n - 1] == '\r') line[n - 1] = '\0'; // telnet and nc -C
+    struct timespec now;
+    if (!strcmp(line, "QUIT")) {
+        session_reply(s, "BYE");
+        s->closing = 1;
+    } else if (!strcmp(line, "NEW")) {
+        session_new_game(srv, s);
+        session_reply(s, "GAME %ld %ld %ld", srv->min, srv->max, srv->attempts);
+    } else if (!strcmp(line, "STATS")) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        session_reply(s, "STATS games %lu wins %lu losses %lu guesses %lu invalid %lu age %.1f",
+                      s->games, s->wins, s->losses, s->guesses, s->invalid, seconds_between(&s->opened, &now));
+    } else if (!strcmp(line, "METRICS")) {
+        const ServerMetrics *m = &srv->m;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        session_reply(s, "METRICS open %lu peak %lu sessions %llu games %llu wins %llu losses %llu guesses %llu "
+                      "invalid %llu bytes_in %llu bytes_out %llu slab_chunks %zu uptime %.1f",
+                      m->open, m->peak, m->sessions, m->games, m->wins, m->losses, m->guesses, m->invalid,
+                      m->bytes_in, m->bytes_out, srv->slab.nchunks, seconds_between(&m->started, &now));
+    } else {
+        session_guess(srv, s, strncmp(line, "GUESS ", 6) ? line : line + 6);
+    }
+}
+
+// Handles the complete lines in in[] while out[] has room for their replies.
+static void session_process(Server *srv, Session *s) {
+    for (;;) {
+        char *nl = memchr(s->in, '\n', s->in_len);
+        if (!nl) {
+            if (s->in_len == SESSION_IN && !s->discarding) {
+                s->discarding = 1;
+                session_reply(s, "ERR Line too long.");
+            }
+            if (s->discarding) s->in_len = 0;
+            return;
+        }
+        if (s->closing || SESSION_OUT - s->out_len < REPLY_MAX) return;
+        *nl = '\0';
+        if (s->discarding) s->discarding = 0; // the tail of an overlong line
+        else session_line(srv, s, s->in);
+        size_t used = (size_t)(nl + 1 - s->in);
+        memmove(s->in, nl + 1, s->in_len - used);
+        s->in_len -= used;
+    }
+}
+
+// Returns 0 if the peer is gone.
+static int session_flush(Server *srv, Session *s) {
+    while (s->out_off < s->out_len) {
+        ssize_t n = send(s->fd, s->out + s->out_off, s->out_len - s->out_off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return 0;
+        s->out_off += (size_t)n;
+        srv->m.bytes_out += (unsigned long long)n;
+    }
+    if (s->out_off == s->out_len) s->out_off = s->out_len = 0;
+    else if (s->out_off > 0) {
+        memmove(s->out, s->out + s->out_off, s->out_len - s->out_off);
+        s->out_len -= s->out_off;
+        s->out_off = 0;
+    }
+    // Backpressure: a peer that does not read its replies is not read from.
+    int writing = s->out_len > 0;
+    if (writing != s->writing) {
+        struct epoll_event ev;
+        ev.events = writing ? EPOLLOUT : EPOLLIN;
+        ev.data.ptr = s;
+        if (epoll_ctl(srv->ep, EPOLL_CTL_MOD, s->fd, &ev) != 0) return 0;
+        s->writing = writing;
+    }
+    return !(s->closing && !writing);
+}
+
+static void session_close(Server *srv, Session *s) {
+    close(s->fd); // also drops it from the epoll set
+    srv->m.open--;
+    slab_free(&srv->slab, s);
+}
+
+// Starts a session on a connected socket and greets it; closes fd on failure.
+static void server_add(Server *srv, int fd) {
+    Session *s = set_nonblock(fd) ? slab_alloc(&srv->slab) : NULL;
+    if (!s) {
+        close(fd);
+        return;
+    }
+    memset(s, 0, offsetof(Session, next_free));
+    s->fd = fd;
+    clock_gettime(CLOCK_MONOTONIC, &s->opened);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = s;
+    if (epoll_ctl(srv->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        slab_free(&srv->slab, s);
+        return;
+    }
+    srv->m.open++;
+    srv->m.sessions++;
+    if (srv->m.open > srv->m.peak) srv->m.peak = srv->m.open;
+    session_new_game(srv, s);
+    session_reply(s, "HELLO %ld %ld %ld", srv->min, srv->max, srv->attempts);
+    if (!session_flush(srv, s)) session_close(srv, s);
+}
+
+static void server_accept(Server *srv, int lfd) {
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one); // fails harmlessly on Unix sockets
+        server_add(srv, fd);
+    }
+}
+
+static void server_event(Server *srv, Session *s, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP) && !(events & EPOLLIN)) {
+        session_close(srv, s);
+        return;
+    }
+    if (!s->writing && s->in_len < SESSION_IN) {
+        ssize_t n = read(s->fd, s->in + s->in_len, SESSION_IN - s->in_len);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) {
+            session_close(srv, s);
+            return;
+        }
+        s->in_len += (size_t)n;
+        srv->m.bytes_in += (unsigned long long)n;
+    }
+    // After a drain this also picks up lines that waited for reply room.
+    if (!session_flush(srv, s)) {
+        session_close(srv, s);
+        return;
+    }
+    // Pipelined lines can outlast one out[]; no new event comes for those
+    // already read, so go round while a flush leaves room for more.
+    do {
+        session_process(srv, s);
+        if (!session_flush(srv, s)) {
+            session_close(srv, s);
+            return;
+        }
+    } while (!s->writing && !s->closing && memchr(s->in, '\n', s->in_len));
+}
+
+static void server_report(const Server *srv) {
+    const ServerMetrics *m = &srv->m;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    printf("[Serve] %.1f s: %llu sessions (peak %lu open), %llu games, %llu wins, %llu losses, "
+           "%llu guesses, %llu invalid, %zu slab chunk%s\n",
+           seconds_between(&m->started, &now), m->sessions, m->peak, m->games, m->wins, m->losses,
+           m->guesses, m->invalid, srv->slab.nchunks, srv->slab.nchunks == 1 ? "" : "s");
+}
+
+static int run_server(int argc, char **argv) {
+    Server srv;
+    memset(&srv, 0, sizeof srv);
+    srv.min = DEFAULT_MIN; srv.max = DEFAULT_MAX; srv.attempts = DEFAULT_ATTEMPTS;
+    srv.listen_fd[0] = srv.listen_fd[1] = -1;
+    long port = -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    int i = 2;
+    for (; i + 1 < argc && argv[i][0] == '-' && argv[i][1] == '-'; i += 2) {
+        long v;
+        if (!strcmp(argv[i], "--tcp") && parse_long(argv[i + 1], &v) && v >= 0 && v <= 65535) port = v;
+        else if (!strcmp(argv[i], "--socket")) srv.unix_path = argv[i + 1];
+        else if (strcmp(argv[i], "--seed") || !parse_seed(argv[i + 1], &seed)) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - i != 0 && argc - i != 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (argc - i == 3 && !parse_game_args(argv + i, &srv.min, &srv.max, &srv.attempts)) return 2;
+    if (port < 0 && !srv.unix_path) port = SERVER_DEFAULT_PORT;
+    rng_seed(&srv.rng, seed);
+    raise_fd_limit();
+
+    if (port >= 0 && (srv.listen_fd[0] = listen_tcp((int)port)) < 0) {
+        perror("tcp listen");
+        return 1;
+    }
+    if (srv.unix_path && (srv.listen_fd[1] = listen_unix(srv.unix_path)) < 0) {
+        perror(srv.unix_path);
+        if (srv.listen_fd[0] >= 0) close(srv.listen_fd[0]);
+        return 1;
+    }
+    srv.ep = epoll_create1(EPOLL_CLOEXEC);
+    int ready = srv.ep >= 0;
+    for (int k = 0; k < 2 && ready; ++k) {
+        if (srv.listen_fd[k] < 0) continue;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &srv.listen_fd[k];
+        ready = epoll_ctl(srv.ep, EPOLL_CTL_ADD, srv.listen_fd[k], &ev) == 0;
+    }
+    if (!ready) {
+        perror("epoll");
+        for (int k = 0; k < 2; ++k)
+            if (srv.listen_fd[k] >= 0) close(srv.listen_fd[k]);
+        if (srv.unix_path) unlink(srv.unix_path);
+        if (srv.ep >= 0) close(srv.ep);
+        return 1;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = on_stop_signal; // no SA_RESTART: epoll_wait returns EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &srv.m.started);
+
+    printf("[Serve] range [%ld..%ld], %ld attempts, on", srv.min, srv.max, srv.attempts);
+    if (port >= 0) printf(" 127.0.0.1:%ld", port);
+    if (srv.unix_path) printf("%s %s", port >= 0 ? " and" : "", srv.unix_path);
+    printf("\n");
+    fflush(stdout);
+
+    struct epoll_event events[SERVER_EVENTS];
+    while (!server_stop) {
+        int n = epoll_wait(srv.ep, events, SERVER_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            void *p = events[k].data.ptr;
+            if (p == &srv.listen_fd[0] || p == &srv.listen_fd[1]) server_accept(&srv, *(int *)p);
+            else server_event(&srv, (Session *)p, events[k].events);
+        }
+    }
+
+    server_report(&srv);
+    for (SlabChunk *c = srv.slab.chunks; c; c = c->next)
+        for (size_t k = 0; k < SLAB_CHUNK; ++k)
+            if (c->s[k].fd >= 0) close(c->s[k].fd);
+    slab_destroy(&srv.slab);
+    for (int k = 0; k < 2; ++k)
+        if (srv.listen_fd[k] >= 0) close(srv.listen_fd[k]);
+    if (srv.unix_path) unlink(srv.unix_path);
+    close(srv.ep);
+    return 0;
+}
+
+// One session on a socketpair gets 60 commands in a single write, more
+// replies than out[] holds; each must be answered without further input.
+static int test_pipeline(void) {
+    Server srv;
+    memset(&srv, 0, sizeof srv);
+    srv.min = DEFAULT_MIN; srv.max = DEFAULT_MAX; srv.attempts = DEFAULT_ATTEMPTS;
+    srv.listen_fd[0] = srv.listen_fd[1] = -1;
+    rng_seed(&srv.rng, 1);
+    int sv[2], ok = 0;
+    srv.ep = epoll_create1(EPOLL_CLOEXEC);
+    if (srv.ep < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        if (srv.ep >= 0) close(srv.ep);
+        printf("Test: pipelined commands FAILED (setup)\n");
+        return 0;
+    }
+    server_add(&srv, sv[0]);
+    char cmds[120], buf[4096];
+    for (size_t k = 0; k < sizeof cmds; k += 2) memcpy(cmds + k, "x\n", 2);
+    long lines = 0, want = 1 + (long)(sizeof cmds / 2); // HELLO, then one reply each
+    if (set_nonblock(sv[1]) && send(sv[1], cmds, sizeof cmds, MSG_NOSIGNAL) == (ssize_t)sizeof cmds) {
+        struct epoll_event events[4];
+        int n;
+        while (lines < want && (n = epoll_wait(srv.ep, events, 4, 1000)) > 0) {
+            for (int k = 0; k < n; ++k) server_event(&srv, (Session *)events[k].data.ptr, events[k].events);
+            ssize_t r;
+            while ((r = read(sv[1], buf, sizeof buf)) > 0)
+                for (ssize_t k = 0; k < r; ++k) lines += buf[k] == '\n';
+        }
+        ok = lines == want;
+    }
+    printf("Test: pipelined commands %s (%ld of %ld replies)\n", ok ? "OK" : "FAILED", lines, want);
+    for (SlabChunk *c = srv.slab.chunks; c; c = c->next)
+        for (size_t k = 0; k < SLAB_CHUNK; ++k)
+            if (c->s[k].fd >= 0) close(c->s[k].fd);
+    slab_destroy(&srv.slab);
+    close(sv[1]);
+    close(srv.ep);
+    return ok;
+}
+
+// ---- Load generator ----
+// T threads, each with its own epoll loop, keep C sessions open between them
+// and play binary-search games until N sessions have finished. Every guess's
+// round trip goes into a log-linear histogram (16 steps per power of two,
+// within about 6%), so memory stays fixed however long the run.
+
+#define LAT_SUB 16
+#define LAT_BUCKETS (64 * LAT_SUB)
+
+enum { LOAD_HELLO, LOAD_PLAY, LOAD_GAME };
+
+typedef struct {
+    int fd, state;
+    long games_left, lo, hi, guess;
+    size_t len;
+    struct timespec sent;
+    char buf[256];
+} LoadConn;
+
+typedef struct {
+    long port;
+    const char *unix_path;
+    long sessions, concurrency, games;
+    long launched;
+    unsigned long long done, failed, wins, losses, guesses;
+    unsigned long long lat[LAT_BUCKETS];
+    pthread_t th;
+    int started;
+} LoadJob;
+
+static size_t lat_bucket(uint64_t ns) {
+    if (ns < LAT_SUB) return (size_t)ns;
+    int e = 4;
+    while (e < 63 && ns >> (e + 1)) ++e;
+    return (size_t)(e - 3) * LAT_SUB + (size_t)((ns >> (e - 4)) & (LAT_SUB - 1));
+}
+
+// Upper end of a bucket, in ns.
+static double lat_value(size_t b) {
+    if (b < LAT_SUB) return (double)b;
+    double v = (double)(LAT_SUB + b % LAT_SUB + 1);
+    for (size_t e = b / LAT_SUB; e > 1; --e) v *= 2;
+    return v - 1;
+}
+
+static int load_connect(const LoadJob *j) {
+    int fd;
+    if (j->unix_path) {
+        struct sockaddr_un a;
+        if (!unix_addr(j->unix_path, &a) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+        if (connect(fd, (struct sockaddr *)&a, sizeof a) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_in a;
+        memset(&a, 0, sizeof a);
+        a.sin_family = AF_INET;
+        a.sin_port = htons((uint16_t)j->port);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int one = 1;
+        if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) return -1;
+        if (connect(fd, (struct sockaddr *)&a, sizeof a) != 0) {
+            close(fd);
+            return -1;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    }
+    if (!set_nonblock(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int load_send(LoadConn *c, const char *line) {
+    size_t n = strlen(line);
+    clock_gettime(CLOCK_MONOTONIC, &c->sent);
+    return send(c->fd, line, n, MSG_NOSIGNAL) == (ssize_t)n; // a few bytes always fit
+}
+
+static int load_guess(LoadConn *c) {
+    char line[32];
+    c->guess = (long)((uint64_t)c->lo + ((uint64_t)c->hi - (uint64_t)c->lo) / 2);
+    snprintf(line, sizeof line, "%ld\n", c->guess);
+    return load_send(c, line);
+}
+
+// Opens the next session into c; 0 once the job has launched them all.
+static int load_open(LoadJob *j, int ep, LoadConn *c) {
+    while (j->launched < j->sessions) {
+        j->launched++;
+        memset(c, 0, sizeof *c);
+        c->games_left = j->games;
+        if ((c->fd = load_connect(j)) >= 0) {
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = c;
+            if (epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev) == 0) return 1;
+            close(c->fd);
+        }
+        j->failed++;
+    }
+    c->fd = -1;
+    return 0;
+}
+
+static int load_fail(LoadJob *j) {
+    j->failed++;
+    return 0;
+}
+
+// One reply line; returns 0 when the session is over, well or not.
+static int load_line(LoadJob *j, LoadConn *c, const char *line) {
+    long a, b, k;
+    if (c->state != LOAD_PLAY) {
+        const char *want = c->state == LOAD_HELLO ? "HELLO %ld %ld %ld" : "GAME %ld %ld %ld";
+        if (sscanf(line, want, &a, &b, &k) != 3) return load_fail(j);
+        c->lo = a; c->hi = b;
+        c->state = LOAD_PLAY;
+        return load_guess(c) || load_fail(j);
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ns = (int64_t)(now.tv_sec - c->sent.tv_sec) * 1000000000 + (now.tv_nsec - c->sent.tv_nsec);
+    j->lat[lat_bucket(ns > 0 ? (uint64_t)ns : 0)]++;
+    j->guesses++;
+    if (!strncmp(line, "HIGHER", 6)) c->lo = c->guess + 1;
+    else if (!strncmp(line, "LOWER", 5)) c->hi = c->guess - 1;
+    else if (!strncmp(line, "WIN", 3) || !strncmp(line, "LOSE", 4)) {
+        if (line[0] == 'W') j->wins++;
+        else j->losses++;
+        if (--c->games_left > 0) {
+            c->state = LOAD_GAME;
+            return load_send(c, "NEW\n") || load_fail(j);
+        }
+        j->done++;
+        return 0;
+    } else {
+        return load_fail(j);
+    }
+    return load_guess(c) || load_fail(j);
+}
+
+static void *load_worker(void *arg) {
+    LoadJob *j = (LoadJob *)arg;
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    LoadConn *conns = calloc((size_t)j->concurrency, sizeof *conns);
+    if (ep < 0 || !conns) {
+        j->failed += (unsigned long long)j->sessions;
+        free(conns);
+        if (ep >= 0) close(ep);
+        return NULL;
+    }
+    long active = 0;
+    for (long i = 0; i < j->concurrency; ++i) active += load_open(j, ep, &conns[i]);
+    struct epoll_event events[SERVER_EVENTS];
+    while (active > 0) {
+        int n = epoll_wait(ep, events, SERVER_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            for (long i = 0; i < j->concurrency; ++i)
+                if (conns[i].fd >= 0) close(conns[i].fd);
+            // The open sessions and those never launched all count as failed.
+            j->failed += (unsigned long long)(active + j->sessions - j->launched);
+            j->launched = j->sessions;
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            LoadConn *c = (LoadConn *)events[k].data.ptr;
+            ssize_t r = read(c->fd, c->buf + c->len, sizeof c->buf - 1 - c->len);
+            if (r < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            int alive = r > 0;
+            if (!alive) j->failed++;
+            c->len += r > 0 ? (size_t)r : 0;
+            char *nl;
+            while (alive && (nl = memchr(c->buf, '\n', c->len))) {
+                *nl = '\0';
+                alive = load_line(j, c, c->buf);
+                size_t used = (size_t)(nl + 1 - c->buf);
+                memmove(c->buf, nl + 1, c->len - used);
+                c->len -= used;
+            }
+            if (alive && c->len == sizeof c->buf - 1) {
+                j->failed++;
+                alive = 0;
+            }
+            if (!alive) {
+                close(c->fd);
+                active -= !load_open(j, ep, c);
+            }
+        }
+    }
+    free(conns);
+    close(ep);
+    return NULL;
+}
+
+static int run_load(int argc, char **argv) {
+    long port = SERVER_DEFAULT_PORT, sessions = 10000, concurrency = 1000, games = 1;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *unix_path = NULL;
+    for (int i = 2; i < argc; i += 2) {
+        long v = 0;
+        int num = i + 1 < argc && parse_long(argv[i + 1], &v) && v >= 1;
+        if (i + 1 < argc && !strcmp(argv[i], "--socket")) unix_path = argv[i + 1];
+        else if (num && !strcmp(argv[i], "--tcp") && v <= 65535) port = v;
+        else if (num && !strcmp(argv[i], "--sessions")) sessions = v;
+        else if (num && !strcmp(argv[i], "--concurrency")) concurrency = v;
+        else if (num && !strcmp(argv[i], "--games")) games = v;
+        else if (num && !strcmp(argv[i], "--threads") && v <= SIM_MAX_THREADS) threads = v;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (concurrency > sessions) concurrency = sessions;
+    if (threads < 1) threads = 1;
+    if (threads > SIM_MAX_THREADS) threads = SIM_MAX_THREADS;
+    if (threads > concurrency) threads = concurrency;
+    raise_fd_limit();
+
+    LoadJob *jobs = calloc((size_t)threads, sizeof *jobs);
+    if (!jobs) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long t = 0; t < threads; ++t) {
+        LoadJob *j = &jobs[t];
+        j->port = port;
+        j->unix_path = unix_path;
+        j->games = games;
+        j->sessions = sessions / threads + (t < sessions % threads);
+        j->concurrency = concurrency / threads + (t < concurrency % threads);
+        j->started = pthread_create(&j->th, NULL, load_worker, j) == 0;
+        if (!j->started) load_worker(j);
+    }
+    unsigned long long done = 0, failed = 0, wins = 0, losses = 0, guesses = 0, total = 0;
+    unsigned long long *lat = jobs[0].lat;
+    for (long t = 0; t < threads; ++t) {
+        LoadJob *j = &jobs[t];
+        if (j->started) pthread_join(j->th, NULL);
+        done += j->done; failed += j->failed; wins += j->wins; losses += j->losses; guesses += j->guesses;
+        if (t > 0)
+            for (size_t b = 0; b < LAT_BUCKETS; ++b) lat[b] += j->lat[b];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = seconds_between(&t0, &t1);
+    for (size_t b = 0; b < LAT_BUCKETS; ++b) total += lat[b];
+
+    printf("Load: %lu sessions of %ld game%s at concurrency %ld on %ld thread%s against %s",
+           (unsigned long)sessions, games, games == 1 ? "" : "s", concurrency, threads, threads == 1 ? "" : "s",
+           unix_path ? unix_path : "127.0.0.1:");
+    if (!unix_path) printf("%ld", port);
+    printf("\nTime: %.3f s, %.0f sessions/s, %.0f guesses/s\n", secs, secs > 0 ? (double)done / secs : 0.0,
+           secs > 0 ? (double)guesses / secs : 0.0);
+    printf("Sessions: %llu finished, %llu failed; games: %llu won, %llu lost\n", done, failed, wins, losses);
+    if (total) {
+        static const double pct[] = { 50, 90, 99, 99.9 };
+        unsigned long long seen = 0;
+        size_t b = 0, last = 0;
+        printf("Guess latency (us):");
+        for (size_t p = 0; p < sizeof pct / sizeof *pct; ++p) {
+            unsigned long long rank = (unsigned long long)((double)total * pct[p] / 100.0 + 0.5);
+            if (rank < 1) rank = 1;
+            while (seen < rank) seen += lat[b++];
+            printf(" p%g %.1f", pct[p], lat_value(b - 1) / 1000.0);
+        }
+        for (size_t k = 0; k < LAT_BUCKETS; ++k)
+            if (lat[k]) last = k;
+        printf(" max %.1f\n", lat_value(last) / 1000.0);
+    }
+    free(jobs);
+    return failed ? 1 : 0;
+}
+#else
+static int run_server(int argc, char **argv) {
+    (void)argc;
+    fprintf(stderr, "%s --serve needs epoll (Linux)\n", argv[0]);
+    return 1;
+}
+
+static int run_load(int argc, char **argv) {
+    (void)argc;
+    fprintf(stderr, "%s --load needs epoll (Linux)\n", argv[0]);
+    return 1;
+}
+#endif
+
+static int run_tests(void) {
+    int ok = 1;
+#ifdef __linux__
+    ok &= test_pipeline();
+#endif
+    return ok ? 0 : 1;
+}
+
 int main(int argc, char **argv) {
     long min = DEFAULT_MIN;
     long max = DEFAULT_MAX;
@@ -90,34 +1220,37 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    if (argc >= 2) {
-        if (argc < 4 || argc > 4) {
+    if (argc >= 2 && !strcmp(argv[1], "--simulate")) return run_simulation(argc, argv);
+    if (argc >= 2 && !strcmp(argv[1], "--bench-rng")) return run_bench_rng(argc, argv);
+    if (argc >= 2 && !strcmp(argv[1], "--serve")) return run_server(argc, argv);
+    if (argc >= 2 && !strcmp(argv[1], "--load")) return run_load(argc, argv);
+    if (argc == 2 && !strcmp(argv[1], "--test")) return run_tests();
+
+    // Seed once per process using high-resolution time, unless given one.
+    // clock_gettime rather than C11 timespec_get: the build is -std=c99.
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    int arg = 1;
+    if (argc >= 2 && !strcmp(argv[1], "--seed")) {
+        if (argc < 3 || !parse_seed(argv[2], &seed)) {
             usage(argv[0]);
             return 2;
         }
-        long tmin, tmax, tatt;
-        if (!parse_long(argv[1], &tmin) || !parse_long(argv[2], &tmax) || !parse_long(argv[3], &tatt)) {
-            fprintf(stderr, "Argument parsing failed.\n");
-            return 2;
-        }
-        if (tmin >= tmax) {
-            fprintf(stderr, "min must be < max.\n");
-            return 2;
-        }
-        if (tatt <= 0 || tatt > 100000) { // guard absurd values
-            fprintf(stderr, "attempts must be in 1..100000.\n");
+        arg = 3;
+    }
+
+    if (argc > arg) {
+        if (argc - arg != 3) {
+            usage(argv[0]);
             return 2;
         }
-        min = tmin; max = tmax; attempts = tatt;
+        if (!parse_game_args(argv + arg, &min, &max, &attempts)) return 2;
     }
 
-    // Seed once per process using high-resolution time.
-    struct timespec ts;
-    timespec_get(&ts, TIME_UTC);
-    unsigned int seed = (unsigned int)(ts.tv_nsec ^ ts.tv_sec);
-    srand(seed);
-
-    long target = rand_inclusive(min, max);
+    Rng rng;
+    rng_seed(&rng, seed);
+    long target = rand_inclusive(&rng, min, max);
 
     printf("Target picked. Range [%ld..%ld]. Attempts: %ld.\n", min, max, attempts);
 
@@ -0,0 +1,91 @@
+// file: rng.h
+// Small seedable PRNG shared by the games: xoshiro256** (Blackman & Vigna)
+// with Lemire's nearly-divisionless bounded sampling. Header-only; every
+// function is static inline, so unused ones cost nothing.
+// why-comments: Only explain non-obvious choices.
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+// Also used to expand one 64-bit seed into the 256-bit state: it never
+// yields the all-zero state xoshiro cannot leave.
+static inline uint64_t rng_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline void rng_seed(Rng *r, uint64_t seed) {
+    for (int i = 0; i < 4; ++i) r->s[i] = rng_splitmix64(&seed);
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t out = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return out;
+}
+
+// Advances by 2^128 draws: call it t times on copies of one seeded state to
+// get t streams that never overlap (one per thread).
+static inline void rng_jump(Rng *r) {
+    static const uint64_t jump[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                      0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; ++i)
+        for (int b = 0; b < 64; ++b) {
+            if (jump[i] & (UINT64_C(1) << b))
+                for (int k = 0; k < 4; ++k) t[k] ^= r->s[k];
+            rng_next(r);
+        }
+    for (int k = 0; k < 4; ++k) r->s[k] = t[k];
+}
+
+// Full 64x64 -> 128-bit product, high half returned, low half in *lo.
+static inline uint64_t rng_mul128(uint64_t a, uint64_t b, uint64_t *lo) {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 u128;
+    u128 m = (u128)a * b;
+    *lo = (uint64_t)m;
+    return (uint64_t)(m >> 64);
+#else
+    uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    *lo = (mid << 32) | (uint32_t)p00;
+    return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+// Uniform in [0, n), without modulo bias; n == 0 means the full 64-bit range.
+// Lemire's method: the high half of x * n is the answer, and the division
+// that finds the rejection threshold only runs when the low half lands in
+// the first n values, which is rare unless n is huge.
+static inline uint64_t rng_below(Rng *r, uint64_t n) {
+    if (n == 0) return rng_next(r);
+    uint64_t lo, hi = rng_mul128(rng_next(r), n, &lo);
+    if (lo < n) {
+        uint64_t threshold = (0 - n) % n; // 2^64 mod n
+        while (lo < threshold) hi = rng_mul128(rng_next(r), n, &lo);
+    }
+    return hi;
+}
+
+#endif // RNG_H
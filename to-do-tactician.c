@@ -1,24 +1,64 @@
 // filepath: src/todo.c
-// Build: gcc -std=c99 -O2 -Wall -Wextra -o todo src/todo.c
-// Usage: ./todo [tasks.json]   or   ./todo --test
+// Build: gcc -std=c99 -O2 -Wall -Wextra -pthread -o todo src/todo.c
+//        (add -DHAVE_ZLIB -lz for gzip-compressed stores: tasks.json.gz)
+// Usage: ./todo [tasks.json | tasks.tdb]   or   ./todo --test   or   ./todo --convert IN OUT
+//        ./todo --bench N [--reps R] [--seed S]     (JSON timing report on a generated list)
+//        ./todo query [file] [--due-before D] [--min-priority P] [--open] [--sort due|priority]
+//                            [--limit K] [--format table|json|tsv]
+//        ./todo agenda [file] [--days N | --overdue] [--limit K] [--format table|json|tsv]
+//        ./todo bulk [file] done|delete|priority P|shift DAYS [--due-before D] [--min-priority P]
+//                           [--open|--done] [--match TEXT] [--all]
+//        ./todo shards DIR import FILE | list | add TITLE ... | done ID | delete ID | query ...
+//                                                     (one store per #project, opened on demand)
+//        ./todo serve [file] [--socket PATH]          (daemon; socket defaults to <file>.sock)
+//        ./todo client [--socket PATH] add|update|done|delete|get|next|agenda|overdue|query|search ...
 //
 // Pseudocode plan:
 // 1) Define Task and TaskList. Provide init, push, delete, find, next_id.
 // 2) Implement minimal JSON tokenizer+parser for [ {"id":..,"title":"..","due":"YYYY-MM-DD","priority":..,"done":..}, ... ].
 //    - parse strings with escapes, ints, booleans, arrays, and objects.
 //    - writer emits pretty JSON, escaping necessary characters.
-// 3) IO: load_tasks(file)->TaskList; save_tasks(file, TaskList).
+// 3) IO: load_tasks(file)->TaskList; save_tasks(file, TaskList). A *.tdb path is saved as a binary
+//    snapshot that loads by mmap instead of parsing; load_tasks recognises either format.
 // 4) Validation: non-empty title, date YYYY-MM-DD and valid calendar day, priority in [1,5].
 // 5) Sorting & filtering: by due date asc or priority desc; optional filter by due-before and min-priority and completion.
 // 6) Pretty table output with fixed widths and truncation.
-// 7) Menu loop: add, list, update, delete, save, quit. Autosave on quit.
+// 7) Menu loop: add, list, update, delete, save, quit, search, next (most urgent open tasks),
+//    agenda (due in the next week) and overdue. Edits are journaled to <file>.journal as
+//    they happen and folded into the file by a background compaction once the journal grows.
+//    If another program rewrites the file meanwhile, its changes are merged in, field by
+//    field against the file as last seen, with local edits winning a clash.
+//    serve keeps the store loaded and answers thin clients over a Unix socket instead.
 // 8) Tests: serialization round-trip with edge cases (escapes), date compare, simple assertions.
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #define TITLE_MAX 128
 #define DATE_LEN 10
@@ -29,12 +69,53 @@ typedef struct {
     char due[DATE_LEN + 1]; // YYYY-MM-DD or empty
     int priority;           // 1..5
     int done;               // 0/1
+    int due_day;            // due as a day number, kept in step by list_push/list_replace
 } Task;
 
+// Deleted tasks stay in place as tombstones (id == TASK_DEAD) so insertion order
+// survives deletes; they are squeezed out once they outnumber live tasks.
+#define TASK_DEAD INT_MIN
+#define IX_EMPTY UINT32_MAX
+#define COMPACT_MIN_DEAD 1024
+#define ARENA_REPACK_MIN (1u << 20)
+#define DUE_NONE ((1 << 20) - 1)
+
+// Live-task slots in display order, rebuilt only after a change that can
+// reorder them. Deletes leave stale slots behind; readers skip dead ones.
+enum { VIEW_DUE, VIEW_PRIORITY, VIEW_COUNT };
+typedef struct { uint32_t *order; size_t n; int valid; } SortView;
+
+typedef struct { int id; uint32_t slot; } IdSlot;
+typedef struct TriIndex TriIndex;
+typedef struct Sched Sched;
+typedef struct Calendar Calendar;
+
+// Tasks are stored by column, one entry per slot with tombstones included,
+// so scans read only the fields they test. Titles live back to back in an
+// arena that is only appended to; the due string is rebuilt from due_day.
 typedef struct {
-    Task *items;
-    size_t len;
+    int32_t *id;     // TASK_DEAD marks a deleted slot
+    int32_t *due_day;
+    uint8_t *priority;
+    uint64_t *done;  // one bit per slot
+    uint32_t *title; // offset of the title in arena
+    char *arena;
+    size_t arena_len, arena_cap;
+    size_t arena_dead; // bytes of titles no slot refers to any more
+    size_t len;      // slots used, tombstones included
     size_t cap;
+    size_t live;     // tasks not deleted
+    int max_id;      // never decreases, so ids are not reused
+    IdSlot *ix;      // open addressing, linear probing, id -> slot
+    size_t ix_cap;   // power of two
+    size_t ix_len;
+    int ix_stale;    // index not built yet (mapped snapshot)
+    void *map;       // columns and arena live inside this snapshot mapping
+    size_t map_len;
+    SortView view[VIEW_COUNT];
+    TriIndex *tri;   // title trigrams; NULL until search is wanted
+    Sched *sched;    // urgency heap; NULL until "next" is wanted
+    Calendar *cal;   // open tasks by due day; NULL until an agenda is wanted
 } TaskList;
 
 /*---------------- Utility ----------------*/
@@ -55,43 +136,18 @@ static void *xrealloc(void *p, size_t n) {
     return q;
 }
 
-/*---------------- TaskList ----------------*/
-static void list_init(TaskList *L) {
-    L->items = NULL; L->len = 0; L->cap = 0;
-}
-
-static void list_free(TaskList *L) {
-    free(L->items); L->items = NULL; L->len = L->cap = 0;
-}
-
-static void list_reserve(TaskList *L, size_t want) {
-    if (want <= L->cap) return;
-    size_t nc = L->cap ? L->cap * 2 : 8;
-    if (nc < want) nc = want;
-    L->items = (Task*)xrealloc(L->items, nc * sizeof(Task));
-    L->cap = nc;
-}
-
-static void list_push(TaskList *L, Task t) {
-    list_reserve(L, L->len + 1);
-    L->items[L->len++] = t;
-}
-
-static int list_find_index_by_id(const TaskList *L, int id) {
-    for (size_t i = 0; i < L->len; ++i) if (L->items[i].id == id) return (int)i;
-    return -1;
-}
-
-static int list_next_id(const TaskList *L) {
-    int maxid = 0;
-    for (size_t i = 0; i < L->len; ++i) if (L->items[i].id > maxid) maxid = L->items[i].id;
-    return maxid + 1;
-}
-
-static void list_delete_at(TaskList *L, size_t idx) {
-    if (idx >= L->len) return;
-    L->items[idx] = L->items[L->len - 1];
-    L->len--;
+static uint32_t crc32_buf(const unsigned char *p, size_t n) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--) c = table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
 }
 
 /*---------------- Date helpers ----------------*/
@@ -115,382 +171,5916 @@ static int valid_date(const char *s) {
     return 1;
 }
 
-static int date_to_int(const char *s) {
-    if (!s || !*s) return 99991231;
-    return (s[0]-'0')*10000000 + (s[1]-'0')*1000000 + (s[2]-'0')*100000 + (s[3]-'0')*10000 + (s[5]-'0')*1000 + (s[6]-'0')*100 + (s[8]-'0')*10 + (s[9]-'0');
+// Day number of a valid date (consecutive days, counted from 0000-03-01),
+// or DUE_NONE for no date, which sorts after every real one.
+static int date_to_day(const char *s) {
+    if (!s || !*s) return DUE_NONE;
+    int y = (s[0]-'0')*1000 + (s[1]-'0')*100 + (s[2]-'0')*10 + (s[3]-'0');
+    int m = (s[5]-'0')*10 + (s[6]-'0');
+    int d = (s[8]-'0')*10 + (s[9]-'0');
+    if (m < 3) { y--; m += 12; }
+    return 365*y + y/4 - y/100 + y/400 + (153*(m-3) + 2)/5 + d - 1;
+}
+
+// Inverse of date_to_day; DUE_NONE gives "".
+static void day_to_date(int day, char out[DATE_LEN + 1]) {
+    if (day == DUE_NONE) { out[0] = '\0'; return; }
+    int y = (int)((10000LL * day + 14780) / 3652425);
+    int doy = day - (365*y + y/4 - y/100 + y/400);
+    if (doy < 0) { y--; doy = day - (365*y + y/4 - y/100 + y/400); }
+    int mi = (100*doy + 52) / 3060;
+    int m = (mi + 2) % 12 + 1, d = doy - (mi*306 + 5)/10 + 1;
+    y += (mi + 2) / 12;
+    out[0] = (char)('0' + y/1000 % 10); out[1] = (char)('0' + y/100 % 10);
+    out[2] = (char)('0' + y/10 % 10); out[3] = (char)('0' + y % 10); out[4] = '-';
+    out[5] = (char)('0' + m/10); out[6] = (char)('0' + m % 10); out[7] = '-';
+    out[8] = (char)('0' + d/10); out[9] = (char)('0' + d % 10); out[10] = '\0';
 }
 
-/*---------------- JSON writer ----------------*/
-static void json_escape_string(FILE *f, const char *s) {
-    fputc('"', f);
-    for (; *s; ++s) {
-        unsigned char c = (unsigned char)*s;
-        switch (c) {
-            case '\\': fputs("\\\\", f); break;
-            case '"': fputs("\\\"", f); break;
-            case '\n': fputs("\\n", f); break;
-            case '\r': fputs("\\r", f); break;
-            case '\t': fputs("\\t", f); break;
-            default:
-                if (c < 0x20) {
-                    fprintf(f, "\\u%04x", c);
-                } else {
-                    fputc(c, f);
-                }
-        }
+/*---------------- Id index ----------------*/
+static size_t ix_home(const TaskList *L, int id) {
+    // Fibonacci hashing: sequential ids spread over the whole table.
+    return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> 32) & (L->ix_cap - 1);
+}
+
+static void ix_put(TaskList *L, int id, uint32_t slot);
+
+static void ix_grow(TaskList *L) {
+    IdSlot *old = L->ix; size_t oldcap = L->ix_cap;
+    L->ix_cap = oldcap ? oldcap * 2 : 64;
+    L->ix = (IdSlot*)xmalloc(L->ix_cap * sizeof(IdSlot));
+    for (size_t i = 0; i < L->ix_cap; ++i) L->ix[i].slot = IX_EMPTY;
+    L->ix_len = 0;
+    for (size_t i = 0; i < oldcap; ++i) if (old[i].slot != IX_EMPTY) ix_put(L, old[i].id, old[i].slot);
+    free(old);
+}
+
+// Keeps the first slot seen for an id, matching the old linear scan on duplicate ids.
+static void ix_put(TaskList *L, int id, uint32_t slot) {
+    if ((L->ix_len + 1) * 4 > L->ix_cap * 3) ix_grow(L);
+    size_t m = L->ix_cap - 1, i = ix_home(L, id);
+    while (L->ix[i].slot != IX_EMPTY) {
+        if (L->ix[i].id == id) return;
+        i = (i + 1) & m;
     }
-    fputc('"', f);
+    L->ix[i].id = id; L->ix[i].slot = slot; L->ix_len++;
 }
 
-static int save_tasks(const char *path, const TaskList *L) {
-    FILE *f = fopen(path, "wb");
-    if (!f) { perror("fopen"); return 0; }
-    fputs("[\n", f);
-    for (size_t i = 0; i < L->len; ++i) {
-        const Task *t = &L->items[i];
-        fputs("  { ", f);
-        fprintf(f, "\"id\": %d, ", t->id);
-        fputs("\"title\": ", f); json_escape_string(f, t->title); fputs(", ", f);
-        fputs("\"due\": ", f); json_escape_string(f, t->due); fputs(", ", f);
-        fprintf(f, "\"priority\": %d, ", t->priority);
-        fprintf(f, "\"done\": %s ", t->done ? "true" : "false");
-        fputs("}", f);
-        if (i + 1 < L->len) fputs(",", f);
-        fputc('\n', f);
-    }
-    fputs("]\n", f);
-    fclose(f);
-    return 1;
+static long ix_get(const TaskList *L, int id) {
+    if (!L->ix_cap) return -1;
+    size_t m = L->ix_cap - 1, i = ix_home(L, id);
+    while (L->ix[i].slot != IX_EMPTY) {
+        if (L->ix[i].id == id) return (long)L->ix[i].slot;
+        i = (i + 1) & m;
+    }
+    return -1;
 }
 
-/*---------------- Minimal JSON reader ----------------*/
-
-typedef struct { const char *s; size_t i, n; } Json;
-
-static void j_init(Json *j, const char *s, size_t n){ j->s=s; j->i=0; j->n=n; }
-static int j_eof(Json *j){ return j->i >= j->n; }
-static char j_peek(Json *j){ return j->i<j->n? j->s[j->i] : '\0'; }
-static char j_get(Json *j){ return j->i<j->n? j->s[j->i++] : '\0'; }
-static void j_skip_ws(Json *j){ while(!j_eof(j) && isspace((unsigned char)j->s[j->i])) j->i++; }
-
-static int j_expect(Json *j, char c){ j_skip_ws(j); if (j_peek(j)!=c) return 0; j_get(j); return 1; }
-
-static int j_match_lit(Json *j, const char *lit){ j_skip_ws(j); size_t k=0; while(lit[k]){ if (j_get(j)!=lit[k]) return 0; k++; } return 1; }
-
-static int j_parse_string(Json *j, char *out, size_t outsz){
-    j_skip_ws(j);
-    if (j_get(j)!='"') return 0;
-    size_t o=0;
-    while(!j_eof(j)){
-        char c = j_get(j);
-        if (c=='"') { if (o<outsz) out[o]='\0'; else out[outsz-1]='\0'; return 1; }
-        if (c=='\\'){
-            char e = j_get(j);
-            switch(e){
-                case '"': c='"'; break;
-                case '\\': c='\\'; break;
-                case '/': c='/'; break;
-                case 'b': c='\b'; break;
-                case 'f': c='\f'; break;
-                case 'n': c='\n'; break;
-                case 'r': c='\r'; break;
-                case 't': c='\t'; break;
-                case 'u': {
-                    // Skip 4 hex digits, store '?'
-                    for (int k=0;k<4;k++) j_get(j);
-                    c='?';
-                } break;
-                default: return 0;
-            }
-        }
-        if (o+1<outsz) out[o++]=c;
+static void ix_del(TaskList *L, int id) {
+    if (!L->ix_cap) return;
+    size_t m = L->ix_cap - 1, i = ix_home(L, id);
+    while (L->ix[i].slot != IX_EMPTY && L->ix[i].id != id) i = (i + 1) & m;
+    if (L->ix[i].slot == IX_EMPTY) return;
+    // Backward-shift deletion: no hash tombstones, probe chains stay short.
+    size_t hole = i;
+    for (size_t j = (i + 1) & m; L->ix[j].slot != IX_EMPTY; j = (j + 1) & m) {
+        size_t h = ix_home(L, L->ix[j].id);
+        if (((j - h) & m) >= ((j - hole) & m)) { L->ix[hole] = L->ix[j]; hole = j; }
     }
-    return 0;
+    L->ix[hole].slot = IX_EMPTY;
+    L->ix_len--;
 }
 
-static int j_parse_int(Json *j, int *out){
-    j_skip_ws(j);
-    int sign=1; if (j_peek(j)=='-'){ sign=-1; j_get(j);} 
-    if (!isdigit((unsigned char)j_peek(j))) return 0;
-    long v=0;
-    while(isdigit((unsigned char)j_peek(j))){ v = v*10 + (j_get(j)-'0'); if (v>2147483647L) return 0; }
-    *out = (int)(sign*v);
-    return 1;
+static void ix_rebuild(TaskList *L) {
+    for (size_t i = 0; i < L->ix_cap; ++i) L->ix[i].slot = IX_EMPTY;
+    L->ix_len = 0;
+    for (size_t i = 0; i < L->len; ++i) if (L->id[i] != TASK_DEAD) ix_put(L, L->id[i], (uint32_t)i);
 }
 
-static int j_parse_bool(Json *j, int *out){
-    j_skip_ws(j);
-    if (j_peek(j)=='t'){ if (!j_match_lit(j,"true")) return 0; *out=1; return 1; }
-    if (j_peek(j)=='f'){ if (!j_match_lit(j,"false")) return 0; *out=0; return 1; }
-    return 0;
+/*---------------- Trigram index ----------------*/
+// Title search: every case-folded 3-byte window of a title maps to a posting
+// list of the ids whose titles contain it. Lists are sorted and stored as
+// LEB128 deltas, so the usual edit (a new task, whose id is the largest yet)
+// is an append; other edits re-encode only the lists they touch. Ids are
+// biased into uint32 so negative ids sort first.
+#define TRI_PER_TITLE (TITLE_MAX - 2)
+
+typedef struct { uint8_t *buf; uint32_t len, cap, count, last; } Posting;
+typedef struct { uint32_t tri, post; } TriSlot; // tri == 0 marks an empty slot
+
+struct TriIndex {
+    TriSlot *slot;       // open addressing, linear probing, trigram -> post[]
+    size_t cap, used;    // cap is a power of two
+    Posting *post;
+    size_t npost, post_cap;
+    int dirty;           // differs from the .tri file
+};
+
+static uint32_t tri_key(int id) { return (uint32_t)id ^ 0x80000000u; }
+static int tri_unkey(uint32_t k) { return (int)(k ^ 0x80000000u); }
+static unsigned char fold(unsigned char c) { return c >= 'A' && c <= 'Z' ? (unsigned char)(c + 32) : c; }
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
 }
 
-static void j_skip_value(Json *j);
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
 
-static int j_skip_string(Json *j){ char tmp[2]; return j_parse_string(j,tmp,2); }
+// Distinct trigrams of s, sorted.
+static size_t trigrams_of(const char *s, uint32_t *out) {
+    const unsigned char *p = (const unsigned char*)s;
+    size_t n = 0;
+    for (; p[0] && p[1] && p[2] && n < TRI_PER_TITLE; ++p)
+        out[n++] = (uint32_t)fold(p[0]) << 16 | (uint32_t)fold(p[1]) << 8 | fold(p[2]);
+    qsort(out, n, sizeof *out, cmp_u32);
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) if (!w || out[i] != out[w - 1]) out[w++] = out[i];
+    return w;
+}
 
-static void j_skip_array(Json *j){
-    if (!j_expect(j,'[')) return;
-    j_skip_ws(j);
-    if (j_peek(j)==']'){ j_get(j); return; }
-    for(;;){ j_skip_value(j); j_skip_ws(j); if (j_peek(j)==','){ j_get(j); continue; } else { j_expect(j,']'); break; } }
+static size_t tri_home(const TriIndex *T, uint32_t g) {
+    return (size_t)(((uint64_t)g * 0x9E3779B97F4A7C15ull) >> 32) & (T->cap - 1);
 }
 
-static void j_skip_object(Json *j){
-    if (!j_expect(j,'{')) return;
-    j_skip_ws(j);
-    if (j_peek(j)=='}'){ j_get(j); return; }
-    for(;;){ j_skip_string(j); j_skip_ws(j); j_expect(j,':'); j_skip_value(j); j_skip_ws(j); if (j_peek(j)==','){ j_get(j); continue; } else { j_expect(j,'}'); break; } }
+static Posting *tri_find(const TriIndex *T, uint32_t g) {
+    if (!T->cap) return NULL;
+    for (size_t m = T->cap - 1, i = tri_home(T, g); T->slot[i].tri; i = (i + 1) & m)
+        if (T->slot[i].tri == g) return &T->post[T->slot[i].post];
+    return NULL;
 }
 
-static void j_skip_value(Json *j){
-    j_skip_ws(j);
-    char c = j_peek(j);
-    if (c=='"'){ j_skip_string(j); return; }
-    if (c=='{' ){ j_skip_object(j); return; }
-    if (c=='[' ){ j_skip_array(j); return; }
-    if (c=='t' || c=='f'){ int b; j_parse_bool(j,&b); return; }
-    if (c=='n'){ j_match_lit(j,"null"); return; }
-    if (c=='-' || isdigit((unsigned char)c)){ int x; j_parse_int(j,&x); return; }
-    // fallback
-    j_get(j);
+static void tri_insert_slot(TriIndex *T, uint32_t g, uint32_t post) {
+    size_t m = T->cap - 1, i = tri_home(T, g);
+    while (T->slot[i].tri) i = (i + 1) & m;
+    T->slot[i].tri = g; T->slot[i].post = post;
 }
 
-static int load_tasks(const char *path, TaskList *L) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return 1; // no file -> empty list is fine
-    if (fseek(f, 0, SEEK_END)!=0){ fclose(f); return 0; }
-    long n = ftell(f); if (n < 0){ fclose(f); return 0; }
-    rewind(f);
-    char *buf = (char*)xmalloc((size_t)n + 1);
-    size_t rd = fread(buf, 1, (size_t)n, f); buf[rd] = '\0'; fclose(f);
-
-    Json j; j_init(&j, buf, rd);
-    if (!j_expect(&j,'[')) { free(buf); return 0; }
-    j_skip_ws(&j);
-    if (j_peek(&j)==']'){ j_get(&j); free(buf); return 1; }
+static Posting *tri_get(TriIndex *T, uint32_t g) {
+    Posting *P = tri_find(T, g);
+    if (P) return P;
+    if ((T->used + 1) * 4 > T->cap * 3) {
+        TriSlot *old = T->slot; size_t oldcap = T->cap;
+        T->cap = oldcap ? oldcap * 2 : 1024;
+        T->slot = (TriSlot*)xmalloc(T->cap * sizeof *T->slot);
+        memset(T->slot, 0, T->cap * sizeof *T->slot);
+        for (size_t i = 0; i < oldcap; ++i) if (old[i].tri) tri_insert_slot(T, old[i].tri, old[i].post);
+        free(old);
+    }
+    if (T->npost == T->post_cap) {
+        T->post_cap = T->post_cap ? T->post_cap * 2 : 1024;
+        T->post = (Posting*)xrealloc(T->post, T->post_cap * sizeof *T->post);
+    }
+    memset(&T->post[T->npost], 0, sizeof *T->post);
+    tri_insert_slot(T, g, (uint32_t)T->npost);
+    T->used++;
+    return &T->post[T->npost++];
+}
 
-    for(;;){
-        if (!j_expect(&j,'{')) { free(buf); return 0; }
-        Task t; memset(&t,0,sizeof(t));
-        // default empty due -> ""
-        for(;;){
-            char key[32]; if (!j_parse_string(&j, key, sizeof key)) { free(buf); return 0; }
-            if (!j_expect(&j,':')) { free(buf); return 0; }
-            if (strcmp(key,"id")==0){ if (!j_parse_int(&j,&t.id)) { free(buf); return 0; } }
-            else if (strcmp(key,"title")==0){ if (!j_parse_string(&j,t.title,sizeof t.title)) { free(buf); return 0; } }
-            else if (strcmp(key,"due")==0){ if (!j_parse_string(&j,t.due,sizeof t.due)) { free(buf); return 0; } }
-            else if (strcmp(key,"priority")==0){ if (!j_parse_int(&j,&t.priority)) { free(buf); return 0; } }
-            else if (strcmp(key,"done")==0){ if (!j_parse_bool(&j,&t.done)) { free(buf); return 0; } }
-            else { j_skip_value(&j); }
-            j_skip_ws(&j);
-            char c = j_get(&j);
-            if (c==',') { j_skip_ws(&j); continue; }
-            if (c=='}') break;
-            free(buf); return 0;
-        }
-        if (!t.priority) t.priority = 3;
-        if (!valid_date(t.due)) { free(buf); return 0; }
-        list_push(L, t);
-        j_skip_ws(&j);
-        char c = j_get(&j);
-        if (c==','){ j_skip_ws(&j); continue; }
-        if (c==']') break;
-        free(buf); return 0;
+static void post_put(Posting *P, uint32_t v) {
+    if (P->len + 5 > P->cap) {
+        P->cap = P->cap ? P->cap * 2 : 8;
+        P->buf = (uint8_t*)xrealloc(P->buf, P->cap);
     }
-    free(buf);
-    return 1;
+    while (v >= 0x80) { P->buf[P->len++] = (uint8_t)(v | 0x80); v >>= 7; }
+    P->buf[P->len++] = (uint8_t)v;
 }
 
-/*---------------- Input helpers ----------------*/
-static void read_line(const char *prompt, char *buf, size_t n) {
-    if (prompt) printf("%s", prompt);
-    if (!fgets(buf, (int)n, stdin)) { buf[0]='\0'; return; }
-    size_t len = strlen(buf);
-    if (len && buf[len-1]=='\n') buf[len-1]='\0';
+// Reads the delta at *i and returns the next id key.
+static uint32_t post_next(const Posting *P, uint32_t *i, uint32_t prev) {
+    uint32_t v = 0; int sh = 0; uint8_t b;
+    do { b = P->buf[(*i)++]; v |= (uint32_t)(b & 0x7F) << sh; sh += 7; } while (b & 0x80);
+    return prev + v;
 }
 
-static int read_int_range(const char *prompt, int lo, int hi, int allow_empty, int *out) {
-    char buf[64];
-    for(;;){
-        read_line(prompt, buf, sizeof buf);
-        if (allow_empty && buf[0]=='\0') return 1;
-        char *end; long v = strtol(buf, &end, 10);
-        if (end!=buf && *end=='\0' && v>=lo && v<=hi){ *out=(int)v; return 1; }
-        printf("Invalid. Enter %d..%d.\n", lo, hi);
+static uint32_t *post_decode(const Posting *P) {
+    uint32_t *v = (uint32_t*)xmalloc(((size_t)P->count + 1) * sizeof *v), cur = 0, i = 0;
+    for (size_t n = 0; i < P->len; ++n) v[n] = cur = post_next(P, &i, cur);
+    return v;
+}
+
+static void post_encode(Posting *P, const uint32_t *v, size_t n) {
+    P->len = 0; P->count = (uint32_t)n; P->last = 0;
+    for (size_t i = 0; i < n; ++i) { post_put(P, v[i] - P->last); P->last = v[i]; }
+}
+
+static size_t post_lower_bound(const uint32_t *v, size_t n, uint32_t k) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) { size_t mid = (lo + hi) / 2; if (v[mid] < k) lo = mid + 1; else hi = mid; }
+    return lo;
+}
+
+static void post_add(Posting *P, uint32_t k) {
+    if (!P->count || k > P->last) { post_put(P, k - P->last); P->last = k; P->count++; return; }
+    if (k == P->last) return;
+    uint32_t *v = post_decode(P);
+    size_t at = post_lower_bound(v, P->count, k);
+    if (v[at] != k) {
+        memmove(v + at + 1, v + at, (P->count - at) * sizeof *v);
+        v[at] = k;
+        post_encode(P, v, (size_t)P->count + 1);
     }
+    free(v);
 }
 
-static int read_date(const char *prompt, int allow_empty, char out[DATE_LEN+1]){
-    char buf[64];
-    for(;;){
-        read_line(prompt, buf, sizeof buf);
-        if (allow_empty && buf[0]=='\0'){ out[0]='\0'; return 1; }
-        if (valid_date(buf)){ strncpy(out, buf, DATE_LEN); out[DATE_LEN]='\0'; return 1; }
-        printf("Invalid date. Use YYYY-MM-DD or empty.\n");
+static void post_remove(Posting *P, uint32_t k) {
+    if (!P->count || k > P->last) return;
+    uint32_t *v = post_decode(P);
+    size_t at = post_lower_bound(v, P->count, k);
+    if (at < P->count && v[at] == k) {
+        memmove(v + at, v + at + 1, (P->count - at - 1) * sizeof *v);
+        post_encode(P, v, (size_t)P->count - 1);
     }
+    free(v);
 }
 
-/*---------------- Sorting & filtering ----------------*/
-static int cmp_due_asc(const void *a, const void *b){
-    const Task *x=a, *y=b;
-    int dx = date_to_int(x->due), dy = date_to_int(y->due);
-    if (dx!=dy) return dx<dy? -1: 1;
-    if (x->priority!=y->priority) return y->priority - x->priority;
-    return x->id - y->id;
+// Moves id from the trigrams of old_title to those of new_title (either may
+// be NULL). Adding a present id or removing an absent one is a no-op, which
+// keeps journal replay over a saved index idempotent.
+static void tri_update(TriIndex *T, int id, const char *old_title, const char *new_title) {
+    uint32_t a[TRI_PER_TITLE], b[TRI_PER_TITLE];
+    size_t na = old_title ? trigrams_of(old_title, a) : 0, nb = new_title ? trigrams_of(new_title, b) : 0;
+    uint32_t k = tri_key(id);
+    for (size_t i = 0, j = 0; i < na || j < nb; ) {
+        if (j == nb || (i < na && a[i] < b[j])) { Posting *P = tri_find(T, a[i++]); if (P) post_remove(P, k); }
+        else if (i == na || b[j] < a[i]) post_add(tri_get(T, b[j++]), k);
+        else { i++; j++; }
+    }
+    T->dirty = 1;
 }
 
-static int cmp_priority_desc(const void *a, const void *b){
-    const Task *x=a, *y=b;
-    if (x->priority!=y->priority) return y->priority - x->priority;
-    int dx = date_to_int(x->due), dy = date_to_int(y->due);
-    if (dx!=dy) return dx<dy? -1: 1;
-    return x->id - y->id;
+static void tri_free(TriIndex *T) {
+    if (!T) return;
+    for (size_t i = 0; i < T->npost; ++i) free(T->post[i].buf);
+    free(T->post); free(T->slot); free(T);
 }
 
-/*---------------- Table output ----------------*/
-static void print_rule(void){ printf("+------+--------------------------------+------------+----------+-------+\n"); }
+static TriIndex *tri_new(void) {
+    TriIndex *T = (TriIndex*)xmalloc(sizeof *T);
+    memset(T, 0, sizeof *T);
+    return T;
+}
 
-static void print_header(void){
-    print_rule();
-    printf("| %-4s | %-30s | %-10s | %-8s | %-5s |\n", "ID", "Title", "Due", "Priority", "Done");
-    print_rule();
+// A mapped snapshot defers the index to the first lookup, so opening it
+// touches no records.
+static void ix_ensure(TaskList *L) {
+    if (!L->ix_stale) return;
+    L->ix_stale = 0;
+    while (L->ix_cap * 3 < L->live * 4) ix_grow(L);
+    ix_rebuild(L);
 }
 
-static void print_task_row(const Task *t){
-    char title[31];
-    size_t n = strlen(t->title);
-    if (n>30){ memcpy(title, t->title, 27); title[27]='.'; title[28]='.'; title[29]='.'; title[30]='\0'; }
-    else { strncpy(title, t->title, sizeof title); title[30]='\0'; }
-    printf("| %4d | %-30s | %-10s | %8d | %5s |\n", t->id, title, t->due[0]? t->due : "", t->priority, t->done? "yes":"no");
+/*---------------- Urgency scheduler ----------------*/
+// "What next": open tasks in a max-heap keyed by urgency, with each slot's
+// heap position recorded so an add, edit or completion is a single
+// O(log n) sift. Urgency is a weight for how soon the task is due, taken
+// per bucket of days left, plus a weight for priority; the older task
+// (lower id, as ids are handed out in order) wins ties. Age only matters
+// relative to other tasks, so it never needs rescoring, and the due weight
+// changes only when a task crosses a bucket edge: slots are chained by due
+// day so a day rollover visits just the days sitting on an edge.
+#define SCHED_NONE UINT32_MAX
+#define DUE_EDGES 9
+#define DUE_WEIGHT_NONE 150
+#define PRIORITY_WEIGHT 60
+#define NEXT_DEFAULT 10
+
+// A task d days from due (negative once overdue) is in bucket "edges <= d".
+static const int DUE_EDGE[DUE_EDGES] = { -7, 0, 1, 2, 4, 8, 15, 31, 91 };
+static const int DUE_WEIGHT[DUE_EDGES + 1] = { 900, 850, 800, 650, 550, 450, 300, 200, 100, 50 };
+
+typedef struct { int32_t day; uint32_t head; } DayHead;
+
+struct Sched {
+    uint32_t *heap;        // slots, most urgent at 0
+    uint64_t *key;         // key of heap[i]
+    size_t n, heap_cap;
+    uint32_t *pos;         // per slot: index in heap, SCHED_NONE if not queued
+    int32_t *day;          // per slot: due day it is chained under, DUE_NONE if none
+    uint32_t *next, *prev; // per slot: chain of slots due the same day
+    size_t slot_cap;
+    DayHead *days;         // open addressing, due day -> first slot (day -1 = empty)
+    size_t days_cap, days_len;
+    int today;             // day the keys were computed for
+};
+
+static uint64_t urgency_key(int today, int id, int due_day, int priority) {
+    int w = DUE_WEIGHT_NONE;
+    if (due_day != DUE_NONE) {
+        int d = due_day - today, b = 0;
+        while (b < DUE_EDGES && DUE_EDGE[b] <= d) b++;
+        w = DUE_WEIGHT[b];
+    }
+    uint32_t k = ~((uint32_t)id ^ 0x80000000u); // signed order, reversed: lower ids win ties
+    return (uint64_t)(w + PRIORITY_WEIGHT * priority) << 32 | k;
 }
 
-static void list_tasks(const TaskList *L){
-    if (L->len==0){ printf("No tasks.\n"); return; }
-    printf("Sort by: 1) due  2) priority  [1]: ");
-    int choice=1; char ln[16]; if (fgets(ln, sizeof ln, stdin)){ if (ln[0]=='2') choice=2; }
+static void sched_swap(Sched *S, size_t a, size_t b) {
+    uint64_t k = S->key[a]; S->key[a] = S->key[b]; S->key[b] = k;
+    uint32_t s = S->heap[a]; S->heap[a] = S->heap[b]; S->heap[b] = s;
+    S->pos[S->heap[a]] = (uint32_t)a;
+    S->pos[S->heap[b]] = (uint32_t)b;
+}
 
-    // Build a copy for sorting
-    TaskList tmp; list_init(&tmp); list_reserve(&tmp, L->len); tmp.len = L->len; memcpy(tmp.items = (Task*)xrealloc(tmp.items, L->len*sizeof(Task)), L->items, L->len*sizeof(Task));
-    qsort(tmp.items, tmp.len, sizeof(Task), choice==2? cmp_priority_desc : cmp_due_asc);
+static void sched_sift_up(Sched *S, size_t i) {
+    while (i && S->key[(i - 1) / 2] < S->key[i]) { sched_swap(S, i, (i - 1) / 2); i = (i - 1) / 2; }
+}
 
-    // Filters
-    char due_before[DATE_LEN+1] = ""; int have_due=0;
-    printf("Filter due before (YYYY-MM-DD) or empty: ");
-    if (fgets(ln, sizeof ln, stdin)){
-        if (ln[0]!='\n'){ ln[strcspn(ln,"\n")]='\0'; if (valid_date(ln)){ strncpy(due_before, ln, DATE_LEN); due_before[DATE_LEN]='\0'; have_due= (due_before[0]!='\0'); } }
+static void sched_sift_down(Sched *S, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < S->n && S->key[l] > S->key[m]) m = l;
+        if (l + 1 < S->n && S->key[l + 1] > S->key[m]) m = l + 1;
+        if (m == i) return;
+        sched_swap(S, i, m);
+        i = m;
     }
-    int minp=0; printf("Min priority [1-5] or 0 for none: ");
-    if (fgets(ln, sizeof ln, stdin)){ int v=atoi(ln); if (v>=1&&v<=5) minp=v; }
-    int only_open=0; printf("Only pending? 1=yes 0=no [0]: ");
-    if (fgets(ln, sizeof ln, stdin)){ if (ln[0]=='1') only_open=1; }
+}
 
-    print_header();
-    for (size_t i=0;i<tmp.len;i++){
-        const Task *t=&tmp.items[i];
-        if (have_due && date_to_int(t->due) >= date_to_int(due_before)) continue;
-        if (minp && t->priority < minp) continue;
-        if (only_open && t->done) continue;
-        print_task_row(t);
+static void sched_rekey(Sched *S, uint32_t slot, uint64_t key) {
+    size_t i = S->pos[slot];
+    uint64_t old = S->key[i];
+    S->key[i] = key;
+    if (key > old) sched_sift_up(S, i); else sched_sift_down(S, i);
+}
+
+static size_t day_home(const Sched *S, int day) {
+    return (size_t)(((uint64_t)(uint32_t)day * 0x9E3779B97F4A7C15ull) >> 32) & (S->days_cap - 1);
+}
+
+// Head of the chain for day; with create, added (empty) if missing.
+static DayHead *day_find(Sched *S, int day, int create) {
+    if (create && (S->days_len + 1) * 4 > S->days_cap * 3) {
+        DayHead *old = S->days; size_t oldcap = S->days_cap;
+        S->days_cap = oldcap ? oldcap * 2 : 64;
+        S->days = (DayHead*)xmalloc(S->days_cap * sizeof *S->days);
+        for (size_t i = 0; i < S->days_cap; ++i) S->days[i].day = -1;
+        for (size_t i = 0; i < oldcap; ++i) {
+            if (old[i].day < 0) continue;
+            size_t j = day_home(S, old[i].day);
+            while (S->days[j].day >= 0) j = (j + 1) & (S->days_cap - 1);
+            S->days[j] = old[i];
+        }
+        free(old);
     }
-    print_rule();
-    list_free(&tmp);
+    if (!S->days_cap) return NULL;
+    size_t m = S->days_cap - 1, i = day_home(S, day);
+    while (S->days[i].day >= 0) {
+        if (S->days[i].day == day) return &S->days[i];
+        i = (i + 1) & m;
+    }
+    if (!create) return NULL;
+    S->days[i].day = day; S->days[i].head = SCHED_NONE; S->days_len++;
+    return &S->days[i];
 }
 
-/*---------------- CRUD ----------------*/
-static void add_task(TaskList *L){
-    Task t; memset(&t,0,sizeof t);
-    t.id = list_next_id(L);
-    read_line("Title: ", t.title, sizeof t.title);
-    while (t.title[0]=='\0'){ printf("Title required.\n"); read_line("Title: ", t.title, sizeof t.title); }
-    read_date("Due (YYYY-MM-DD or empty): ", 1, t.due);
-    read_int_range("Priority [1-5] (default 3): ", 1, 5, 1, &t.priority); if (!t.priority) t.priority=3;
-    t.done=0;
-    list_push(L, t);
-    printf("Added id %d.\n", t.id);
+static void chain_add(Sched *S, uint32_t slot, int day) {
+    S->day[slot] = day;
+    if (day == DUE_NONE) return;
+    DayHead *h = day_find(S, day, 1);
+    S->prev[slot] = SCHED_NONE;
+    S->next[slot] = h->head;
+    if (h->head != SCHED_NONE) S->prev[h->head] = slot;
+    h->head = slot;
 }
 
-static void update_task(TaskList *L){
-    if (L->len==0){ printf("No tasks.\n"); return; }
-    int id; if (!read_int_range("ID to update: ", 1, 100000000, 0, &id)) return;
-    int idx = list_find_index_by_id(L, id);
-    if (idx<0){ printf("Not found.\n"); return; }
-    Task *t = &L->items[idx];
-    char buf[256];
-    printf("Title [%s]: ", t->title); read_line(NULL, buf, sizeof buf); if (buf[0]){ strncpy(t->title, buf, sizeof t->title); t->title[TITLE_MAX]='\0'; }
-    printf("Due [%s]: ", t->due[0]? t->due : ""); read_line(NULL, buf, sizeof buf); if (buf[0]){ if (valid_date(buf)) { strncpy(t->due, buf, DATE_LEN); t->due[DATE_LEN]='\0'; } else printf("Ignored invalid date.\n"); }
-    printf("Priority [%d]: ", t->priority); read_line(NULL, buf, sizeof buf); if (buf[0]){ int v=atoi(buf); if (v>=1&&v<=5) t->priority=v; else printf("Ignored invalid priority.\n"); }
-    printf("Mark done? 1=yes 0=no [%d]: ", t->done); read_line(NULL, buf, sizeof buf); if (buf[0]){ if (buf[0]=='1') t->done=1; else if (buf[0]=='0') t->done=0; }
-    printf("Updated.\n");
+static void chain_remove(Sched *S, uint32_t slot) {
+    if (S->day[slot] == DUE_NONE) return;
+    if (S->prev[slot] != SCHED_NONE) S->next[S->prev[slot]] = S->next[slot];
+    else day_find(S, S->day[slot], 0)->head = S->next[slot];
+    if (S->next[slot] != SCHED_NONE) S->prev[S->next[slot]] = S->prev[slot];
+    S->day[slot] = DUE_NONE;
 }
 
-static void delete_task(TaskList *L){
-    if (L->len==0){ printf("No tasks.\n"); return; }
-    int id; if (!read_int_range("ID to delete: ", 1, 100000000, 0, &id)) return;
-    int idx = list_find_index_by_id(L, id);
-    if (idx<0){ printf("Not found.\n"); return; }
-    list_delete_at(L, (size_t)idx);
-    printf("Deleted.\n");
+static void sched_reserve(Sched *S, size_t slots) {
+    if (slots > S->slot_cap) {
+        size_t nc = S->slot_cap ? S->slot_cap : 64;
+        while (nc < slots) nc *= 2;
+        S->pos = (uint32_t*)xrealloc(S->pos, nc * sizeof *S->pos);
+        S->day = (int32_t*)xrealloc(S->day, nc * sizeof *S->day);
+        S->next = (uint32_t*)xrealloc(S->next, nc * sizeof *S->next);
+        S->prev = (uint32_t*)xrealloc(S->prev, nc * sizeof *S->prev);
+        for (size_t i = S->slot_cap; i < nc; ++i) { S->pos[i] = SCHED_NONE; S->day[i] = DUE_NONE; }
+        S->slot_cap = nc;
+    }
+    if (slots > S->heap_cap) {
+        size_t nc = S->heap_cap ? S->heap_cap : 64;
+        while (nc < slots) nc *= 2;
+        S->heap = (uint32_t*)xrealloc(S->heap, nc * sizeof *S->heap);
+        S->key = (uint64_t*)xrealloc(S->key, nc * sizeof *S->key);
+        S->heap_cap = nc;
+    }
 }
 
-/*---------------- Menu ----------------*/
-static void menu_loop(TaskList *L, const char *path){
-    for(;;){
-        printf("\n[Menu] 1)add 2)list 3)update 4)delete 5)save 6)quit\n> ");
-        char line[16]; if (!fgets(line, sizeof line, stdin)) break;
-        int choice = atoi(line);
-        switch(choice){
-            case 1: add_task(L); break;
-            case 2: list_tasks(L); break;
-            case 3: update_task(L); break;
-            case 4: delete_task(L); break;
-            case 5: if (save_tasks(path,L)) printf("Saved.\n"); else printf("Save failed.\n"); break;
-            case 6: if (save_tasks(path,L)) printf("Saved. Bye.\n"); else printf("Save failed. Bye.\n"); return;
-            default: printf("Choose 1-6.\n");
+// Brings one slot up to date: queued while the task is live and open.
+static void sched_set(Sched *S, uint32_t slot, int queued, int id, int due_day, int priority) {
+    sched_reserve(S, (size_t)slot + 1);
+    uint32_t p = S->pos[slot];
+    if (!queued) {
+        if (p == SCHED_NONE) return;
+        chain_remove(S, slot);
+        S->n--;
+        if (p != S->n) {
+            sched_swap(S, p, S->n);
+            uint32_t moved = S->heap[p];
+            sched_sift_up(S, p);
+            sched_sift_down(S, S->pos[moved]);
         }
+        S->pos[slot] = SCHED_NONE;
+        return;
     }
+    if (S->day[slot] != due_day) { chain_remove(S, slot); chain_add(S, slot, due_day); }
+    uint64_t key = urgency_key(S->today, id, due_day, priority);
+    if (p != SCHED_NONE) { sched_rekey(S, slot, key); return; }
+    S->heap[S->n] = slot; S->key[S->n] = key; S->pos[slot] = (uint32_t)S->n;
+    sched_sift_up(S, S->n++);
 }
 
-/*---------------- Tests ----------------*/
-static int tasks_equal(const Task *a, const Task *b){
-    return a->id==b->id && a->priority==b->priority && a->done==b->done && strcmp(a->title,b->title)==0 && strcmp(a->due,b->due)==0;
+static void sched_free(Sched *S) {
+    if (!S) return;
+    free(S->heap); free(S->key); free(S->pos); free(S->day); free(S->next); free(S->prev); free(S->days);
+    free(S);
 }
 
-static int run_tests(void){
-    TaskList A; list_init(&A);
-    Task t1 = { .id=1, .title="Write \"docs\" \\ core", .due="2025-08-26", .priority=5, .done=0 };
-    Task t2 = { .id=2, .title="Refactor", .due="", .priority=2, .done=1 };
-    list_push(&A, t1); list_push(&A, t2);
-    const char *path = "tasks_test.json";
-    if (!save_tasks(path, &A)) { list_free(&A); return 0; }
+// Up to k most urgent slots, best first, without disturbing the heap: the
+// next one is always a child of one already taken, so a small frontier heap
+// of candidates is enough.
+static size_t sched_top(const Sched *S, size_t k, uint32_t *out) {
+    if (!S->n || !k) return 0;
+    size_t *cand = (size_t*)xmalloc((2 * k + 1) * sizeof *cand), nc = 1, w = 0;
+    cand[0] = 0;
+    while (nc && w < k) {
+        size_t best = cand[0];
+        out[w++] = S->heap[best];
+        cand[0] = cand[--nc];
+        for (size_t i = 0;;) { // sift the frontier down
+            size_t l = 2 * i + 1, m = i;
+            if (l < nc && S->key[cand[l]] > S->key[cand[m]]) m = l;
+            if (l + 1 < nc && S->key[cand[l + 1]] > S->key[cand[m]]) m = l + 1;
+            if (m == i) break;
+            size_t t = cand[i]; cand[i] = cand[m]; cand[m] = t;
+            i = m;
+        }
+        for (size_t c = 2 * best + 1; c <= 2 * best + 2 && c < S->n; ++c) {
+            size_t i = nc++;
+            cand[i] = c;
+            while (i && S->key[cand[(i - 1) / 2]] < S->key[cand[i]]) {
+                size_t t = cand[i]; cand[i] = cand[(i - 1) / 2]; cand[(i - 1) / 2] = t;
+                i = (i - 1) / 2;
+            }
+        }
+    }
+    free(cand);
+    return w;
+}
 
-    TaskList B; list_init(&B);
-    if (!load_tasks(path, &B)) { list_free(&A); list_free(&B); return 0; }
-    int ok = (A.len==B.len);
-    if (ok){ for (size_t i=0;i<A.len;i++){ if (!tasks_equal(&A.items[i], &B.items[i])) { ok=0; break; } } }
+static Sched *sched_build(const TaskList *L, int today);
 
-    if (ok) printf("Test: round-trip OK (%zu items)\n", A.len);
-    else printf("Test: round-trip FAILED\n");
+/*---------------- Calendar ----------------*/
+// Open tasks filed by due day, for range questions such as "due this week"
+// or "overdue". Valid dates run from 1900 to 2100, so every day of that span
+// has a bucket heading a chain of slots. One bit per day marks the buckets
+// in use and one bit per word of those marks the words in use, so a range
+// walk skips empty stretches 4096 days at a time and otherwise touches only
+// the tasks it returns. Dates outside the span, which only a hand-edited
+// file can hold, are filed in the end buckets.
+#define CAL_FIRST_DATE "1900-01-01"
+#define CAL_LAST_DATE "2100-12-31"
 
-    list_free(&A); list_free(&B);
-    return ok;
+struct Calendar {
+    int first;             // day number of bucket 0
+    size_t ndays;
+    uint32_t *head;        // per bucket: first slot, SCHED_NONE if empty
+    uint64_t *used;        // per bucket: not empty
+    uint64_t *summary;     // per word of used: not zero
+    size_t used_words, summary_words;
+    int32_t *day;          // per slot: day it is filed under, DUE_NONE if none
+    uint32_t *next, *prev; // per slot: chain of slots in the same bucket
+    size_t slot_cap;
+    size_t n;              // slots filed
+};
+
+static Calendar *cal_new(void) {
+    Calendar *C = (Calendar*)xmalloc(sizeof *C);
+    memset(C, 0, sizeof *C);
+    C->first = date_to_day(CAL_FIRST_DATE);
+    C->ndays = (size_t)(date_to_day(CAL_LAST_DATE) - C->first + 1);
+    C->used_words = (C->ndays + 63) / 64;
+    C->summary_words = (C->used_words + 63) / 64;
+    C->head = (uint32_t*)xmalloc(C->ndays * sizeof *C->head);
+    memset(C->head, 0xFF, C->ndays * sizeof *C->head);
+    C->used = (uint64_t*)xmalloc(C->used_words * sizeof *C->used);
+    memset(C->used, 0, C->used_words * sizeof *C->used);
+    C->summary = (uint64_t*)xmalloc(C->summary_words * sizeof *C->summary);
+    memset(C->summary, 0, C->summary_words * sizeof *C->summary);
+    return C;
 }
 
-/*---------------- Main ----------------*/
-int main(int argc, char **argv){
-    if (argc>=2 && strcmp(argv[1],"--test")==0){
-        return run_tests()? 0: 1;
+static size_t cal_bucket(const Calendar *C, int day) {
+    int64_t b = (int64_t)day - C->first;
+    return b < 0 ? 0 : (size_t)b >= C->ndays ? C->ndays - 1 : (size_t)b;
+}
+
+static void cal_reserve(Calendar *C, size_t slots) {
+    if (slots <= C->slot_cap) return;
+    size_t nc = C->slot_cap ? C->slot_cap : 64;
+    while (nc < slots) nc *= 2;
+    C->day = (int32_t*)xrealloc(C->day, nc * sizeof *C->day);
+    C->next = (uint32_t*)xrealloc(C->next, nc * sizeof *C->next);
+    C->prev = (uint32_t*)xrealloc(C->prev, nc * sizeof *C->prev);
+    for (size_t i = C->slot_cap; i < nc; ++i) C->day[i] = DUE_NONE;
+    C->slot_cap = nc;
+}
+
+// Files slot under day, moving it if it was filed elsewhere; DUE_NONE takes
+// it out.
+static void cal_set(Calendar *C, uint32_t slot, int day) {
+    cal_reserve(C, (size_t)slot + 1);
+    if (C->day[slot] == day) return;
+    if (C->day[slot] != DUE_NONE) {
+        size_t b = cal_bucket(C, C->day[slot]);
+        if (C->prev[slot] != SCHED_NONE) C->next[C->prev[slot]] = C->next[slot];
+        else C->head[b] = C->next[slot];
+        if (C->next[slot] != SCHED_NONE) C->prev[C->next[slot]] = C->prev[slot];
+        if (C->head[b] == SCHED_NONE) {
+            C->used[b >> 6] &= ~(1ull << (b & 63));
+            if (!C->used[b >> 6]) C->summary[b >> 12] &= ~(1ull << (b >> 6 & 63));
+        }
+        C->n--;
     }
-    const char *path = (argc>=2 ? argv[1] : "tasks.json");
-    TaskList L; list_init(&L);
-    if (!load_tasks(path, &L)) {
-        fprintf(stderr, "Failed to load %s\n", path);
-        list_free(&L);
-        return 1;
+    C->day[slot] = day;
+    if (day == DUE_NONE) return;
+    size_t b = cal_bucket(C, day);
+    C->prev[slot] = SCHED_NONE;
+    C->next[slot] = C->head[b];
+    if (C->head[b] != SCHED_NONE) C->prev[C->head[b]] = slot;
+    C->head[b] = slot;
+    C->used[b >> 6] |= 1ull << (b & 63);
+    C->summary[b >> 12] |= 1ull << (b >> 6 & 63);
+    C->n++;
+}
+
+// First bucket in use in [b, end), or end.
+static size_t cal_next(const Calendar *C, size_t b, size_t end) {
+    if (b >= end) return end;
+    size_t w = b >> 6;
+    uint64_t m = C->used[w] & (~0ull << (b & 63));
+    for (size_t s = w + 1; !m; ) {
+        if ((s >> 6) >= C->summary_words) return end;
+        uint64_t sm = C->summary[s >> 6] & (~0ull << (s & 63));
+        if (sm) { w = (s & ~(size_t)63) + (size_t)__builtin_ctzll(sm); m = C->used[w]; }
+        else s = (s | 63) + 1;
     }
-    printf("[Start] Loaded %zu tasks from %s\n", L.len, path);
-    menu_loop(&L, path);
-    list_free(&L);
+    b = w * 64 + (size_t)__builtin_ctzll(m);
+    return b < end ? b : end;
+}
+
+static void cal_free(Calendar *C) {
+    if (!C) return;
+    free(C->head); free(C->used); free(C->summary); free(C->day); free(C->next); free(C->prev);
+    free(C);
+}
+
+static Calendar *cal_build(const TaskList *L);
+
+/*---------------- TaskList ----------------*/
+static int list_live(const TaskList *L, size_t i) { return L->id[i] != TASK_DEAD; }
+static const char *list_title(const TaskList *L, size_t i) { return L->arena + L->title[i]; }
+static int list_done(const TaskList *L, size_t i) { return (int)(L->done[i >> 6] >> (i & 63)) & 1; }
+static size_t done_words(size_t n) { return (n + 63) / 64; }
+
+static void list_set_done(TaskList *L, size_t i, int on) {
+    uint64_t bit = 1ull << (i & 63);
+    if (on) L->done[i >> 6] |= bit; else L->done[i >> 6] &= ~bit;
+}
+
+// Copies slot i out as a Task.
+static void list_get(const TaskList *L, size_t i, Task *t) {
+    const char *title = list_title(L, i);
+    size_t n = strnlen(title, TITLE_MAX);
+    t->id = L->id[i];
+    memcpy(t->title, title, n); t->title[n] = '\0';
+    day_to_date(L->due_day[i], t->due);
+    t->priority = L->priority[i];
+    t->done = list_done(L, i);
+    t->due_day = L->due_day[i];
+}
+
+static void list_init(TaskList *L) {
+    memset(L, 0, sizeof *L);
+}
+
+static void list_free(TaskList *L) {
+    if (L->map) munmap(L->map, L->map_len);
+    else { free(L->id); free(L->due_day); free(L->priority); free(L->done); free(L->title); free(L->arena); }
+    free(L->ix);
+    for (int v = 0; v < VIEW_COUNT; ++v) free(L->view[v].order);
+    tri_free(L->tri);
+    sched_free(L->sched);
+    cal_free(L->cal);
+    list_init(L);
+}
+
+static void list_invalidate_views(TaskList *L) {
+    for (int v = 0; v < VIEW_COUNT; ++v) L->view[v].valid = 0;
+}
+
+// Fills the derived fields and clamps priority into the 1..5 the keys assume.
+// Input is checked before it gets here; the JSON reader warns as it clamps.
+static void task_normalize(Task *t) {
+    if (t->priority < 1) t->priority = 1;
+    if (t->priority > 5) t->priority = 5;
+    t->due_day = date_to_day(t->due);
+}
+
+static void *col_resize(void *p, size_t used, size_t size, int mapped) {
+    if (!mapped) return xrealloc(p, size);
+    void *q = xmalloc(size);
+    memcpy(q, p, used);
+    return q;
+}
+
+// Sizes every column for nc slots (rounded up to whole done words). A mapped
+// list is copied to the heap, arena included, the first time it must change.
+static void list_resize(TaskList *L, size_t nc) {
+    int mapped = L->map != NULL;
+    nc = (nc + 63) & ~(size_t)63;
+    if (nc < 64) nc = 64;
+    L->id = (int32_t*)col_resize(L->id, L->len * 4, nc * 4, mapped);
+    L->due_day = (int32_t*)col_resize(L->due_day, L->len * 4, nc * 4, mapped);
+    L->priority = (uint8_t*)col_resize(L->priority, L->len, nc, mapped);
+    L->title = (uint32_t*)col_resize(L->title, L->len * 4, nc * 4, mapped);
+    L->done = (uint64_t*)col_resize(L->done, done_words(L->len) * 8, done_words(nc) * 8, mapped);
+    if (mapped) {
+        L->arena = (char*)col_resize(L->arena, L->arena_len, L->arena_len ? L->arena_len : 1, 1);
+        L->arena_cap = L->arena_len;
+        munmap(L->map, L->map_len);
+        L->map = NULL; L->map_len = 0;
+    }
+    L->cap = nc;
+}
+
+static void list_reserve(TaskList *L, size_t want) {
+    if (want <= L->cap) return;
+    size_t nc = L->cap * 2;
+    list_resize(L, nc < want ? want : nc);
+}
+
+static uint32_t arena_put(TaskList *L, const char *s) {
+    size_t n = strlen(s) + 1;
+    if (L->map) list_resize(L, L->len);
+    if (L->arena_len + n > UINT32_MAX) die("title arena full");
+    if (L->arena_len + n > L->arena_cap) {
+        size_t nc = L->arena_cap ? L->arena_cap * 2 : 4096;
+        while (nc < L->arena_len + n) nc *= 2;
+        L->arena = (char*)xrealloc(L->arena, nc);
+        L->arena_cap = nc;
+    }
+    memcpy(L->arena + L->arena_len, s, n);
+    L->arena_len += n;
+    return (uint32_t)(L->arena_len - n);
+}
+
+// Deep copy of the tasks alone; no index, views or search.
+static void list_clone(TaskList *dst, const TaskList *src) {
+    list_init(dst);
+    list_resize(dst, src->len);
+    memcpy(dst->id, src->id, src->len * 4);
+    memcpy(dst->due_day, src->due_day, src->len * 4);
+    memcpy(dst->priority, src->priority, src->len);
+    memcpy(dst->title, src->title, src->len * 4);
+    memcpy(dst->done, src->done, done_words(src->len) * 8);
+    dst->arena = (char*)xmalloc(src->arena_len ? src->arena_len : 1);
+    memcpy(dst->arena, src->arena, src->arena_len);
+    dst->arena_len = dst->arena_cap = src->arena_len;
+    dst->arena_dead = src->arena_dead;
+    dst->len = src->len; dst->live = src->live; dst->max_id = src->max_id;
+    dst->ix_stale = 1; // built on the first lookup
+}
+
+static void list_push(TaskList *L, Task t) {
+    ix_ensure(L);
+    task_normalize(&t);
+    list_invalidate_views(L);
+    if (L->tri) tri_update(L->tri, t.id, NULL, t.title);
+    list_reserve(L, L->len + 1);
+    size_t i = L->len;
+    ix_put(L, t.id, (uint32_t)i);
+    if (t.id > L->max_id) L->max_id = t.id;
+    L->id[i] = t.id;
+    L->due_day[i] = t.due_day;
+    L->priority[i] = (uint8_t)t.priority;
+    uint32_t off = arena_put(L, t.title);
+    L->title[i] = off;
+    list_set_done(L, i, t.done);
+    if (L->sched) sched_set(L->sched, (uint32_t)i, !t.done, t.id, t.due_day, t.priority);
+    if (L->cal) cal_set(L->cal, (uint32_t)i, t.done ? DUE_NONE : t.due_day);
+    L->len++;
+    L->live++;
+}
+
+static int list_find_index_by_id(TaskList *L, int id) {
+    if (id == TASK_DEAD) return -1;
+    ix_ensure(L);
+    return (int)ix_get(L, id);
+}
+
+static int list_next_id(const TaskList *L) {
+    return L->max_id + 1;
+}
+
+// Slides live tasks down over the tombstones, keeping their order, and packs
+// the arena down to the titles still in use.
+static void list_compact(TaskList *L) {
+    if (L->map) list_resize(L, L->len);
+    size_t w = 0, alen = 0, acap = L->arena_len - L->arena_dead + 1;
+    char *arena = (char*)xmalloc(acap);
+    for (size_t r = 0; r < L->len; ++r) {
+        if (!list_live(L, r)) continue;
+        const char *title = list_title(L, r);
+        size_t n = strlen(title) + 1;
+        memcpy(arena + alen, title, n);
+        int done = list_done(L, r);
+        L->id[w] = L->id[r]; L->due_day[w] = L->due_day[r]; L->priority[w] = L->priority[r];
+        L->title[w] = (uint32_t)alen;
+        list_set_done(L, w, done);
+        alen += n; w++;
+    }
+    free(L->arena);
+    L->arena = arena; L->arena_len = alen; L->arena_cap = acap; L->arena_dead = 0;
+    L->len = w;
+    ix_rebuild(L);
+    list_invalidate_views(L);
+    if (L->sched) { int today = L->sched->today; sched_free(L->sched); L->sched = sched_build(L, today); }
+    if (L->cal) { cal_free(L->cal); L->cal = cal_build(L); }
+}
+
+// Overwrites a task in place; the id must not change.
+static void list_replace(TaskList *L, size_t idx, const Task *t) {
+    Task n = *t;
+    task_normalize(&n);
+    if (L->due_day[idx] != n.due_day || L->priority[idx] != n.priority) list_invalidate_views(L);
+    L->due_day[idx] = n.due_day;
+    L->priority[idx] = (uint8_t)n.priority;
+    list_set_done(L, idx, n.done);
+    if (L->sched) sched_set(L->sched, (uint32_t)idx, !n.done, L->id[idx], n.due_day, n.priority);
+    if (L->cal) cal_set(L->cal, (uint32_t)idx, n.done ? DUE_NONE : n.due_day);
+    if (strcmp(list_title(L, idx), n.title) != 0) {
+        if (L->tri) tri_update(L->tri, L->id[idx], list_title(L, idx), n.title);
+        L->arena_dead += strlen(list_title(L, idx)) + 1;
+        uint32_t off = arena_put(L, n.title); // may move the columns off the mapping
+        L->title[idx] = off;
+        if (L->arena_dead >= ARENA_REPACK_MIN && L->arena_dead * 2 > L->arena_len) list_compact(L);
+    }
+}
+
+static void list_delete_at(TaskList *L, size_t idx) {
+    if (idx >= L->len || !list_live(L, idx)) return;
+    ix_ensure(L);
+    ix_del(L, L->id[idx]);
+    if (L->tri) tri_update(L->tri, L->id[idx], list_title(L, idx), NULL);
+    if (L->sched) sched_set(L->sched, (uint32_t)idx, 0, 0, DUE_NONE, 0);
+    if (L->cal) cal_set(L->cal, (uint32_t)idx, DUE_NONE);
+    L->arena_dead += strlen(list_title(L, idx)) + 1;
+    L->id[idx] = TASK_DEAD;
+    L->live--;
+    size_t dead = L->len - L->live;
+    if (idx + 1 == L->len) { while (L->len && !list_live(L, L->len - 1)) L->len--; }
+    else if (dead >= COMPACT_MIN_DEAD && dead > L->live) list_compact(L);
+}
+
+/*---------------- SIMD scanning ----------------*/
+// Vector paths are compiled per function with target attributes and chosen at
+// runtime, so one binary runs everywhere. TODO_SIMD=0 forces the scalar path.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TODO_X86 1
+#include <immintrin.h>
+#endif
+
+enum { SIMD_NONE, SIMD_SSE2, SIMD_AVX2 };
+static int simd_level = -1;
+
+static size_t scan_quote_bs_scalar(const char *p, size_t n) {
+    size_t i = 0;
+    while (i < n && p[i] != '"' && p[i] != '\\') i++;
+    return i;
+}
+
+// Bit i set when p[i] is one of " \ { } [ ]  (n <= 64).
+static uint64_t struct_mask_scalar(const char *p, size_t n) {
+    uint64_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)p[i], l = c | 0x20;
+        if (c=='"' || c=='\\' || l=='{' || l=='}') m |= 1ull << i;
+    }
+    return m;
+}
+
+#ifdef TODO_X86
+__attribute__((target("sse2")))
+static size_t scan_quote_bs_sse2(const char *p, size_t n) {
+    const __m128i q = _mm_set1_epi8('"'), b = _mm_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        int m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, b)));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    return i + scan_quote_bs_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_quote_bs_avx2(const char *p, size_t n) {
+    const __m256i q = _mm256_set1_epi8('"'), b = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, b)));
+        if (m) return i + (size_t)__builtin_ctz(m);
+    }
+    return i + scan_quote_bs_scalar(p + i, n - i);
+}
+
+// '[' ']' '{' '}' are 0x5B 0x5D 0x7B 0x7D: OR-ing 0x20 folds them onto two compares.
+__attribute__((target("sse2")))
+static uint64_t struct_mask_sse2(const char *p, size_t n) {
+    if (n < 64) return struct_mask_scalar(p, n);
+    const __m128i q = _mm_set1_epi8('"'), b = _mm_set1_epi8('\\'), o = _mm_set1_epi8('{'), c = _mm_set1_epi8('}');
+    const __m128i fold = _mm_set1_epi8(0x20);
+    uint64_t m = 0;
+    for (int k = 0; k < 4; ++k) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k)), l = _mm_or_si128(v, fold);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, b)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(l, o), _mm_cmpeq_epi8(l, c)));
+        m |= (uint64_t)(unsigned)_mm_movemask_epi8(hit) << (16 * k);
+    }
+    return m;
+}
+
+__attribute__((target("avx2")))
+static uint64_t struct_mask_avx2(const char *p, size_t n) {
+    if (n < 64) return struct_mask_scalar(p, n);
+    const __m256i q = _mm256_set1_epi8('"'), b = _mm256_set1_epi8('\\'), o = _mm256_set1_epi8('{'), c = _mm256_set1_epi8('}');
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    uint64_t m = 0;
+    for (int k = 0; k < 2; ++k) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + 32 * k)), l = _mm256_or_si256(v, fold);
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, b)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(l, o), _mm256_cmpeq_epi8(l, c)));
+        m |= (uint64_t)(unsigned)_mm256_movemask_epi8(hit) << (32 * k);
+    }
+    return m;
+}
+#endif
+
+// Filters over the columns, 64 slots at a time: bit k of the result is set
+// when slot base+k is live, due before due_limit, at least min_priority and,
+// with only_open, not done. The vector versions need a full block.
+typedef struct { int due_limit, min_priority, only_open; } Filter;
+
+static uint64_t filter_block_scalar(const TaskList *L, const Filter *f, size_t base, size_t n) {
+    uint64_t m = 0;
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = base + k;
+        m |= (uint64_t)(L->id[i] != TASK_DEAD && L->due_day[i] < f->due_limit && L->priority[i] >= f->min_priority) << k;
+    }
+    return f->only_open ? m & ~L->done[base >> 6] : m;
+}
+
+static uint64_t filter_block_full_scalar(const TaskList *L, const Filter *f, size_t base) {
+    return filter_block_scalar(L, f, base, 64);
+}
+
+#ifdef TODO_X86
+__attribute__((target("sse2")))
+static uint64_t filter_block_sse2(const TaskList *L, const Filter *f, size_t base) {
+    const __m128i dead = _mm_set1_epi32(TASK_DEAD), lim = _mm_set1_epi32(f->due_limit);
+    const __m128i minp = _mm_set1_epi8((char)(f->min_priority - 1));
+    uint64_t gone = 0, due = 0, pri = 0;
+    for (int k = 0; k < 64; k += 4) {
+        __m128i id = _mm_loadu_si128((const __m128i*)(L->id + base + k));
+        __m128i d = _mm_loadu_si128((const __m128i*)(L->due_day + base + k));
+        gone |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(id, dead))) << k;
+        due |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(d, lim))) << k;
+    }
+    for (int k = 0; k < 64; k += 16) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(L->priority + base + k));
+        pri |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpgt_epi8(p, minp)) << k;
+    }
+    uint64_t m = ~gone & due & pri;
+    return f->only_open ? m & ~L->done[base >> 6] : m;
+}
+
+__attribute__((target("avx2")))
+static uint64_t filter_block_avx2(const TaskList *L, const Filter *f, size_t base) {
+    const __m256i dead = _mm256_set1_epi32(TASK_DEAD), lim = _mm256_set1_epi32(f->due_limit);
+    const __m256i minp = _mm256_set1_epi8((char)(f->min_priority - 1));
+    uint64_t gone = 0, due = 0, pri = 0;
+    for (int k = 0; k < 64; k += 8) {
+        __m256i id = _mm256_loadu_si256((const __m256i*)(L->id + base + k));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(L->due_day + base + k));
+        gone |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(id, dead))) << k;
+        due |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(lim, d))) << k;
+    }
+    for (int k = 0; k < 64; k += 32) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(L->priority + base + k));
+        pri |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(p, minp)) << k;
+    }
+    uint64_t m = ~gone & due & pri;
+    return f->only_open ? m & ~L->done[base >> 6] : m;
+}
+#endif
+
+static size_t (*scan_quote_bs)(const char *p, size_t n) = scan_quote_bs_scalar;
+static uint64_t (*struct_mask)(const char *p, size_t n) = struct_mask_scalar;
+static uint64_t (*filter_block)(const TaskList *L, const Filter *f, size_t base) = filter_block_full_scalar;
+
+static void simd_force(int level) {
+    simd_level = SIMD_NONE;
+    scan_quote_bs = scan_quote_bs_scalar; struct_mask = struct_mask_scalar; filter_block = filter_block_full_scalar;
+#ifdef TODO_X86
+    if (level == SIMD_AVX2) {
+        simd_level = SIMD_AVX2; scan_quote_bs = scan_quote_bs_avx2; struct_mask = struct_mask_avx2;
+        filter_block = filter_block_avx2;
+    } else if (level == SIMD_SSE2) {
+        simd_level = SIMD_SSE2; scan_quote_bs = scan_quote_bs_sse2; struct_mask = struct_mask_sse2;
+        filter_block = filter_block_sse2;
+    }
+#else
+    (void)level;
+#endif
+}
+
+static void simd_init(void) {
+    if (simd_level >= 0) return;
+    int level = SIMD_NONE;
+    const char *env = getenv("TODO_SIMD");
+#ifdef TODO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) level = SIMD_AVX2;
+    else if (__builtin_cpu_supports("sse2")) level = SIMD_SSE2;
+#endif
+    if (env && strcmp(env, "0") == 0) level = SIMD_NONE;
+    simd_force(level);
+}
+
+// Selection bitmap over all slots: (len + 63) / 64 words.
+static void filter_select(const TaskList *L, const Filter *f, uint64_t *sel) {
+    simd_init();
+    size_t full = L->len / 64;
+    for (size_t w = 0; w < full; ++w) sel[w] = filter_block(L, f, w * 64);
+    if (L->len % 64) sel[full] = filter_block_scalar(L, f, full * 64, L->len % 64);
+}
+
+/*---------------- Compressed files ----------------*/
+// A store whose name ends in .gz is written gzip-compressed, and a gzip file
+// is read as such whatever it is called. zlib runs on a helper thread joined
+// to the reader or writer by a pipe, so compression overlaps with parsing or
+// formatting and neither side holds more than a chunk of the file. Without
+// HAVE_ZLIB (build with -DHAVE_ZLIB -lz) compressed files are refused.
+#define GZ_CHUNK (256 * 1024)
+#define GZ_LEVEL 6
+#define GZ_PIPE_BYTES (1 << 20)
+
+typedef struct {
+    int file;        // the compressed side
+    int pipe[2];
+    int active;      // a helper thread is running
+    int err;         // errno-style, set by the helper
+    int corrupt;     // zlib rejected the data or it ended mid-stream
+    pthread_t th;
+} GzStream;
+
+static int is_gzip_path(const char *path) {
+    size_t n = strlen(path);
+    return n > 3 && strcmp(path + n - 3, ".gz") == 0;
+}
+
+static int gz_magic(int fd) {
+    unsigned char m[2];
+    return pread(fd, m, 2, 0) == 2 && m[0] == 0x1f && m[1] == 0x8b;
+}
+
+#ifdef HAVE_ZLIB
+static int fd_write_all(int fd, const unsigned char *p, size_t n) {
+    while (n) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0) { if (errno == EINTR) continue; return errno; }
+        p += k; n -= (size_t)k;
+    }
+    return 0;
+}
+
+static ssize_t fd_read(int fd, unsigned char *p, size_t n) {
+    ssize_t k;
+    while ((k = read(fd, p, n)) < 0 && errno == EINTR) {}
+    return k;
+}
+
+// file -> pipe. Concatenated gzip members are read as one stream.
+static void *gz_inflate_main(void *arg) {
+    GzStream *g = (GzStream*)arg;
+    unsigned char *in = (unsigned char*)xmalloc(GZ_CHUNK), *out = (unsigned char*)xmalloc(GZ_CHUNK);
+    z_stream z; memset(&z, 0, sizeof z);
+    int ended = 0;
+    if (inflateInit2(&z, 15 + 32) != Z_OK) g->err = ENOMEM;
+    while (!g->err) {
+        if (!z.avail_in) {
+            ssize_t k = fd_read(g->file, in, GZ_CHUNK);
+            if (k < 0) { g->err = errno; break; }
+            if (k == 0) break;
+            z.next_in = in; z.avail_in = (uInt)k;
+        }
+        if (ended) { inflateReset(&z); ended = 0; }
+        z.next_out = out; z.avail_out = GZ_CHUNK;
+        int rc = inflate(&z, Z_NO_FLUSH);
+        if (rc == Z_STREAM_END) ended = 1;
+        else if (rc != Z_OK && rc != Z_BUF_ERROR) { g->corrupt = 1; break; }
+        g->err = fd_write_all(g->pipe[1], out, GZ_CHUNK - z.avail_out);
+    }
+    if (!g->err && !ended) g->corrupt = 1; // cut short
+    inflateEnd(&z);
+    close(g->pipe[1]);
+    free(in); free(out);
+    return NULL;
+}
+
+// pipe -> file. After a write error the pipe is still drained so the
+// writer never blocks.
+static void *gz_deflate_main(void *arg) {
+    GzStream *g = (GzStream*)arg;
+    unsigned char *in = (unsigned char*)xmalloc(GZ_CHUNK), *out = (unsigned char*)xmalloc(GZ_CHUNK);
+    z_stream z; memset(&z, 0, sizeof z);
+    if (deflateInit2(&z, GZ_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) g->err = ENOMEM;
+    for (;;) {
+        ssize_t k = fd_read(g->pipe[0], in, GZ_CHUNK);
+        if (k < 0) { g->err = errno; break; }
+        if (g->err) { if (k == 0) break; continue; }
+        z.next_in = in; z.avail_in = (uInt)k;
+        do {
+            z.next_out = out; z.avail_out = GZ_CHUNK;
+            deflate(&z, k ? Z_NO_FLUSH : Z_FINISH);
+            if (!g->err) g->err = fd_write_all(g->file, out, GZ_CHUNK - z.avail_out);
+        } while (!z.avail_out);
+        if (k == 0) break;
+    }
+    deflateEnd(&z);
+    free(in); free(out);
+    return NULL;
+}
+
+static int gz_start(GzStream *g, int file, void *(*run)(void*)) {
+    memset(g, 0, sizeof *g);
+    g->file = file;
+    if (pipe(g->pipe) != 0) { perror("pipe"); return 0; }
+#ifdef F_SETPIPE_SZ
+    fcntl(g->pipe[1], F_SETPIPE_SZ, GZ_PIPE_BYTES); // fewer handoffs; best effort
+#endif
+    if (pthread_create(&g->th, NULL, run, g) != 0) { close(g->pipe[0]); close(g->pipe[1]); perror("pthread_create"); return 0; }
+    g->active = 1;
+    return 1;
+}
+#else
+static void gz_missing(void) {
+    fprintf(stderr, "Compressed stores need a build with -DHAVE_ZLIB -lz\n");
+}
+#endif
+
+// The fd to read plain bytes from: fd itself, or the read end of a pipe fed
+// by an inflating thread if fd holds gzip data. -1 on failure.
+static int gz_read_begin(GzStream *g, int fd) {
+    memset(g, 0, sizeof *g);
+    if (!gz_magic(fd)) return fd;
+#ifdef HAVE_ZLIB
+    return gz_start(g, fd, gz_inflate_main) ? g->pipe[0] : -1;
+#else
+    gz_missing();
+    return -1;
+#endif
+}
+
+// Drains and closes the pipe; returns 0 if the data was damaged.
+static int gz_read_end(GzStream *g) {
+    if (!g->active) return 1;
+#ifdef HAVE_ZLIB
+    unsigned char sink[4096];
+    while (fd_read(g->pipe[0], sink, sizeof sink) > 0) {}
+    close(g->pipe[0]);
+    pthread_join(g->th, NULL);
+    g->active = 0;
+    if (g->err) { errno = g->err; perror("gzip"); }
+    else if (g->corrupt) fprintf(stderr, "gzip: compressed data is corrupt or truncated\n");
+#endif
+    return !g->err && !g->corrupt;
+}
+
+// The fd to write plain bytes to so that they reach fd compressed; -1 on
+// failure.
+static int gz_write_begin(GzStream *g, int fd) {
+#ifdef HAVE_ZLIB
+    return gz_start(g, fd, gz_deflate_main) ? g->pipe[1] : -1;
+#else
+    (void)fd;
+    memset(g, 0, sizeof *g);
+    gz_missing();
+    return -1;
+#endif
+}
+
+// Flushes the compressor; returns an errno value, 0 if all went out.
+static int gz_write_end(GzStream *g) {
+    if (!g->active) return 0;
+    close(g->pipe[1]);
+    pthread_join(g->th, NULL);
+    close(g->pipe[0]);
+    g->active = 0;
+    return g->err;
+}
+
+/*---------------- JSON writer ----------------*/
+// Tasks are formatted into one large buffer that is reused across saves and
+// drained with a few big write() calls. The file is written under a temporary
+// name, fsync'd, and renamed over the original, so a crash mid-save leaves the
+// previous tasks.json intact.
+#define WBUF_CAP (1u << 20)
+
+typedef struct { int fd; char *buf; size_t len, cap; int err; } WBuf;
+
+static char *g_wbuf; // reused by every save
+
+static void wb_init(WBuf *w, int fd) {
+    if (!g_wbuf) g_wbuf = (char*)xmalloc(WBUF_CAP);
+    w->fd = fd; w->buf = g_wbuf; w->len = 0; w->cap = WBUF_CAP; w->err = 0;
+}
+
+// A WBuf with no fd grows in memory instead of flushing (daemon replies).
+static void wb_init_mem(WBuf *w, size_t cap) {
+    w->fd = -1; w->buf = (char*)xmalloc(cap); w->len = 0; w->cap = cap; w->err = 0;
+}
+
+static void write_all(WBuf *w, const char *p, size_t n) {
+    while (n && !w->err) {
+        ssize_t k = write(w->fd, p, n);
+        if (k < 0) { if (errno == EINTR) continue; w->err = errno; return; }
+        p += k; n -= (size_t)k;
+    }
+}
+
+static void wb_flush(WBuf *w) {
+    write_all(w, w->buf, w->len);
+    w->len = 0;
+}
+
+static void wb_put(WBuf *w, const char *s, size_t n) {
+    if (w->len + n > w->cap) {
+        if (w->fd < 0) {
+            while (w->len + n > w->cap) w->cap *= 2;
+            w->buf = (char*)xrealloc(w->buf, w->cap);
+        } else {
+            wb_flush(w);
+            if (n > w->cap) { write_all(w, s, n); return; }
+        }
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+#define WB_LIT(w, s) wb_put((w), (s), sizeof(s) - 1)
+
+static void wb_int(WBuf *w, int v) {
+    char tmp[12], *e = tmp + sizeof tmp, *p = e;
+    unsigned u = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+    do { *--p = (char)('0' + u % 10); u /= 10; } while (u);
+    if (v < 0) *--p = '-';
+    wb_put(w, p, (size_t)(e - p));
+}
+
+// Index of the first byte that JSON needs escaped (" \ or < 0x20), or n.
+static size_t scan_json_escape_scalar(const char *p, size_t n) {
+    size_t i = 0;
+    while (i < n && p[i] != '"' && p[i] != '\\' && (unsigned char)p[i] >= 0x20) i++;
+    return i;
+}
+
+#ifdef TODO_X86
+__attribute__((target("sse2")))
+static size_t scan_json_escape_sse2(const char *p, size_t n) {
+    const __m128i q = _mm_set1_epi8('"'), b = _mm_set1_epi8('\\'), ctl = _mm_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i low = _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl); // v <= 0x1F, unsigned
+        int m = _mm_movemask_epi8(_mm_or_si128(low, _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, b))));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    return i + scan_json_escape_scalar(p + i, n - i);
+}
+#endif
+
+static size_t scan_json_escape(const char *p, size_t n) {
+#ifdef TODO_X86
+    if (simd_level > SIMD_NONE) return scan_json_escape_sse2(p, n);
+#endif
+    return scan_json_escape_scalar(p, n);
+}
+
+static void wb_json_str(WBuf *w, const char *s) {
+    size_t n = strlen(s);
+    WB_LIT(w, "\"");
+    while (n) {
+        size_t k = scan_json_escape(s, n);
+        wb_put(w, s, k);
+        s += k; n -= k;
+        if (!n) break;
+        unsigned char c = (unsigned char)*s++; n--;
+        switch (c) {
+            case '\\': WB_LIT(w, "\\\\"); break;
+            case '"': WB_LIT(w, "\\\""); break;
+            case '\n': WB_LIT(w, "\\n"); break;
+            case '\r': WB_LIT(w, "\\r"); break;
+            case '\t': WB_LIT(w, "\\t"); break;
+            default: {
+                static const char hex[] = "0123456789abcdef";
+                char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+                wb_put(w, u, sizeof u);
+            }
+        }
+    }
+    WB_LIT(w, "\"");
+}
+
+static void wb_task_fields(WBuf *w, int id, const char *title, int due_day, int priority, int done, int last) {
+    char due[DATE_LEN + 1];
+    day_to_date(due_day, due);
+    WB_LIT(w, "  { \"id\": "); wb_int(w, id);
+    WB_LIT(w, ", \"title\": "); wb_json_str(w, title);
+    WB_LIT(w, ", \"due\": "); wb_json_str(w, due);
+    WB_LIT(w, ", \"priority\": "); wb_int(w, priority);
+    if (done) WB_LIT(w, ", \"done\": true }"); else WB_LIT(w, ", \"done\": false }");
+    if (last) WB_LIT(w, "\n"); else WB_LIT(w, ",\n");
+}
+
+static void wb_task(WBuf *w, const TaskList *L, size_t i, int last) {
+    wb_task_fields(w, L->id[i], list_title(L, i), L->due_day[i], L->priority[i], list_done(L, i), last);
+}
+
+// fsync of the directory makes the rename itself durable.
+static void fsync_parent_dir(const char *path) {
+    char dir[4096];
+    const char *slash = strrchr(path, '/');
+    if (!slash) strcpy(dir, ".");
+    else if (slash == path) strcpy(dir, "/");
+    else { size_t n = (size_t)(slash - path); if (n >= sizeof dir) return; memcpy(dir, path, n); dir[n] = '\0'; }
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+// Opens a temporary file next to path, with path's mode if it already exists.
+static int open_replacement(const char *path, char *tmp, size_t tmpsz) {
+    if ((size_t)snprintf(tmp, tmpsz, "%s.tmp.XXXXXX", path) >= tmpsz) { errno = ENAMETOOLONG; return -1; }
+    int fd = mkstemp(tmp);
+    if (fd < 0) return -1;
+    struct stat st;
+    fchmod(fd, stat(path, &st) == 0 ? (st.st_mode & 07777) : 0644);
+    return fd;
+}
+
+// Makes tmp durable and moves it over path; unlinks tmp on any failure.
+static int commit_replacement(int fd, const char *tmp, const char *path, int err) {
+    if (!err && fsync(fd) != 0) err = errno;
+    if (close(fd) != 0 && !err) err = errno;
+    if (!err && rename(tmp, path) != 0) err = errno;
+    if (err) { unlink(tmp); errno = err; perror("save"); return 0; }
+    fsync_parent_dir(path);
+    return 1;
+}
+
+static int save_json(const char *path, const TaskList *L) {
+    simd_init();
+    char tmp[4096];
+    int fd = open_replacement(path, tmp, sizeof tmp);
+    if (fd < 0) { perror("open"); return 0; }
+    GzStream g;
+    int out = is_gzip_path(path) ? gz_write_begin(&g, fd) : fd;
+    if (out < 0) { close(fd); unlink(tmp); return 0; }
+    WBuf w; wb_init(&w, out);
+    WB_LIT(&w, "[\n");
+    size_t left = L->live;
+    for (size_t i = 0; i < L->len && !w.err; ++i) {
+        if (!list_live(L, i)) continue;
+        wb_task(&w, L, i, --left == 0);
+    }
+    WB_LIT(&w, "]\n");
+    wb_flush(&w);
+    int err = out != fd ? gz_write_end(&g) : 0;
+    return commit_replacement(fd, tmp, path, w.err ? w.err : err);
+}
+
+/*---------------- Streaming JSON reader ----------------*/
+// Push parser for [ {task}, ... ]. Bytes can be fed in chunks of any size; the
+// lexer and grammar state survive chunk boundaries, and each task is handed to
+// the sink as soon as its closing brace is seen. Memory use is one task plus
+// the caller's chunk, whatever the file size.
+
+typedef void (*TaskSink)(void *ctx, const Task *t);
+
+enum { PS_START, PS_ARRAY_FIRST, PS_ELEM, PS_ARRAY_NEXT, PS_KEY, PS_COLON, PS_VALUE, PS_OBJ_NEXT, PS_DONE, PS_ERROR };
+enum { LX_NONE, LX_STR, LX_ESC, LX_UHEX, LX_NUM, LX_LIT, LX_SKIP };
+enum { F_OTHER, F_ID, F_TITLE, F_DUE, F_PRIORITY, F_DONE, F_KEY };
+
+typedef struct {
+    int st, lx;
+    int field;                  // what the current token is for (F_*)
+    char *sbuf; size_t scap, slen;
+    char scratch[2];            // sink for strings nobody wants
+    int uhex;
+    long num; int neg, ndig;
+    const char *lit; int lit_i, lit_val;
+    int depth, skip_str, skip_esc;
+    char key[32];
+    Task cur;
+    TaskSink sink; void *ctx;
+} TaskStream;
+
+static void ts_init(TaskStream *ts, TaskSink sink, void *ctx) {
+    memset(ts, 0, sizeof *ts);
+    ts->st = PS_START; ts->lx = LX_NONE;
+    ts->sink = sink; ts->ctx = ctx;
+}
+
+static int ts_fail(TaskStream *ts) { ts->st = PS_ERROR; return 0; }
+
+static void ts_begin_str(TaskStream *ts, char *dst, size_t cap) {
+    ts->sbuf = dst; ts->scap = cap; ts->slen = 0;
+    ts->lx = LX_STR;
+}
+
+// Over-long strings are truncated to the destination, like the old reader.
+static void ts_str_append(TaskStream *ts, const char *p, size_t n) {
+    size_t room = ts->scap - 1 - ts->slen;
+    if (n > room) n = room;
+    memcpy(ts->sbuf + ts->slen, p, n);
+    ts->slen += n;
+}
+
+static int field_of_key(const char *k) {
+    if (strcmp(k,"id")==0) return F_ID;
+    if (strcmp(k,"title")==0) return F_TITLE;
+    if (strcmp(k,"due")==0) return F_DUE;
+    if (strcmp(k,"priority")==0) return F_PRIORITY;
+    if (strcmp(k,"done")==0) return F_DONE;
+    return F_OTHER;
+}
+
+static void ts_value_done(TaskStream *ts) {
+    ts->lx = LX_NONE;
+    if (ts->field == F_KEY) { ts->st = PS_COLON; return; }
+    if (ts->field == F_ID) ts->cur.id = (int)(ts->neg ? -ts->num : ts->num);
+    else if (ts->field == F_PRIORITY) ts->cur.priority = (int)(ts->neg ? -ts->num : ts->num);
+    else if (ts->field == F_DONE) ts->cur.done = ts->lit_val;
+    ts->st = PS_OBJ_NEXT;
+}
+
+static int ts_end_object(TaskStream *ts) {
+    int p = ts->cur.priority;
+    if (!p) ts->cur.priority = 3;
+    else if (p < 1 || p > 5) {
+        ts->cur.priority = p < 1 ? 1 : 5;
+        fprintf(stderr, "Task %d: priority %d is outside 1-5, using %d\n", ts->cur.id, p, ts->cur.priority);
+    }
+    if (!valid_date(ts->cur.due)) return ts_fail(ts);
+    ts->sink(ts->ctx, &ts->cur);
+    ts->st = PS_ARRAY_NEXT;
+    return 1;
+}
+
+static int ts_begin_value(TaskStream *ts, unsigned char c) {
+    int f = ts->field;
+    if (c=='"' && (f==F_TITLE || f==F_DUE || f==F_OTHER)) {
+        if (f==F_TITLE) ts_begin_str(ts, ts->cur.title, sizeof ts->cur.title);
+        else if (f==F_DUE) ts_begin_str(ts, ts->cur.due, sizeof ts->cur.due);
+        else ts_begin_str(ts, ts->scratch, sizeof ts->scratch);
+        return 1;
+    }
+    if ((c=='-' || isdigit(c)) && (f==F_ID || f==F_PRIORITY || f==F_OTHER)) {
+        ts->num = 0; ts->ndig = 0; ts->neg = 0;
+        ts->lx = LX_NUM;
+        return 2; // digit is consumed by the number lexer itself
+    }
+    if ((c=='t' || c=='f') && (f==F_DONE || f==F_OTHER)) {
+        ts->lit = c=='t' ? "true" : "false"; ts->lit_val = c=='t'; ts->lit_i = 0;
+        ts->lx = LX_LIT;
+        return 2;
+    }
+    if (c=='n' && f==F_OTHER) { ts->lit = "null"; ts->lit_i = 0; ts->lx = LX_LIT; return 2; }
+    if ((c=='{' || c=='[') && f==F_OTHER) {
+        ts->depth = 1; ts->skip_str = ts->skip_esc = 0;
+        ts->lx = LX_SKIP;
+        return 1;
+    }
+    return ts_fail(ts);
+}
+
+// Returns 0 on malformed input. Bytes after the closing ']' are ignored.
+static int ts_feed(TaskStream *ts, const char *p, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        if (ts->st == PS_ERROR) return 0;
+        if (ts->st == PS_DONE) return 1;
+        unsigned char c = (unsigned char)p[i];
+        switch (ts->lx) {
+        case LX_STR: {
+            size_t j = i + scan_quote_bs(p + i, n - i);
+            ts_str_append(ts, p + i, j - i);
+            i = j;
+            if (i == n) continue;
+            if (p[i++] == '\\') { ts->lx = LX_ESC; continue; }
+            ts->sbuf[ts->slen] = '\0';
+            ts_value_done(ts);
+            continue;
+        }
+        case LX_ESC: {
+            char e;
+            switch (c) {
+                case '"': e='"'; break;
+                case '\\': e='\\'; break;
+                case '/': e='/'; break;
+                case 'b': e='\b'; break;
+                case 'f': e='\f'; break;
+                case 'n': e='\n'; break;
+                case 'r': e='\r'; break;
+                case 't': e='\t'; break;
+                case 'u': ts->uhex = 4; ts->lx = LX_UHEX; i++; continue;
+                default: return ts_fail(ts);
+            }
+            ts_str_append(ts, &e, 1);
+            ts->lx = LX_STR; i++;
+            continue;
+        }
+        case LX_UHEX:
+            // Skip 4 hex digits, store '?'
+            i++;
+            if (--ts->uhex == 0) { ts_str_append(ts, "?", 1); ts->lx = LX_STR; }
+            continue;
+        case LX_NUM:
+            if (c=='-' && ts->ndig==0 && !ts->neg) { ts->neg = 1; i++; continue; }
+            if (isdigit(c)) {
+                ts->num = ts->num * 10 + (c - '0'); ts->ndig++;
+                if (ts->num > 2147483647L) return ts_fail(ts);
+                i++; continue;
+            }
+            if (!ts->ndig) return ts_fail(ts);
+            ts_value_done(ts);
+            continue; // c belongs to the grammar
+        case LX_LIT:
+            if (c != (unsigned char)ts->lit[ts->lit_i]) return ts_fail(ts);
+            i++;
+            if (!ts->lit[++ts->lit_i]) ts_value_done(ts);
+            continue;
+        case LX_SKIP:
+            if (ts->skip_str) {
+                if (ts->skip_esc) ts->skip_esc = 0;
+                else if (c=='\\') ts->skip_esc = 1;
+                else if (c=='"') ts->skip_str = 0;
+            } else if (c=='"') ts->skip_str = 1;
+            else if (c=='{' || c=='[') ts->depth++;
+            else if ((c=='}' || c==']') && --ts->depth == 0) ts_value_done(ts);
+            i++;
+            continue;
+        default: break;
+        }
+
+        if (isspace(c)) { i++; continue; }
+        switch (ts->st) {
+        case PS_START:
+            if (c != '[') return ts_fail(ts);
+            ts->st = PS_ARRAY_FIRST; break;
+        case PS_ARRAY_FIRST:
+            if (c == ']') { ts->st = PS_DONE; break; }
+            /* fallthrough */
+        case PS_ELEM:
+            if (c != '{') return ts_fail(ts);
+            memset(&ts->cur, 0, sizeof ts->cur);
+            ts->st = PS_KEY; break;
+        case PS_KEY:
+            if (c != '"') return ts_fail(ts);
+            ts->field = F_KEY;
+            ts_begin_str(ts, ts->key, sizeof ts->key); break;
+        case PS_COLON:
+            if (c != ':') return ts_fail(ts);
+            ts->field = field_of_key(ts->key);
+            ts->st = PS_VALUE; break;
+        case PS_VALUE: {
+            int r = ts_begin_value(ts, c);
+            if (!r) return 0;
+            if (r == 2) continue; // lexer consumes c
+            break;
+        }
+        case PS_OBJ_NEXT:
+            if (c == ',') { ts->st = PS_KEY; break; }
+            if (c != '}' || !ts_end_object(ts)) return ts_fail(ts);
+            break;
+        case PS_ARRAY_NEXT:
+            if (c == ',') { ts->st = PS_ELEM; break; }
+            if (c != ']') return ts_fail(ts);
+            ts->st = PS_DONE; break;
+        default:
+            return ts_fail(ts);
+        }
+        i++;
+    }
+    return ts->st != PS_ERROR;
+}
+
+static int ts_finish(const TaskStream *ts) { return ts->st == PS_DONE; }
+
+#define LOAD_CHUNK (64 * 1024)
+
+// Streams the file through the parser one fixed-size chunk at a time,
+// inflating it on the way if it is compressed.
+static int stream_tasks(const char *path, TaskSink sink, void *ctx) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 1; // no file -> empty list is fine
+    GzStream g;
+    int in = gz_read_begin(&g, fd);
+    if (in < 0) { close(fd); return 0; }
+    char *buf = (char*)xmalloc(LOAD_CHUNK);
+    TaskStream ts; ts_init(&ts, sink, ctx);
+    int ok = 1;
+    ssize_t rd = 0;
+    while (ok && ts.st != PS_DONE && ((rd = read(in, buf, LOAD_CHUNK)) > 0 || (rd < 0 && errno == EINTR)))
+        if (rd > 0) ok = ts_feed(&ts, buf, (size_t)rd);
+    if (rd < 0) ok = 0;
+    ok = gz_read_end(&g) && ok;
+    close(fd);
+    free(buf);
+    return ok && ts_finish(&ts);
+}
+
+static void sink_push(void *ctx, const Task *t) { list_push((TaskList*)ctx, *t); }
+
+/*---------------- Parallel chunked load ----------------*/
+// Large files are mapped, cut into runs of whole task objects by a vectorized
+// structural scan, parsed by the same TaskStream on several threads, and the
+// per-thread results appended to the list in file order.
+#define PAR_MIN_BYTES (1u << 20)
+#define PAR_MAX_THREADS 16
+
+// Cuts buf into at most `parts` pieces, each ending right after a task's '}'.
+// Only quote, backslash and bracket bytes are visited, 64 at a time.
+static int find_splits(const char *buf, size_t n, int parts, size_t *cut) {
+    int depth = 0, in_str = 0, k = 1;
+    size_t skip = (size_t)-1; // byte escaped by a backslash
+    size_t target = n / (size_t)parts;
+    cut[0] = 0;
+    for (size_t base = 0; base < n && k < parts; base += 64) {
+        size_t w = n - base < 64 ? n - base : 64;
+        uint64_t m = struct_mask(buf + base, w);
+        while (m) {
+            size_t pos = base + (size_t)__builtin_ctzll(m);
+            m &= m - 1;
+            if (pos == skip) continue;
+            char c = buf[pos];
+            if (in_str) {
+                if (c == '\\') skip = pos + 1;
+                else if (c == '"') in_str = 0;
+                continue;
+            }
+            if (c == '"') { in_str = 1; continue; }
+            if (c == '{' || c == '[') { depth++; continue; }
+            depth--;
+            if (depth <= 0) { base = n; break; } // array closed: the rest belongs to the last piece
+            if (depth == 1 && c == '}' && pos + 1 >= target) {
+                cut[k++] = pos + 1;
+                if (k == parts) break;
+                target = n / (size_t)parts * (size_t)k;
+            }
+        }
+    }
+    cut[k] = n;
+    return k;
+}
+
+typedef struct {
+    const char *p; size_t n;
+    int first, last, ok;
+    Task *out; size_t len, cap;
+} ParsePart;
+
+static void sink_part(void *ctx, const Task *t) {
+    ParsePart *pp = (ParsePart*)ctx;
+    if (pp->len == pp->cap) {
+        pp->cap = pp->cap ? pp->cap * 2 : 1024;
+        pp->out = (Task*)xrealloc(pp->out, pp->cap * sizeof(Task));
+    }
+    pp->out[pp->len++] = *t;
+}
+
+static void *parse_part(void *arg) {
+    ParsePart *pp = (ParsePart*)arg;
+    TaskStream ts; ts_init(&ts, sink_part, pp);
+    if (!pp->first) ts.st = PS_ARRAY_NEXT; // piece starts after a '}' of the array
+    pp->ok = ts_feed(&ts, pp->p, pp->n);
+    if (pp->ok) pp->ok = pp->last ? ts_finish(&ts) : (ts.st == PS_ARRAY_NEXT && ts.lx == LX_NONE);
+    return NULL;
+}
+
+// Returns -1 when the split found no useful parallelism, so the caller can
+// stream instead; otherwise 1/0 like load_tasks.
+static int parse_buffer_parallel(const char *buf, size_t n, TaskList *L, int threads) {
+    size_t cut[PAR_MAX_THREADS + 1];
+    if (threads > PAR_MAX_THREADS) threads = PAR_MAX_THREADS;
+    int parts = find_splits(buf, n, threads, cut);
+    if (parts < 2) return -1;
+    ParsePart pp[PAR_MAX_THREADS];
+    pthread_t tid[PAR_MAX_THREADS];
+    int started[PAR_MAX_THREADS] = {0};
+    for (int k = 0; k < parts; ++k) {
+        memset(&pp[k], 0, sizeof pp[k]);
+        pp[k].p = buf + cut[k]; pp[k].n = cut[k + 1] - cut[k];
+        pp[k].first = k == 0; pp[k].last = k == parts - 1;
+        if (k) started[k] = pthread_create(&tid[k], NULL, parse_part, &pp[k]) == 0;
+    }
+    parse_part(&pp[0]);
+    for (int k = 1; k < parts; ++k) {
+        if (started[k]) pthread_join(tid[k], NULL);
+        else parse_part(&pp[k]);
+    }
+    int ok = 1;
+    size_t total = 0;
+    for (int k = 0; k < parts; ++k) { ok = ok && pp[k].ok; total += pp[k].len; }
+    if (ok) {
+        list_reserve(L, L->len + total);
+        for (int k = 0; k < parts; ++k) for (size_t i = 0; i < pp[k].len; ++i) list_push(L, pp[k].out[i]);
+    }
+    for (int k = 0; k < parts; ++k) free(pp[k].out);
+    return ok;
+}
+
+static int load_threads(void) {
+    const char *env = getenv("TODO_THREADS");
+    long n = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    return n > PAR_MAX_THREADS ? PAR_MAX_THREADS : (int)n;
+}
+
+static int load_tasks_parallel(const char *path, TaskList *L, int threads) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)PAR_MIN_BYTES || gz_magic(fd)) { close(fd); return -1; }
+    size_t n = (size_t)st.st_size;
+    void *map = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    int r = parse_buffer_parallel((const char*)map, n, L, threads);
+    munmap(map, n);
+    return r;
+}
+
+static int load_json(const char *path, TaskList *L) {
+    simd_init();
+    int threads = load_threads();
+    // Without vector scanning the pre-pass costs about as much as parsing.
+    if (simd_level > SIMD_NONE && threads > 1) {
+        int r = load_tasks_parallel(path, L, threads);
+        if (r >= 0) return r;
+    }
+    return stream_tasks(path, sink_push, L);
+}
+
+/*---------------- Binary snapshot ----------------*/
+// A .tdb file is a fixed header followed by the TaskList columns of the live
+// tasks and their title arena, each section padded to 8 bytes, so loading is
+// one mmap and the columns are used where they lie:
+//   id[n] i32 | due_day[n] i32 | title[n] u32 | priority[n] u8 | done[(n+63)/64] u64 | arena
+// The mapping is MAP_PRIVATE, so edits land in private copies of the touched
+// pages and the file only changes through save_tasks. The format is native
+// byte order; the header pins it and anything else is refused (convert
+// through JSON to move a store between machines).
+#define SNAP_MAGIC "TODOSNAP"
+#define SNAP_VERSION 3u
+#define SNAP_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t byte_order;
+    uint32_t reserved0;
+    uint64_t count;
+    uint64_t arena_len;
+    int32_t max_id;
+    uint32_t reserved[4];
+    uint32_t crc;        // crc32 of the bytes above
+} SnapHeader;
+
+enum { SNAP_ID, SNAP_DUE, SNAP_TITLE, SNAP_PRIORITY, SNAP_DONE, SNAP_ARENA, SNAP_END };
+
+static uint64_t pad8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+static void snap_layout(uint64_t n, uint64_t arena_len, uint64_t off[SNAP_END + 1]) {
+    off[SNAP_ID] = sizeof(SnapHeader);
+    off[SNAP_DUE] = off[SNAP_ID] + pad8(n * 4);
+    off[SNAP_TITLE] = off[SNAP_DUE] + pad8(n * 4);
+    off[SNAP_PRIORITY] = off[SNAP_TITLE] + pad8(n * 4);
+    off[SNAP_DONE] = off[SNAP_PRIORITY] + pad8(n);
+    off[SNAP_ARENA] = off[SNAP_DONE] + done_words((size_t)n) * 8;
+    off[SNAP_END] = off[SNAP_ARENA] + arena_len;
+}
+
+static int is_snapshot_path(const char *path) {
+    size_t n = strlen(path);
+    return n >= 4 && strcmp(path + n - 4, ".tdb") == 0;
+}
+
+static void snap_header(SnapHeader *h, size_t count, size_t arena_len, int max_id) {
+    memset(h, 0, sizeof *h);
+    memcpy(h->magic, SNAP_MAGIC, sizeof h->magic);
+    h->version = SNAP_VERSION;
+    h->header_size = (uint32_t)sizeof *h;
+    h->byte_order = SNAP_BYTE_ORDER;
+    h->count = count;
+    h->arena_len = arena_len;
+    h->max_id = max_id;
+    h->crc = crc32_buf((const unsigned char*)h, offsetof(SnapHeader, crc));
+}
+
+static void wb_pad8(WBuf *w, size_t written) {
+    static const char zero[8];
+    wb_put(w, zero, (size_t)(pad8(written) - written));
+}
+
+// The live entries of a fixed-width column, in runs between tombstones.
+static void snap_column(WBuf *w, const TaskList *L, const void *col, size_t width) {
+    const char *base = (const char*)col;
+    for (size_t i = 0; i < L->len && !w->err; ) {
+        while (i < L->len && !list_live(L, i)) i++;
+        size_t run = i;
+        while (i < L->len && list_live(L, i)) i++;
+        if (i > run) wb_put(w, base + run * width, (i - run) * width);
+    }
+    wb_pad8(w, L->live * width);
+}
+
+static int save_snapshot(const char *path, const TaskList *L) {
+    char tmp[4096];
+    int fd = open_replacement(path, tmp, sizeof tmp);
+    if (fd < 0) { perror("open"); return 0; }
+    WBuf w; wb_init(&w, fd);
+    SnapHeader h; snap_header(&h, L->live, L->arena_len - L->arena_dead, L->max_id);
+    wb_put(&w, (const char*)&h, sizeof h);
+    snap_column(&w, L, L->id, 4);
+    snap_column(&w, L, L->due_day, 4);
+    // Titles are repacked, so offsets are recomputed in the same order.
+    uint32_t off = 0;
+    for (size_t i = 0; i < L->len && !w.err; ++i) {
+        if (!list_live(L, i)) continue;
+        wb_put(&w, (const char*)&off, 4);
+        off += (uint32_t)strlen(list_title(L, i)) + 1;
+    }
+    wb_pad8(&w, L->live * 4);
+    snap_column(&w, L, L->priority, 1);
+    uint64_t word = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < L->len && !w.err; ++i) {
+        if (!list_live(L, i)) continue;
+        word |= (uint64_t)list_done(L, i) << (k & 63);
+        if ((++k & 63) == 0) { wb_put(&w, (const char*)&word, 8); word = 0; }
+    }
+    if (k & 63) wb_put(&w, (const char*)&word, 8);
+    for (size_t i = 0; i < L->len && !w.err; ++i) {
+        if (!list_live(L, i)) continue;
+        const char *t = list_title(L, i);
+        wb_put(&w, t, strlen(t) + 1);
+    }
+    wb_flush(&w);
+    return commit_replacement(fd, tmp, path, w.err);
+}
+
+// 1 loaded, 0 a snapshot that cannot be used, -1 not a snapshot.
+static int load_snapshot(const char *path, TaskList *L) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    SnapHeader h;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof h, 0) != (ssize_t)sizeof h
+        || memcmp(h.magic, SNAP_MAGIC, sizeof h.magic) != 0) { close(fd); return -1; }
+    uint64_t off[SNAP_END + 1];
+    int ok = h.crc == crc32_buf((const unsigned char*)&h, offsetof(SnapHeader, crc))
+        && h.version == SNAP_VERSION && h.header_size == sizeof h && h.byte_order == SNAP_BYTE_ORDER
+        && h.max_id >= 0 && h.count <= (uint64_t)st.st_size && h.arena_len <= (uint64_t)st.st_size
+        && h.count <= UINT32_MAX && h.arena_len <= UINT32_MAX;
+    if (ok) snap_layout(h.count, h.arena_len, off);
+    if (!ok || off[SNAP_END] != (uint64_t)st.st_size) {
+        fprintf(stderr, "%s: snapshot from an incompatible build or damaged\n", path);
+        close(fd);
+        return 0;
+    }
+    if (h.count) {
+        size_t n = (size_t)st.st_size;
+        char *map = (char*)mmap(NULL, n, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) { perror("mmap"); close(fd); return 0; }
+        L->map = map; L->map_len = n;
+        L->id = (int32_t*)(map + off[SNAP_ID]);
+        L->due_day = (int32_t*)(map + off[SNAP_DUE]);
+        L->title = (uint32_t*)(map + off[SNAP_TITLE]);
+        L->priority = (uint8_t*)(map + off[SNAP_PRIORITY]);
+        L->done = (uint64_t*)(map + off[SNAP_DONE]);
+        L->arena = map + off[SNAP_ARENA];
+        L->arena_len = L->arena_cap = (size_t)h.arena_len;
+        L->len = L->cap = L->live = (size_t)h.count;
+        L->ix_stale = 1;
+    }
+    L->max_id = h.max_id;
+    close(fd);
+    return 1;
+}
+
+static int save_tasks(const char *path, const TaskList *L) {
+    return is_snapshot_path(path) ? save_snapshot(path, L) : save_json(path, L);
+}
+
+// The format is recognised by content, whatever the file is called.
+static int load_tasks(const char *path, TaskList *L) {
+    int r = load_snapshot(path, L);
+    return r >= 0 ? r : load_json(path, L);
+}
+
+/*---------------- Trigram index file ----------------*/
+// <path>.tri holds the index as it stood when the store was last closed,
+// stamped with the identity of the snapshot file it was built over. A stamp
+// that still matches means the index covers the snapshot plus some prefix of
+// the journal, and replaying the whole journal over it is idempotent.
+// Anything else is ignored and the index is rebuilt on first search.
+#define TRI_MAGIC "TODOTRI1"
+
+typedef struct { uint64_t size, ino; int64_t sec, nsec; } FileStamp;
+
+static void file_stamp(const char *path, FileStamp *fs) {
+    struct stat st;
+    memset(fs, 0, sizeof *fs);
+    if (stat(path, &st) != 0) return;
+    fs->size = (uint64_t)st.st_size; fs->ino = (uint64_t)st.st_ino;
+    fs->sec = (int64_t)st.st_mtim.tv_sec; fs->nsec = (int64_t)st.st_mtim.tv_nsec;
+}
+
+static int tri_save(const char *path, const TriIndex *T, const FileStamp *fs) {
+    char tmp[4096];
+    int fd = open_replacement(path, tmp, sizeof tmp);
+    if (fd < 0) { perror("open"); return 0; }
+    WBuf w; wb_init(&w, fd);
+    uint64_t n = 0;
+    for (size_t i = 0; i < T->npost; ++i) n += T->post[i].count != 0;
+    WB_LIT(&w, TRI_MAGIC);
+    wb_put(&w, (const char*)fs, sizeof *fs);
+    wb_put(&w, (const char*)&n, sizeof n);
+    for (size_t i = 0; i < T->cap && !w.err; ++i) {
+        if (!T->slot[i].tri) continue;
+        const Posting *P = &T->post[T->slot[i].post];
+        if (!P->count) continue;
+        uint32_t h[4] = { T->slot[i].tri, P->count, P->last, P->len };
+        wb_put(&w, (const char*)h, sizeof h);
+        wb_put(&w, (const char*)P->buf, P->len);
+    }
+    wb_flush(&w);
+    return commit_replacement(fd, tmp, path, w.err);
+}
+
+// NULL when the file is missing, stale or damaged.
+static TriIndex *tri_load(const char *path, const FileStamp *want) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)(8 + sizeof *want + 8)) { close(fd); return NULL; }
+    size_t n = (size_t)st.st_size, got = 0;
+    unsigned char *buf = (unsigned char*)xmalloc(n);
+    while (got < n) {
+        ssize_t k = read(fd, buf + got, n - got);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) break;
+        got += (size_t)k;
+    }
+    close(fd);
+    FileStamp fs; uint64_t np;
+    memcpy(&fs, buf + 8, sizeof fs);
+    memcpy(&np, buf + 8 + sizeof fs, sizeof np);
+    if (got != n || memcmp(buf, TRI_MAGIC, 8) != 0 || memcmp(&fs, want, sizeof fs) != 0) { free(buf); return NULL; }
+    TriIndex *T = tri_new();
+    size_t off = 8 + sizeof fs + sizeof np;
+    for (uint64_t i = 0; i < np; ++i) {
+        uint32_t h[4];
+        if (n - off < sizeof h) goto bad;
+        memcpy(h, buf + off, sizeof h); off += sizeof h;
+        if (!h[0] || !h[1] || n - off < h[3] || tri_find(T, h[0])) goto bad;
+        Posting *P = tri_get(T, h[0]);
+        P->buf = (uint8_t*)xmalloc(h[3] ? h[3] : 1);
+        memcpy(P->buf, buf + off, h[3]); off += h[3];
+        P->count = h[1]; P->last = h[2]; P->len = P->cap = h[3];
+        // Damaged deltas would make decoding run off the end; check the shape.
+        uint32_t ends = 0;
+        for (uint32_t j = 0; j < P->len; ++j) ends += !(P->buf[j] & 0x80);
+        if (ends != P->count || !P->len || (P->buf[P->len - 1] & 0x80)) goto bad;
+    }
+    if (off != n) goto bad;
+    free(buf);
+    return T;
+bad:
+    free(buf); tri_free(T);
+    return NULL;
+}
+
+/*---------------- Journal ----------------*/
+// Edits are appended to <path>.journal as they happen and fsync'd, so each
+// edit costs one small write instead of a full save. Records are full-state
+// upserts (PUT) or deletes by id (DEL), which makes replay idempotent.
+//
+// Record: u32 payload length, u32 crc32(payload), payload. A torn or corrupt
+// tail stops replay and is truncated away.
+//
+// Compaction: the live journal is renamed to <path>.journal.old, a fresh one
+// is started, and a background thread writes a snapshot from a copy of the
+// list, then removes .old. On startup the snapshot is loaded and .old (if a
+// compaction was cut short) and the journal are replayed on top of it.
+#define JOURNAL_COMPACT_BYTES (1u << 20)
+#define JREC_MAX (16 + TITLE_MAX + DATE_LEN)
+enum { JOP_PUT = 'P', JOP_DEL = 'D' };
+
+typedef struct {
+    int fd;
+    off_t size;
+    int defer_sync; // leave fdatasync to journal_sync (daemon group commit)
+    int unsynced;
+    unsigned char *batch; // records held back by journal_begin, NULL otherwise
+    size_t batch_len, batch_cap;
+    char path[4096], old_path[4096];
+} Journal;
+
+typedef struct Base Base;
+
+typedef struct {
+    TaskList list;
+    const char *path;
+    Journal journal;
+    pthread_t compactor;
+    int compacting;
+    int compact_ok;
+    TaskList snap; // copy being written by the compactor
+    char tri_path[4096];
+    FileStamp stamp;   // the file as last loaded or written here
+    Base *base;        // its tasks, to merge outside edits against; NULL unless watched
+    int watch_fd;      // inotify, -1 if none
+    char watch_name[256];
+    int outside;       // a change seen but not merged yet
+} Store;
+
+enum {
+    STORE_SEARCH = 1, // keep the title index (loaded from <path>.tri if current)
+    STORE_WATCH = 2,  // merge in outside changes to the file (see store_refresh)
+    STORE_READ = 4    // only read: no journal is opened, repaired or compacted
+};
+
+typedef struct { size_t updated, added, deleted, conflicts; } ReloadStats;
+
+static Base *base_build(const TaskList *L);
+static void base_free(Base *B);
+static void store_watch(Store *S);
+static int store_changed(Store *S);
+static int store_refresh(Store *S, ReloadStats *st);
+
+// The file now holds L.
+static void store_saved(Store *S, const TaskList *L) {
+    file_stamp(S->path, &S->stamp);
+    if (S->base) { base_free(S->base); S->base = base_build(L); }
+}
+
+static void put_u32(unsigned char *p, uint32_t v) { p[0]=(unsigned char)v; p[1]=(unsigned char)(v>>8); p[2]=(unsigned char)(v>>16); p[3]=(unsigned char)(v>>24); }
+static uint32_t get_u32(const unsigned char *p) { return (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24; }
+
+static int journal_paths(Journal *J, const char *store_path) {
+    if ((size_t)snprintf(J->path, sizeof J->path, "%s.journal", store_path) >= sizeof J->path) return 0;
+    if ((size_t)snprintf(J->old_path, sizeof J->old_path, "%s.journal.old", store_path) >= sizeof J->old_path) return 0;
+    return 1;
+}
+
+static int journal_open(Journal *J) {
+    J->fd = open(J->path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (J->fd < 0) return 0;
+    struct stat st;
+    J->size = fstat(J->fd, &st) == 0 ? st.st_size : 0;
+    return 1;
+}
+
+static int journal_sync(Journal *J) {
+    if (J->fd < 0 || !J->unsynced) return 1;
+    J->unsynced = 0;
+    return fdatasync(J->fd) == 0;
+}
+
+static void journal_close(Journal *J) {
+    journal_sync(J);
+    if (J->fd >= 0) close(J->fd);
+    J->fd = -1;
+}
+
+static int journal_write(Journal *J, const unsigned char *rec, size_t len) {
+    for (size_t off = 0; off < len;) {
+        ssize_t k = write(J->fd, rec + off, len - off);
+        if (k < 0) { if (errno == EINTR) continue; return 0; }
+        off += (size_t)k;
+    }
+    J->size += (off_t)len;
+    if (J->defer_sync) { J->unsynced = 1; return 1; }
+    return fdatasync(J->fd) == 0;
+}
+
+static int journal_append(Journal *J, const unsigned char *payload, size_t n) {
+    if (J->fd < 0) return 0;
+    unsigned char rec[8 + JREC_MAX];
+    put_u32(rec, (uint32_t)n);
+    put_u32(rec + 4, crc32_buf(payload, n));
+    memcpy(rec + 8, payload, n);
+    if (!J->batch) return journal_write(J, rec, 8 + n);
+    if (J->batch_len + 8 + n > J->batch_cap) {
+        while (J->batch_len + 8 + n > J->batch_cap) J->batch_cap *= 2;
+        J->batch = (unsigned char*)xrealloc(J->batch, J->batch_cap);
+    }
+    memcpy(J->batch + J->batch_len, rec, 8 + n);
+    J->batch_len += 8 + n;
+    return 1;
+}
+
+// Between begin and commit, records collect in memory and then go out as
+// one write and one sync. Each record still stands alone on replay, so a
+// crash mid-write keeps a prefix of the batch.
+static void journal_begin(Journal *J) {
+    J->batch_cap = 64 * 1024;
+    J->batch = (unsigned char*)xmalloc(J->batch_cap);
+    J->batch_len = 0;
+}
+
+static int journal_commit(Journal *J) {
+    int ok = J->fd >= 0 && (J->batch_len == 0 || journal_write(J, J->batch, J->batch_len));
+    free(J->batch);
+    J->batch = NULL;
+    J->batch_len = J->batch_cap = 0;
+    return ok;
+}
+
+static int journal_put(Journal *J, const Task *t) {
+    unsigned char p[JREC_MAX];
+    size_t tl = strlen(t->title), dl = strlen(t->due), n = 0;
+    p[n++] = JOP_PUT;
+    put_u32(p + n, (uint32_t)t->id); n += 4;
+    put_u32(p + n, (uint32_t)t->priority); n += 4;
+    p[n++] = (unsigned char)(t->done != 0);
+    p[n++] = (unsigned char)tl; memcpy(p + n, t->title, tl); n += tl;
+    p[n++] = (unsigned char)dl; memcpy(p + n, t->due, dl); n += dl;
+    return journal_append(J, p, n);
+}
+
+static int journal_del(Journal *J, int id) {
+    unsigned char p[5];
+    p[0] = JOP_DEL;
+    put_u32(p + 1, (uint32_t)id);
+    return journal_append(J, p, sizeof p);
+}
+
+static int journal_apply(TaskList *L, const unsigned char *p, size_t n) {
+    if (n == 5 && p[0] == JOP_DEL) {
+        int idx = list_find_index_by_id(L, (int)get_u32(p + 1));
+        if (idx >= 0) list_delete_at(L, (size_t)idx);
+        return 1;
+    }
+    if (n < 12 || p[0] != JOP_PUT) return 0;
+    Task t; memset(&t, 0, sizeof t);
+    t.id = (int)get_u32(p + 1);
+    t.priority = (int)get_u32(p + 5);
+    t.done = p[9];
+    size_t tl = p[10];
+    if (tl > TITLE_MAX || 11 + tl + 1 > n) return 0;
+    memcpy(t.title, p + 11, tl);
+    size_t dl = p[11 + tl];
+    if (dl > DATE_LEN || 12 + tl + dl != n) return 0;
+    memcpy(t.due, p + 12 + tl, dl);
+    if (!valid_date(t.due)) return 0;
+    int idx = list_find_index_by_id(L, t.id);
+    if (idx >= 0) list_replace(L, (size_t)idx, &t);
+    else list_push(L, t);
+    return 1;
+}
+
+// Ids named by journal records, for a reader that merges them in itself.
+typedef struct { uint32_t *id; size_t n, cap; } IdSet;
+
+// Applies every intact record; with repair a bad tail is cut off so later
+// appends follow good data, otherwise it is only skipped. The ids of the
+// records go to seen unless it is NULL. Returns the number of records
+// applied, -1 on I/O error.
+static long journal_replay(const char *jpath, TaskList *L, int repair, IdSet *seen) {
+    int fd = open(jpath, repair ? O_RDWR : O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+    size_t cap = LOAD_CHUNK, len = 0;
+    unsigned char *buf = (unsigned char*)xmalloc(cap);
+    off_t good = 0;
+    long applied = 0;
+    int eof = 0;
+    for (;;) {
+        while (!eof && len < cap) {
+            ssize_t k = read(fd, buf + len, cap - len);
+            if (k < 0) { if (errno == EINTR) continue; free(buf); close(fd); return -1; }
+            if (k == 0) eof = 1;
+            len += (size_t)k;
+        }
+        size_t off = 0;
+        while (len - off >= 8) {
+            uint32_t n = get_u32(buf + off);
+            if (n > JREC_MAX) { eof = 1; len = off; break; }
+            if (len - off < 8 + n) break;
+            if (crc32_buf(buf + off + 8, n) != get_u32(buf + off + 4) || !journal_apply(L, buf + off + 8, n)) { eof = 1; len = off; break; }
+            if (seen) {
+                if (seen->n == seen->cap) {
+                    seen->cap = seen->cap ? seen->cap * 2 : 256;
+                    seen->id = (uint32_t*)xrealloc(seen->id, seen->cap * sizeof *seen->id);
+                }
+                seen->id[seen->n++] = get_u32(buf + off + 9); // after the length, crc and op
+            }
+            off += 8 + n; good += (off_t)(8 + n); applied++;
+        }
+        memmove(buf, buf + off, len - off);
+        len -= off;
+        if (eof) break;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > good) {
+        fprintf(stderr, "Journal %s: %s %lld bytes of torn or corrupt tail\n", jpath, repair ? "dropped" : "skipped", (long long)(st.st_size - good));
+        if (repair && ftruncate(fd, good) == 0) fsync(fd);
+    }
+    free(buf);
+    close(fd);
+    return applied;
+}
+
+static void *compact_worker(void *arg) {
+    Store *S = (Store*)arg;
+    S->compact_ok = save_tasks(S->path, &S->snap);
+    if (S->compact_ok) unlink(S->journal.old_path);
+    return NULL;
+}
+
+static void store_wait_compaction(Store *S) {
+    if (!S->compacting) return;
+    pthread_join(S->compactor, NULL);
+    S->compacting = 0;
+    if (S->compact_ok) store_saved(S, &S->snap);
+    list_free(&S->snap);
+    if (!S->compact_ok) fprintf(stderr, "Compaction failed; %s kept for replay\n", S->journal.old_path);
+}
+
+// Folds the journal into a new snapshot. With background=0 the caller waits.
+static int store_compact(Store *S, int background) {
+    store_wait_compaction(S);
+    if (access(S->journal.old_path, F_OK) == 0) {
+        // A previous compaction did not finish: its records must reach a
+        // snapshot before .old can be reused, so write one synchronously.
+        if (!save_tasks(S->path, &S->list)) return 0;
+        store_saved(S, &S->list);
+        unlink(S->journal.old_path);
+        journal_close(&S->journal);
+        if (truncate(S->journal.path, 0) != 0 && errno != ENOENT) return 0;
+        return journal_open(&S->journal);
+    }
+    journal_close(&S->journal);
+    if (rename(S->journal.path, S->journal.old_path) != 0 && errno != ENOENT) { journal_open(&S->journal); return 0; }
+    fsync_parent_dir(S->journal.path);
+    if (!journal_open(&S->journal)) return 0;
+    // Why: copying the columns is a few memcpys; formatting is the slow part, done off-thread.
+    list_clone(&S->snap, &S->list);
+    if (background && pthread_create(&S->compactor, NULL, compact_worker, S) == 0) { S->compacting = 1; return 1; }
+    compact_worker(S);
+    if (S->compact_ok) store_saved(S, &S->snap);
+    list_free(&S->snap);
+    return S->compact_ok;
+}
+
+static void store_maybe_compact(Store *S) {
+    if (S->journal.size < (off_t)JOURNAL_COMPACT_BYTES) return;
+    // Never write over an outside change: merge it first, which compacts.
+    ReloadStats st;
+    if (store_changed(S) && store_refresh(S, &st) != 0) return;
+    store_compact(S, 1);
+}
+
+static int store_open(Store *S, const char *path, int flags) {
+    memset(S, 0, sizeof *S);
+    list_init(&S->list);
+    S->path = path;
+    S->journal.fd = -1;
+    S->watch_fd = -1;
+    if (!journal_paths(&S->journal, path)) return 0;
+    if ((size_t)snprintf(S->tri_path, sizeof S->tri_path, "%s.tri", path) >= sizeof S->tri_path) return 0;
+    file_stamp(path, &S->stamp);
+    if (!load_tasks(path, &S->list)) return 0;
+    if (flags & STORE_WATCH) {
+        // The base is the file alone, before the journal goes on top.
+        S->base = base_build(&S->list);
+        store_watch(S);
+    }
+    if (flags & STORE_SEARCH) {
+        // Loaded before replay, so replayed edits keep it current.
+        FileStamp fs; file_stamp(path, &fs);
+        S->list.tri = tri_load(S->tri_path, &fs);
+    }
+    int had_old = access(S->journal.old_path, F_OK) == 0, repair = !(flags & STORE_READ);
+    if (journal_replay(S->journal.old_path, &S->list, repair, NULL) < 0) return 0;
+    if (journal_replay(S->journal.path, &S->list, repair, NULL) < 0) return 0;
+    if (!repair) return 1;
+    if (!journal_open(&S->journal)) { perror("journal"); return 0; }
+    if (had_old && !store_compact(S, 0)) return 0;
+    return 1;
+}
+
+// A store exists once its file or either journal does; edits reach the
+// journal before the first compaction writes the file.
+static int store_exists(const char *path) {
+    Journal J;
+    if (access(path, F_OK) == 0) return 1;
+    return journal_paths(&J, path) && (access(J.path, F_OK) == 0 || access(J.old_path, F_OK) == 0);
+}
+
+static void store_close(Store *S) {
+    store_wait_compaction(S);
+    if (S->list.tri && S->list.tri->dirty) {
+        FileStamp fs; file_stamp(S->path, &fs);
+        tri_save(S->tri_path, S->list.tri, &fs);
+    }
+    journal_close(&S->journal);
+    list_free(&S->list);
+    base_free(S->base);
+    if (S->watch_fd >= 0) close(S->watch_fd);
+}
+
+static void store_put(Store *S, const Task *t) {
+    if (!journal_put(&S->journal, t)) fprintf(stderr, "Warning: journal write failed; change is not yet durable\n");
+    if (!S->journal.batch) store_maybe_compact(S);
+}
+
+static void store_del(Store *S, int id) {
+    if (!journal_del(&S->journal, id)) fprintf(stderr, "Warning: journal write failed; change is not yet durable\n");
+    if (!S->journal.batch) store_maybe_compact(S);
+}
+
+static void store_begin(Store *S) { journal_begin(&S->journal); }
+
+static int store_commit(Store *S) {
+    int ok = journal_commit(&S->journal);
+    if (!ok) fprintf(stderr, "Warning: journal write failed; changes are not yet durable\n");
+    store_maybe_compact(S);
+    return ok;
+}
+
+/*---------------- Live reload ----------------*/
+// A watched store notices when another program rewrites its file and merges
+// the change in instead of overwriting it at the next compaction. The base
+// table records each task of the file as last loaded or written here: its
+// fields, with the title as a 64-bit hash. On a change the file is streamed
+// through the parser, and each task that matches its base record is skipped,
+// which is nearly all of them. Only the tasks that differ are merged into the
+// list, through the usual list calls, so the id index, views and search stay
+// current.
+//
+// The merge is three-way against the base, field by field: a field only the
+// file changed takes the file's value; when both sides changed it differently
+// the local edit wins. A task edited here but deleted there is kept. One
+// deleted here but edited there comes back. A new task whose id was also
+// taken here is added under a fresh id. If there were local edits, the
+// merged list is compacted back to the file, so the file and journal agree
+// again; otherwise the list already matches the file and nothing is written.
+typedef struct {
+    int32_t id, due_day;
+    uint32_t title_lo, title_hi;
+    uint8_t priority, done, seen;
+} BaseRec;
+
+struct Base {
+    BaseRec *rec;     // open addressing by id; id TASK_DEAD marks an empty slot
+    size_t cap, len;  // cap is a power of two
+};
+
+static BaseRec base_rec(const Task *t) {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    for (const unsigned char *p = (const unsigned char*)t->title; *p; ++p) h = (h ^ *p) * 0x100000001b3ull;
+    BaseRec r = { t->id, t->due_day, (uint32_t)h, (uint32_t)(h >> 32), (uint8_t)t->priority, (uint8_t)(t->done != 0), 0 };
+    return r;
+}
+
+static int rec_same(const BaseRec *a, const BaseRec *b) {
+    return a->id == b->id && a->due_day == b->due_day && a->title_lo == b->title_lo && a->title_hi == b->title_hi
+        && a->priority == b->priority && a->done == b->done;
+}
+
+static size_t base_home(const Base *B, int id) {
+    return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> 32) & (B->cap - 1);
+}
+
+static BaseRec *base_get(const Base *B, int id) {
+    for (size_t i = base_home(B, id);; i = (i + 1) & (B->cap - 1)) {
+        if (B->rec[i].id == id) return &B->rec[i];
+        if (B->rec[i].id == TASK_DEAD) return NULL;
+    }
+}
+
+static Base *base_new(size_t n) {
+    Base *B = (Base*)xmalloc(sizeof *B);
+    B->cap = 64; B->len = 0;
+    while (B->cap * 3 < n * 4 + 4) B->cap *= 2;
+    B->rec = (BaseRec*)xmalloc(B->cap * sizeof *B->rec);
+    for (size_t i = 0; i < B->cap; ++i) B->rec[i].id = TASK_DEAD;
+    return B;
+}
+
+// Returns 0 if the id is already there (a file repeating an id).
+static int base_put(Base *B, BaseRec r) {
+    if ((B->len + 1) * 4 > B->cap * 3) {
+        BaseRec *old = B->rec; size_t oldcap = B->cap;
+        B->cap *= 2;
+        B->rec = (BaseRec*)xmalloc(B->cap * sizeof *B->rec);
+        for (size_t i = 0; i < B->cap; ++i) B->rec[i].id = TASK_DEAD;
+        for (size_t i = 0; i < oldcap; ++i) {
+            if (old[i].id == TASK_DEAD) continue;
+            size_t j = base_home(B, old[i].id);
+            while (B->rec[j].id != TASK_DEAD) j = (j + 1) & (B->cap - 1);
+            B->rec[j] = old[i];
+        }
+        free(old);
+    }
+    size_t i = base_home(B, r.id);
+    for (; B->rec[i].id != TASK_DEAD; i = (i + 1) & (B->cap - 1)) if (B->rec[i].id == r.id) return 0;
+    B->rec[i] = r;
+    B->len++;
+    return 1;
+}
+
+static Base *base_build(const TaskList *L) {
+    Base *B = base_new(L->live);
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i)) continue;
+        Task t; list_get(L, i, &t);
+        base_put(B, base_rec(&t));
+    }
+    return B;
+}
+
+static void base_free(Base *B) {
+    if (!B) return;
+    free(B->rec);
+    free(B);
+}
+
+// Starts watching the store's directory for its file being rewritten or
+// renamed into place (editors and sync tools do either).
+static void store_watch(Store *S) {
+#ifdef __linux__
+    const char *slash = strrchr(S->path, '/');
+    char dir[4096];
+    if (!slash) strcpy(dir, ".");
+    else if (slash == S->path) strcpy(dir, "/");
+    else if ((size_t)(slash - S->path) < sizeof dir) { memcpy(dir, S->path, (size_t)(slash - S->path)); dir[slash - S->path] = '\0'; }
+    else return;
+    snprintf(S->watch_name, sizeof S->watch_name, "%s", slash ? slash + 1 : S->path);
+    S->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (S->watch_fd >= 0 && inotify_add_watch(S->watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) { close(S->watch_fd); S->watch_fd = -1; }
+#else
+    (void)S;
+#endif
+}
+
+// Drains the watch; 1 if the file may have changed since the last merge.
+// Without inotify it always may, and store_refresh's stat decides.
+static int store_changed(Store *S) {
+    if (!S->base) return 0;
+    if (S->watch_fd < 0) return 1;
+    int hit = S->outside;
+#ifdef __linux__
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while ((n = read(S->watch_fd, buf, sizeof buf)) > 0)
+        for (char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+            const struct inotify_event *e = (const struct inotify_event*)p;
+            if (e->len && strcmp(e->name, S->watch_name) == 0) hit = 1;
+        }
+#endif
+    return S->outside = hit;
+}
+
+typedef struct {
+    Base *old, *next;  // base before and after
+    Task *changed; size_t n, cap; // tasks of the file that differ from the old base
+} Reload;
+
+static void sink_reload(void *ctx, const Task *in) {
+    Reload *R = (Reload*)ctx;
+    Task t = *in;
+    task_normalize(&t);
+    BaseRec r = base_rec(&t);
+    if (!base_put(R->next, r)) return; // a repeated id: the first one counts, as on load
+    BaseRec *b = base_get(R->old, t.id);
+    if (b) b->seen = 1;
+    if (b && rec_same(b, &r)) return;
+    if (R->n == R->cap) {
+        R->cap = R->cap ? R->cap * 2 : 64;
+        R->changed = (Task*)xrealloc(R->changed, R->cap * sizeof *R->changed);
+    }
+    R->changed[R->n++] = t;
+}
+
+static void merge_task(TaskList *L, const BaseRec *b, const Task *their, ReloadStats *st) {
+    int idx = list_find_index_by_id(L, their->id);
+    Task t = *their;
+    if (idx < 0) {
+        // New there, or edited there after a delete here: either way it is added.
+        if (b) st->conflicts++; else st->added++;
+        list_push(L, t);
+        return;
+    }
+    Task cur; list_get(L, (size_t)idx, &cur);
+    BaseRec mine = base_rec(&cur), theirs = base_rec(their);
+    if (!b) {
+        // Both sides added a task under this id.
+        if (rec_same(&mine, &theirs)) return;
+        t.id = list_next_id(L);
+        list_push(L, t);
+        st->added++; st->conflicts++;
+        return;
+    }
+    // A clash is a field both sides changed, to different values.
+    Task m = cur;
+    int clash = 0;
+    if (mine.title_lo == b->title_lo && mine.title_hi == b->title_hi) memcpy(m.title, their->title, sizeof m.title);
+    else clash |= (theirs.title_lo != b->title_lo || theirs.title_hi != b->title_hi) && (theirs.title_lo != mine.title_lo || theirs.title_hi != mine.title_hi);
+    if (mine.due_day == b->due_day) { memcpy(m.due, their->due, sizeof m.due); m.due_day = their->due_day; }
+    else clash |= theirs.due_day != b->due_day && theirs.due_day != mine.due_day;
+    if (mine.priority == b->priority) m.priority = their->priority;
+    else clash |= theirs.priority != b->priority && theirs.priority != mine.priority;
+    if (mine.done == b->done) m.done = their->done;
+    else clash |= theirs.done != b->done && theirs.done != mine.done;
+    st->conflicts += (size_t)clash;
+    BaseRec merged = base_rec(&m);
+    if (!rec_same(&merged, &mine)) { list_replace(L, (size_t)idx, &m); st->updated++; }
+}
+
+// Merges an outside change of the file into the list. Returns 1 if the file
+// had changed, 0 if not, -1 if it could not be read (the next change is
+// tried again).
+static int store_refresh(Store *S, ReloadStats *st) {
+    memset(st, 0, sizeof *st);
+    if (!S->base) return 0;
+    store_wait_compaction(S); // its own write is not an outside change
+    FileStamp now; file_stamp(S->path, &now);
+    if (memcmp(&now, &S->stamp, sizeof now) == 0) { S->outside = 0; return 0; }
+    Reload R = { S->base, base_new(S->base->len), NULL, 0, 0 };
+    int ok;
+    if (is_snapshot_path(S->path)) {
+        TaskList T; list_init(&T);
+        ok = load_tasks(S->path, &T);
+        for (size_t i = 0; ok && i < T.len; ++i) if (list_live(&T, i)) { Task t; list_get(&T, i, &t); sink_reload(&R, &t); }
+        list_free(&T);
+    } else ok = stream_tasks(S->path, sink_reload, &R);
+    if (!ok) {
+        for (size_t i = 0; i < R.old->cap; ++i) R.old->rec[i].seen = 0;
+        base_free(R.next); free(R.changed);
+        return -1;
+    }
+    TaskList *L = &S->list;
+    for (size_t i = 0; i < R.n; ++i) merge_task(L, base_get(R.old, R.changed[i].id), &R.changed[i], st);
+    for (size_t i = 0; i < R.old->cap; ++i) {
+        const BaseRec *b = &R.old->rec[i];
+        if (b->id == TASK_DEAD || b->seen) continue;
+        int idx = list_find_index_by_id(L, b->id);
+        if (idx < 0) continue;
+        Task cur; list_get(L, (size_t)idx, &cur);
+        BaseRec mine = base_rec(&cur);
+        if (rec_same(&mine, b)) { list_delete_at(L, (size_t)idx); st->deleted++; }
+        else st->conflicts++; // edited here, deleted there: kept
+    }
+    base_free(S->base);
+    S->base = R.next;
+    S->stamp = now;
+    S->outside = 0;
+    free(R.changed);
+    // Local edits are in the journal relative to the old file; fold them
+    // into the new one.
+    if (S->journal.size > 0) store_compact(S, 1);
+    return 1;
+}
+
+static void print_reload(const char *path, const ReloadStats *st) {
+    printf("[Reload] %s changed on disk: %zu updated, %zu added, %zu deleted", path, st->updated, st->added, st->deleted);
+    if (st->conflicts) printf(", %zu conflict%s (local edits kept)", st->conflicts, st->conflicts == 1 ? "" : "s");
+    printf("\n");
+}
+
+/*---------------- Input helpers ----------------*/
+static void read_line(const char *prompt, char *buf, size_t n) {
+    if (prompt) printf("%s", prompt);
+    if (!fgets(buf, (int)n, stdin)) { buf[0]='\0'; return; }
+    size_t len = strlen(buf);
+    if (len && buf[len-1]=='\n') buf[len-1]='\0';
+}
+
+static int read_int_range(const char *prompt, int lo, int hi, int allow_empty, int *out) {
+    char buf[64];
+    for(;;){
+        read_line(prompt, buf, sizeof buf);
+        if (allow_empty && buf[0]=='\0') return 1;
+        char *end; long v = strtol(buf, &end, 10);
+        if (end!=buf && *end=='\0' && v>=lo && v<=hi){ *out=(int)v; return 1; }
+        printf("Invalid. Enter %d..%d.\n", lo, hi);
+    }
+}
+
+static int read_date(const char *prompt, int allow_empty, char out[DATE_LEN+1]){
+    char buf[64];
+    for(;;){
+        read_line(prompt, buf, sizeof buf);
+        if (allow_empty && buf[0]=='\0'){ out[0]='\0'; return 1; }
+        if (valid_date(buf)){ strncpy(out, buf, DATE_LEN); out[DATE_LEN]='\0'; return 1; }
+        printf("Invalid date. Use YYYY-MM-DD or empty.\n");
+    }
+}
+
+/*---------------- Sorting & filtering ----------------*/
+// Each ordering packs into one integer key, so sorting needs no comparator and
+// no date parsing: due view is (due_day, priority desc, id), priority view is
+// (priority desc, due_day, id). The permutation of slots is sorted, not the
+// tasks themselves.
+#define KEY_BITS 55
+#define RADIX_BITS 11
+
+static uint64_t task_key(int id, int due_day, int priority, int view) {
+    uint64_t due = (uint32_t)due_day, rank = (uint64_t)(5 - priority);
+    uint64_t k = (uint32_t)id ^ 0x80000000u; // signed order
+    return view == VIEW_DUE ? due << 35 | rank << 32 | k : rank << 52 | due << 32 | k;
+}
+
+static uint64_t sort_key(const TaskList *L, size_t i, int view) {
+    return task_key(L->id[i], L->due_day[i], L->priority[i], view);
+}
+
+// LSD radix sort of key[] carrying val[]; digits all keys share are skipped.
+static void radix_sort(uint64_t *key, uint32_t *val, size_t n, int bits) {
+    if (n < 2) return;
+    uint64_t *k0 = key, *k1 = (uint64_t*)xmalloc(n * sizeof *k1);
+    uint32_t *v0 = val, *v1 = (uint32_t*)xmalloc(n * sizeof *v1);
+    size_t count[1u << RADIX_BITS];
+    const uint64_t mask = (1u << RADIX_BITS) - 1;
+    for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+        memset(count, 0, sizeof count);
+        for (size_t i = 0; i < n; ++i) count[(k0[i] >> shift) & mask]++;
+        if (count[(k0[0] >> shift) & mask] == n) continue;
+        for (size_t d = 0, sum = 0; d <= mask; ++d) { size_t c = count[d]; count[d] = sum; sum += c; }
+        for (size_t i = 0; i < n; ++i) {
+            size_t at = count[(k0[i] >> shift) & mask]++;
+            k1[at] = k0[i]; v1[at] = v0[i];
+        }
+        uint64_t *tk = k0; k0 = k1; k1 = tk;
+        uint32_t *tv = v0; v0 = v1; v1 = tv;
+    }
+    if (k0 != key) { memcpy(key, k0, n * sizeof *key); memcpy(val, v0, n * sizeof *val); free(k0); free(v0); }
+    else { free(k1); free(v1); }
+}
+
+static const SortView *list_view(TaskList *L, int view) {
+    SortView *v = &L->view[view];
+    if (v->valid) return v;
+    free(v->order);
+    v->order = (uint32_t*)xmalloc((L->live ? L->live : 1) * sizeof *v->order);
+    uint64_t *key = (uint64_t*)xmalloc((L->live ? L->live : 1) * sizeof *key);
+    size_t n = 0;
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i)) continue;
+        key[n] = sort_key(L, i, view);
+        v->order[n++] = (uint32_t)i;
+    }
+    radix_sort(key, v->order, n, KEY_BITS);
+    free(key);
+    v->n = n;
+    v->valid = 1;
+    return v;
+}
+
+/*---------------- Table output ----------------*/
+static const char TABLE_RULE[] = "+------+--------------------------------+------------+----------+-------+\n";
+static const char TABLE_HEAD[] = "| ID   | Title                          | Due        | Priority | Done  |\n";
+
+static void print_rule(void){ fputs(TABLE_RULE, stdout); }
+
+static void print_header(void){
+    print_rule();
+    fputs(TABLE_HEAD, stdout);
+    print_rule();
+}
+
+static int fmt_task_row(char *out, size_t cap, const Task *t){
+    char title[31];
+    size_t n = strlen(t->title);
+    if (n>30){ memcpy(title, t->title, 27); title[27]='.'; title[28]='.'; title[29]='.'; title[30]='\0'; }
+    else { strncpy(title, t->title, sizeof title); title[30]='\0'; }
+    return snprintf(out, cap, "| %4d | %-30s | %-10s | %8d | %5s |\n", t->id, title, t->due[0]? t->due : "", t->priority, t->done? "yes":"no");
+}
+
+static void print_task_row(const Task *t){
+    char row[128];
+    fmt_task_row(row, sizeof row, t);
+    fputs(row, stdout);
+}
+
+static void list_tasks(TaskList *L){
+    if (L->live==0){ printf("No tasks.\n"); return; }
+    printf("Sort by: 1) due  2) priority  [1]: ");
+    int choice=1; char ln[16]; if (fgets(ln, sizeof ln, stdin)){ if (ln[0]=='2') choice=2; }
+
+    // Filters
+    char due_before[DATE_LEN+1] = ""; int have_due=0;
+    printf("Filter due before (YYYY-MM-DD) or empty: ");
+    if (fgets(ln, sizeof ln, stdin)){
+        if (ln[0]!='\n'){ ln[strcspn(ln,"\n")]='\0'; if (valid_date(ln)){ strncpy(due_before, ln, DATE_LEN); due_before[DATE_LEN]='\0'; have_due= (due_before[0]!='\0'); } }
+    }
+    int minp=0; printf("Min priority [1-5] or 0 for none: ");
+    if (fgets(ln, sizeof ln, stdin)){ int v=atoi(ln); if (v>=1&&v<=5) minp=v; }
+    int only_open=0; printf("Only pending? 1=yes 0=no [0]: ");
+    if (fgets(ln, sizeof ln, stdin)){ if (ln[0]=='1') only_open=1; }
+
+    const SortView *v = list_view(L, choice==2? VIEW_PRIORITY : VIEW_DUE);
+    Filter f = { have_due? date_to_day(due_before) : INT_MAX, minp, only_open };
+    uint64_t *sel = (uint64_t*)xmalloc((done_words(L->len) + 1) * sizeof *sel);
+    filter_select(L, &f, sel);
+    print_header();
+    for (size_t i=0;i<v->n;i++){
+        uint32_t slot = v->order[i];
+        if (slot >= L->len || !((sel[slot >> 6] >> (slot & 63)) & 1)) continue;
+        Task t; list_get(L, slot, &t);
+        print_task_row(&t);
+    }
+    print_rule();
+    free(sel);
+}
+
+/*---------------- Title search ----------------*/
+// Terms are whitespace separated and all must occur, case-insensitively, as
+// substrings. Candidates are the intersection of the posting lists of every
+// query trigram, shortest first, and each one is checked against its title,
+// so the work follows the posting lists touched rather than the list size.
+#define SEARCH_MAX_TERMS 16
+
+static void tri_build(TaskList *L) {
+    L->tri = tri_new();
+    for (size_t i = 0; i < L->len; ++i)
+        if (list_live(L, i)) tri_update(L->tri, L->id[i], NULL, list_title(L, i));
+}
+
+static int contains_folded(const char *hay, const char *term, size_t tn) {
+    for (; *hay; ++hay) {
+        size_t k = 0;
+        while (k < tn && hay[k] && fold((unsigned char)hay[k]) == (unsigned char)term[k]) k++;
+        if (k == tn) return 1;
+    }
+    return 0;
+}
+
+static int cmp_posting_count(const void *a, const void *b) {
+    uint32_t x = (*(Posting* const*)a)->count, y = (*(Posting* const*)b)->count;
+    return (x > y) - (x < y);
+}
+
+// Keeps the candidates that also appear in P; both are ascending.
+static size_t post_intersect(const Posting *P, uint32_t *cand, size_t n) {
+    size_t w = 0, j = 0;
+    uint32_t i = 0, cur = 0;
+    while (i < P->len && j < n) {
+        cur = post_next(P, &i, cur);
+        while (j < n && cand[j] < cur) j++;
+        if (j < n && cand[j] == cur) cand[w++] = cand[j++];
+    }
+    return w;
+}
+
+// Slots of the matching tasks in id order, in *out (caller frees).
+static size_t title_search(TaskList *L, const char *query, uint32_t **out) {
+    char q[256];
+    char *term[SEARCH_MAX_TERMS], *save; size_t tlen[SEARCH_MAX_TERMS]; int nt = 0;
+    snprintf(q, sizeof q, "%s", query);
+    for (char *p = q; *p; ++p) *p = (char)fold((unsigned char)*p);
+    for (char *p = strtok_r(q, " \t", &save); p && nt < SEARCH_MAX_TERMS; p = strtok_r(NULL, " \t", &save)) { term[nt] = p; tlen[nt++] = strlen(p); }
+    *out = NULL;
+    if (!nt) return 0;
+    if (!L->tri) tri_build(L);
+
+    Posting *lists[SEARCH_MAX_TERMS * TRI_PER_TITLE];
+    size_t nl = 0;
+    for (int t = 0; t < nt; ++t) {
+        uint32_t g[TRI_PER_TITLE];
+        size_t ng = trigrams_of(term[t], g);
+        for (size_t k = 0; k < ng; ++k) {
+            Posting *P = tri_find(L->tri, g[k]);
+            if (!P || !P->count) return 0;
+            lists[nl++] = P;
+        }
+    }
+    uint32_t *cand;
+    size_t n;
+    if (nl) {
+        qsort(lists, nl, sizeof *lists, cmp_posting_count);
+        cand = post_decode(lists[0]);
+        n = lists[0]->count;
+        for (size_t k = 1; k < nl && n; ++k) n = post_intersect(lists[k], cand, n);
+    } else {
+        // Every term is shorter than a trigram: nothing to narrow by.
+        cand = (uint32_t*)xmalloc((L->live ? L->live : 1) * sizeof *cand);
+        n = 0;
+        for (size_t i = 0; i < L->len; ++i) if (list_live(L, i)) cand[n++] = tri_key(L->id[i]);
+        qsort(cand, n, sizeof *cand, cmp_u32);
+    }
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int idx = list_find_index_by_id(L, tri_unkey(cand[i]));
+        if (idx < 0) continue;
+        int hit = 1;
+        for (int t = 0; t < nt && hit; ++t) hit = contains_folded(list_title(L, (size_t)idx), term[t], tlen[t]);
+        if (hit) cand[w++] = (uint32_t)idx;
+    }
+    *out = cand;
+    return w;
+}
+
+static void search_tasks(TaskList *L){
+    char q[256];
+    read_line("Search titles: ", q, sizeof q);
+    uint32_t *slot;
+    size_t n = title_search(L, q, &slot);
+    if (!n){ printf("No matches.\n"); free(slot); return; }
+    print_header();
+    for (size_t i=0;i<n;i++){ Task t; list_get(L, slot[i], &t); print_task_row(&t); }
+    print_rule();
+    printf("%zu match%s.\n", n, n==1? "" : "es");
+    free(slot);
+}
+
+/*---------------- Next ----------------*/
+static int today_day(void) {
+    time_t now = time(NULL);
+    struct tm tm;
+    char buf[16];
+    localtime_r(&now, &tm);
+    strftime(buf, sizeof buf, "%Y-%m-%d", &tm);
+    return date_to_day(buf);
+}
+
+static Sched *sched_build(const TaskList *L, int today) {
+    Sched *S = (Sched*)xmalloc(sizeof *S);
+    memset(S, 0, sizeof *S);
+    S->today = today;
+    sched_reserve(S, L->len);
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i) || list_done(L, i)) continue;
+        chain_add(S, (uint32_t)i, L->due_day[i]);
+        S->heap[S->n] = (uint32_t)i;
+        S->key[S->n] = urgency_key(today, L->id[i], L->due_day[i], L->priority[i]);
+        S->pos[i] = (uint32_t)S->n++;
+    }
+    for (size_t i = S->n / 2; i-- > 0;) sched_sift_down(S, i);
+    return S;
+}
+
+// Moves the keys to a new day. A task changes bucket only when its days
+// left cross an edge e, i.e. it is due on one of the days [from+e, to+e),
+// so only those chains are rescored. Long gaps or a clock going backwards
+// rebuild instead.
+static void sched_rollover(TaskList *L, int today) {
+    Sched *S = L->sched;
+    int from = S->today;
+    if (today == from) return;
+    if (today < from || today - from > DUE_EDGE[DUE_EDGES - 1]) {
+        sched_free(S);
+        L->sched = sched_build(L, today);
+        return;
+    }
+    S->today = today;
+    for (int e = 0; e < DUE_EDGES; ++e)
+        for (int d = from + DUE_EDGE[e]; d < today + DUE_EDGE[e]; ++d) {
+            DayHead *h = day_find(S, d, 0);
+            for (uint32_t s = h ? h->head : SCHED_NONE; s != SCHED_NONE; s = S->next[s])
+                sched_rekey(S, s, urgency_key(today, L->id[s], d, L->priority[s]));
+        }
+}
+
+// Builds the heap on first use and brings it to today.
+static void sched_ensure(TaskList *L, int today) {
+    if (!L->sched) L->sched = sched_build(L, today);
+    else sched_rollover(L, today);
+}
+
+static void next_tasks(TaskList *L){
+    uint32_t slot[NEXT_DEFAULT];
+    sched_ensure(L, today_day());
+    size_t n = sched_top(L->sched, NEXT_DEFAULT, slot);
+    if (!n){ printf("Nothing open.\n"); return; }
+    print_header();
+    for (size_t i=0;i<n;i++){ Task t; list_get(L, slot[i], &t); print_task_row(&t); }
+    print_rule();
+}
+
+/*---------------- Agenda ----------------*/
+#define AGENDA_DAYS 7
+
+static Calendar *cal_build(const TaskList *L) {
+    Calendar *C = cal_new();
+    cal_reserve(C, L->len);
+    for (size_t i = 0; i < L->len; ++i)
+        if (list_live(L, i) && !list_done(L, i)) cal_set(C, (uint32_t)i, L->due_day[i]);
+    return C;
+}
+
+static void cal_ensure(TaskList *L) {
+    if (!L->cal) L->cal = cal_build(L);
+}
+
+// Open tasks due on days [lo, hi), by due date and then priority, stopping
+// once limit (0 for no limit) are found. Needs L->cal; *out is malloc'd.
+static size_t agenda_select(const TaskList *L, int lo, int hi, size_t limit, uint32_t **out) {
+    const Calendar *C = L->cal;
+    size_t n = 0, cap = 64;
+    uint32_t *slot = (uint32_t*)xmalloc(cap * sizeof *slot);
+    uint64_t *key = (uint64_t*)xmalloc(cap * sizeof *key);
+    if (lo < hi) {
+        size_t end = cal_bucket(C, hi - 1) + 1;
+        for (size_t b = cal_next(C, cal_bucket(C, lo), end); b < end && !(limit && n >= limit); b = cal_next(C, b + 1, end))
+            for (uint32_t s = C->head[b]; s != SCHED_NONE; s = C->next[s]) {
+                if (L->due_day[s] < lo || L->due_day[s] >= hi) continue; // an end bucket
+                if (n == cap) {
+                    cap *= 2;
+                    slot = (uint32_t*)xrealloc(slot, cap * sizeof *slot);
+                    key = (uint64_t*)xrealloc(key, cap * sizeof *key);
+                }
+                key[n] = sort_key(L, s, VIEW_DUE); slot[n++] = s;
+            }
+    }
+    radix_sort(key, slot, n, KEY_BITS);
+    free(key);
+    *out = slot;
+    return limit && n > limit ? limit : n;
+}
+
+static void print_agenda(TaskList *L, int lo, int hi, const char *none){
+    uint32_t *slot;
+    cal_ensure(L);
+    size_t n = agenda_select(L, lo, hi, 0, &slot);
+    if (!n){ printf("%s\n", none); free(slot); return; }
+    print_header();
+    for (size_t i=0;i<n;i++){ Task t; list_get(L, slot[i], &t); print_task_row(&t); }
+    print_rule();
+    printf("%zu task%s.\n", n, n==1? "" : "s");
+    free(slot);
+}
+
+static void agenda_tasks(TaskList *L){
+    int today = today_day();
+    print_agenda(L, today, today + AGENDA_DAYS, "Nothing due in the next 7 days.");
+}
+
+static void overdue_tasks(TaskList *L){
+    print_agenda(L, INT_MIN, today_day(), "Nothing overdue.");
+}
+
+/*---------------- Bulk edits ----------------*/
+// One pass over the selection bitmap applies the edit to every match, and
+// the journal records for all of them go out as a single batched write.
+static int parse_int_field(const char *s, int lo, int hi, int *out){
+    char *end; long v = strtol(s, &end, 10);
+    if (end == s || *end || v < lo || v > hi) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+enum { BULK_DONE, BULK_PRIORITY, BULK_SHIFT, BULK_DELETE };
+
+typedef struct {
+    Filter filter;      // due before, min priority, open only
+    int only_done;
+    const char *match;  // title terms as in search; NULL matches all
+} Predicate;
+
+// Returns the number of tasks changed.
+static size_t store_bulk(Store *S, const Predicate *p, int op, int arg) {
+    TaskList *L = &S->list;
+    size_t words = done_words(L->len), changed = 0;
+    uint64_t *sel = (uint64_t*)xmalloc((words + 1) * sizeof *sel);
+    filter_select(L, &p->filter, sel);
+    if (p->only_done) for (size_t w = 0; w < words; ++w) sel[w] &= L->done[w];
+    if (p->match) {
+        uint32_t *slot;
+        size_t n = title_search(L, p->match, &slot);
+        uint64_t *hit = (uint64_t*)xmalloc((words + 1) * sizeof *hit);
+        memset(hit, 0, (words + 1) * sizeof *hit);
+        for (size_t i = 0; i < n; ++i) hit[slot[i] >> 6] |= 1ull << (slot[i] & 63);
+        for (size_t w = 0; w < words; ++w) sel[w] &= hit[w];
+        free(hit); free(slot);
+    }
+    if (op == BULK_DELETE) {
+        // Deleting can compact the list under the bitmap, so go by id.
+        int *ids = (int*)xmalloc((L->live + 1) * sizeof *ids);
+        for (size_t w = 0; w < words; ++w) for (uint64_t m = sel[w]; m; m &= m - 1) ids[changed++] = L->id[w * 64 + (size_t)__builtin_ctzll(m)];
+        store_begin(S);
+        for (size_t i = 0; i < changed; ++i) {
+            list_delete_at(L, (size_t)list_find_index_by_id(L, ids[i]));
+            store_del(S, ids[i]);
+        }
+        store_commit(S);
+        free(ids); free(sel);
+        return changed;
+    }
+    store_begin(S);
+    for (size_t w = 0; w < words; ++w) for (uint64_t m = sel[w]; m; m &= m - 1) {
+        size_t i = w * 64 + (size_t)__builtin_ctzll(m);
+        Task t; list_get(L, i, &t);
+        if (op == BULK_DONE) { if (t.done) continue; t.done = 1; }
+        else if (op == BULK_PRIORITY) { if (t.priority == arg) continue; t.priority = arg; }
+        else {
+            if (t.due_day == DUE_NONE || !arg) continue;
+            char due[DATE_LEN + 1];
+            day_to_date(t.due_day + arg, due);
+            if (!valid_date(due)) continue;
+            memcpy(t.due, due, sizeof due);
+        }
+        list_replace(L, i, &t);
+        store_put(S, &t);
+        changed++;
+    }
+    store_commit(S);
+    free(sel);
+    return changed;
+}
+
+// Parses "done", "delete", "priority P" or "shift DAYS" at argv[*i].
+static int parse_bulk_op(int argc, char **argv, int *i, int *op, int *arg) {
+    if (*i >= argc) return 0;
+    const char *a = argv[(*i)++];
+    *arg = 0;
+    if (strcmp(a, "done") == 0) { *op = BULK_DONE; return 1; }
+    if (strcmp(a, "delete") == 0) { *op = BULK_DELETE; return 1; }
+    if (*i >= argc) return 0;
+    const char *v = argv[(*i)++];
+    if (strcmp(a, "priority") == 0) { *op = BULK_PRIORITY; return parse_int_field(v, 1, 5, arg); }
+    if (strcmp(a, "shift") == 0) { *op = BULK_SHIFT; return parse_int_field(v, -1000000, 1000000, arg); }
+    return 0;
+}
+
+static int bulk_usage(void){
+    fprintf(stderr, "usage: todo bulk [file] done|delete|priority P|shift DAYS\n"
+                    "                 [--due-before YYYY-MM-DD] [--min-priority 1-5] [--open|--done] [--match TEXT] [--all]\n"
+                    "       at least one predicate, or --all to touch every task\n");
+    return 2;
+}
+
+// Predicate options shared by todo bulk and todo client bulk. Returns 0 on
+// a bad option, 1 otherwise, and counts the filters (or --all) it saw.
+static int parse_predicate(int argc, char **argv, int *i, Predicate *p, int *given) {
+    const char *opt = argv[*i], *val = *i + 1 < argc ? argv[*i + 1] : NULL;
+    (*given)++;
+    if (strcmp(opt, "--open") == 0) { p->filter.only_open = 1; return !p->only_done; }
+    if (strcmp(opt, "--done") == 0) { p->only_done = 1; return !p->filter.only_open; }
+    if (strcmp(opt, "--all") == 0) return 1;
+    if (!val) return 0;
+    ++*i;
+    if (strcmp(opt, "--due-before") == 0) {
+        if (!val[0] || !valid_date(val)) return 0;
+        p->filter.due_limit = date_to_day(val);
+    } else if (strcmp(opt, "--min-priority") == 0) {
+        if (!parse_int_field(val, 1, 5, &p->filter.min_priority)) return 0;
+    } else if (strcmp(opt, "--match") == 0) {
+        p->match = val;
+    } else return 0;
+    return 1;
+}
+
+// argv[0] is "bulk".
+static int run_bulk(int argc, char **argv){
+    const char *path = "tasks.json";
+    Predicate p = { { INT_MAX, 0, 0 }, 0, NULL };
+    int i = 1, op, arg, given = 0;
+    if (i < argc && strncmp(argv[i], "--", 2) != 0 && strcmp(argv[i], "done") != 0 && strcmp(argv[i], "delete") != 0
+        && strcmp(argv[i], "priority") != 0 && strcmp(argv[i], "shift") != 0) path = argv[i++];
+    if (!parse_bulk_op(argc, argv, &i, &op, &arg)) return bulk_usage();
+    for (; i < argc; ++i) if (!parse_predicate(argc, argv, &i, &p, &given)) return bulk_usage();
+    if (!given) return bulk_usage();
+    if (!store_exists(path)) { fprintf(stderr, "No tasks at %s\n", path); return 1; }
+    Store S;
+    if (!store_open(&S, path, p.match ? STORE_SEARCH : 0)) { fprintf(stderr, "Failed to load %s\n", path); store_close(&S); return 1; }
+    size_t n = store_bulk(&S, &p, op, arg);
+    printf("%s %zu task%s.\n", op == BULK_DELETE ? "Deleted" : "Updated", n, n == 1 ? "" : "s");
+    store_close(&S);
+    return 0;
+}
+
+/*---------------- CRUD ----------------*/
+static void add_task(Store *S){
+    TaskList *L = &S->list;
+    Task t; memset(&t,0,sizeof t);
+    t.id = list_next_id(L);
+    read_line("Title: ", t.title, sizeof t.title);
+    while (t.title[0]=='\0'){ printf("Title required.\n"); read_line("Title: ", t.title, sizeof t.title); }
+    read_date("Due (YYYY-MM-DD or empty): ", 1, t.due);
+    read_int_range("Priority [1-5] (default 3): ", 1, 5, 1, &t.priority); if (!t.priority) t.priority=3;
+    t.done=0;
+    list_push(L, t);
+    store_put(S, &t);
+    printf("Added id %d.\n", t.id);
+}
+
+static void update_task(Store *S){
+    TaskList *L = &S->list;
+    if (L->live==0){ printf("No tasks.\n"); return; }
+    int id; if (!read_int_range("ID to update: ", 1, 100000000, 0, &id)) return;
+    int idx = list_find_index_by_id(L, id);
+    if (idx<0){ printf("Not found.\n"); return; }
+    Task edit, *t = &edit;
+    list_get(L, (size_t)idx, &edit);
+    char buf[256];
+    printf("Title [%s]: ", t->title); read_line(NULL, buf, sizeof buf); if (buf[0]){ size_t n = strlen(buf); if (n > TITLE_MAX) n = TITLE_MAX; memcpy(t->title, buf, n); t->title[n]='\0'; }
+    printf("Due [%s]: ", t->due[0]? t->due : ""); read_line(NULL, buf, sizeof buf); if (buf[0]){ if (valid_date(buf)) { memcpy(t->due, buf, DATE_LEN); t->due[DATE_LEN]='\0'; } else printf("Ignored invalid date.\n"); }
+    printf("Priority [%d]: ", t->priority); read_line(NULL, buf, sizeof buf); if (buf[0]){ int v=atoi(buf); if (v>=1&&v<=5) t->priority=v; else printf("Ignored invalid priority.\n"); }
+    printf("Mark done? 1=yes 0=no [%d]: ", t->done); read_line(NULL, buf, sizeof buf); if (buf[0]){ if (buf[0]=='1') t->done=1; else if (buf[0]=='0') t->done=0; }
+    list_replace(L, (size_t)idx, t);
+    store_put(S, t);
+    printf("Updated.\n");
+}
+
+static void delete_task(Store *S){
+    TaskList *L = &S->list;
+    if (L->live==0){ printf("No tasks.\n"); return; }
+    int id; if (!read_int_range("ID to delete: ", 1, 100000000, 0, &id)) return;
+    int idx = list_find_index_by_id(L, id);
+    if (idx<0){ printf("Not found.\n"); return; }
+    list_delete_at(L, (size_t)idx);
+    store_del(S, id);
+    printf("Deleted.\n");
+}
+
+/*---------------- Menu ----------------*/
+static void menu_reload(Store *S){
+    ReloadStats st;
+    if (store_changed(S) && store_refresh(S, &st) > 0) print_reload(S->path, &st);
+}
+
+// Waits for input at the menu prompt, merging outside changes to the file
+// as they happen. Only for a terminal: piped input may already sit in
+// stdin's buffer, where poll cannot see it.
+static void menu_wait(Store *S){
+    menu_reload(S);
+    if (S->watch_fd < 0 || !isatty(STDIN_FILENO)) return;
+    struct pollfd p[2] = { { STDIN_FILENO, POLLIN, 0 }, { S->watch_fd, POLLIN, 0 } };
+    for (;;) {
+        fflush(stdout);
+        if (poll(p, 2, -1) < 0) { if (errno == EINTR) continue; return; }
+        if (p[0].revents) return;
+        ReloadStats st;
+        if (store_changed(S) && store_refresh(S, &st) > 0) { print_reload(S->path, &st); printf("> "); }
+    }
+}
+
+// Edits are already durable in the journal; an explicit save folds it into
+// the file now and waits. An outside change is merged first, never written
+// over.
+static int menu_save(Store *S){
+    ReloadStats st;
+    int r = store_changed(S) ? store_refresh(S, &st) : 0;
+    if (r > 0) print_reload(S->path, &st);
+    if (r < 0 || !store_compact(S, 0)) { printf("Save failed; edits are kept in %s\n", S->journal.path); return 0; }
+    return 1;
+}
+
+static void menu_loop(Store *S){
+    TaskList *L = &S->list;
+    for(;;){
+        printf("\n[Menu] 1)add 2)list 3)update 4)delete 5)save 6)quit 7)search 8)next 9)agenda 10)overdue\n> ");
+        menu_wait(S);
+        char line[16]; if (!fgets(line, sizeof line, stdin)) break;
+        int choice = atoi(line);
+        switch(choice){
+            case 1: add_task(S); break;
+            case 2: list_tasks(L); break;
+            case 3: update_task(S); break;
+            case 4: delete_task(S); break;
+            case 5: if (menu_save(S)) printf("Saved.\n"); break;
+            case 6: if (menu_save(S)) printf("Saved. "); printf("Bye.\n"); return;
+            case 7: search_tasks(L); break;
+            case 8: next_tasks(L); break;
+            case 9: agenda_tasks(L); break;
+            case 10: overdue_tasks(L); break;
+            default: printf("Choose 1-10.\n");
+        }
+    }
+}
+
+/*---------------- Query CLI ----------------*/
+// Filters first, as a selection bitmap over the columns, keeps only the best
+// K in a bounded max-heap when a limit is given, sorts just the survivors by
+// their packed keys, and writes the rows through the save buffer straight to
+// stdout.
+enum { FMT_TABLE, FMT_JSON, FMT_TSV };
+
+typedef struct {
+    Filter filter;
+    int view;          // VIEW_DUE or VIEW_PRIORITY
+    size_t limit;      // 0 = no limit
+    int format;
+} Query;
+
+static void heap_swap(uint64_t *key, uint32_t *val, size_t a, size_t b){
+    uint64_t k = key[a]; key[a] = key[b]; key[b] = k;
+    uint32_t v = val[a]; val[a] = val[b]; val[b] = v;
+}
+
+static void heap_sift_up(uint64_t *key, uint32_t *val, size_t i){
+    while (i && key[(i - 1) / 2] < key[i]) { heap_swap(key, val, i, (i - 1) / 2); i = (i - 1) / 2; }
+}
+
+static void heap_sift_down(uint64_t *key, uint32_t *val, size_t n, size_t i){
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < n && key[l] > key[m]) m = l;
+        if (l + 1 < n && key[l + 1] > key[m]) m = l + 1;
+        if (m == i) return;
+        heap_swap(key, val, i, m);
+        i = m;
+    }
+}
+
+// Writes the matching slots in order to slot[] (room for min(limit, live)).
+static size_t query_select(const TaskList *L, const Query *q, uint32_t *slot){
+    int bounded = q->limit && q->limit < L->live;
+    size_t cap = bounded ? q->limit : L->live, n = 0;
+    if (!cap) return 0;
+    uint64_t *key = (uint64_t*)xmalloc(cap * sizeof *key);
+    uint64_t *sel = (uint64_t*)xmalloc((done_words(L->len) + 1) * sizeof *sel);
+    filter_select(L, &q->filter, sel);
+    for (size_t w = 0; w < done_words(L->len); ++w) for (uint64_t m = sel[w]; m; m &= m - 1) {
+        size_t i = w * 64 + (size_t)__builtin_ctzll(m);
+        uint64_t k = sort_key(L, i, q->view);
+        if (n < cap) {
+            key[n] = k; slot[n] = (uint32_t)i;
+            if (bounded) heap_sift_up(key, slot, n);
+            n++;
+        } else if (k < key[0]) {
+            key[0] = k; slot[0] = (uint32_t)i;
+            heap_sift_down(key, slot, n, 0);
+        }
+    }
+    radix_sort(key, slot, n, KEY_BITS);
+    free(key); free(sel);
+    return n;
+}
+
+static void wb_tsv_str(WBuf *w, const char *s){
+    for (const char *run = s;; ++s) {
+        char c = *s;
+        if (c && c != '\t' && c != '\n' && c != '\r' && c != '\\') continue;
+        wb_put(w, run, (size_t)(s - run));
+        if (!c) return;
+        char esc[2] = { '\\', c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\' };
+        wb_put(w, esc, sizeof esc);
+        run = s + 1;
+    }
+}
+
+static void wb_tsv_fields(WBuf *w, int id, const char *title, int due_day, int priority, int done){
+    char due[DATE_LEN + 1];
+    day_to_date(due_day, due);
+    wb_int(w, id); WB_LIT(w, "\t");
+    wb_tsv_str(w, title); WB_LIT(w, "\t");
+    wb_put(w, due, strlen(due)); WB_LIT(w, "\t");
+    wb_int(w, priority); WB_LIT(w, "\t");
+    wb_int(w, done); WB_LIT(w, "\n");
+}
+
+static void wb_tsv_row(WBuf *w, const TaskList *L, size_t at){
+    wb_tsv_fields(w, L->id[at], list_title(L, at), L->due_day[at], L->priority[at], list_done(L, at));
+}
+
+static void query_write(const TaskList *L, const Query *q, const uint32_t *slot, size_t n){
+    WBuf w; wb_init(&w, STDOUT_FILENO);
+    if (q->format == FMT_TABLE) { WB_LIT(&w, TABLE_RULE); WB_LIT(&w, TABLE_HEAD); WB_LIT(&w, TABLE_RULE); }
+    else if (q->format == FMT_JSON) WB_LIT(&w, "[\n");
+    for (size_t i = 0; i < n && !w.err; ++i) {
+        size_t at = slot[i];
+        if (q->format == FMT_JSON) { wb_task(&w, L, at, i + 1 == n); continue; }
+        if (q->format == FMT_TABLE) {
+            char row[128];
+            Task t; list_get(L, at, &t);
+            int k = fmt_task_row(row, sizeof row, &t);
+            wb_put(&w, row, (size_t)k < sizeof row ? (size_t)k : sizeof row - 1);
+            continue;
+        }
+        wb_tsv_row(&w, L, at);
+    }
+    if (q->format == FMT_TABLE) WB_LIT(&w, TABLE_RULE);
+    else if (q->format == FMT_JSON) WB_LIT(&w, "]\n");
+    wb_flush(&w);
+}
+
+static int query_usage(void){
+    fprintf(stderr, "usage: todo query [file] [--due-before YYYY-MM-DD] [--min-priority 1-5] [--open]\n"
+                    "                         [--sort due|priority] [--limit K] [--format table|json|tsv]\n"
+                    "                         [--budget MB [--tmp DIR]]   (sort on disk within MB of memory, <4096)\n");
+    return 2;
+}
+
+// Reads the query options in argv[i..]; returns 0 on a bad one.
+static int parse_query_args(int argc, char **argv, int i, Query *q){
+    Query d = { { INT_MAX, 0, 0 }, VIEW_DUE, 0, FMT_TABLE };
+    *q = d;
+    for (; i < argc; ++i) {
+        const char *opt = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--open") == 0) { q->filter.only_open = 1; continue; }
+        if (!val) return 0;
+        ++i;
+        if (strcmp(opt, "--due-before") == 0) {
+            if (!val[0] || !valid_date(val)) return 0;
+            q->filter.due_limit = date_to_day(val);
+        } else if (strcmp(opt, "--min-priority") == 0) {
+            q->filter.min_priority = atoi(val);
+            if (q->filter.min_priority < 1 || q->filter.min_priority > 5) return 0;
+        } else if (strcmp(opt, "--sort") == 0) {
+            if (strcmp(val, "due") == 0) q->view = VIEW_DUE;
+            else if (strcmp(val, "priority") == 0) q->view = VIEW_PRIORITY;
+            else return 0;
+        } else if (strcmp(opt, "--limit") == 0) {
+            char *end; long k = strtol(val, &end, 10);
+            if (*end || k < 0) return 0;
+            q->limit = (size_t)k;
+        } else if (strcmp(opt, "--format") == 0) {
+            if (strcmp(val, "table") == 0) q->format = FMT_TABLE;
+            else if (strcmp(val, "json") == 0) q->format = FMT_JSON;
+            else if (strcmp(val, "tsv") == 0) q->format = FMT_TSV;
+            else return 0;
+        } else return 0;
+    }
+    return 1;
+}
+
+static int ext_query(const char *path, const Query *q, size_t budget, const char *tmpdir, int out_fd);
+
+// argv[0] is "query".
+static int run_query(int argc, char **argv){
+    Query q;
+    const char *path = "tasks.json", *tmpdir = getenv("TMPDIR");
+    size_t budget = 0;
+    int i = 1;
+    if (i < argc && strncmp(argv[i], "--", 2) != 0) path = argv[i++];
+    // Pull out the external sort options; the rest are the query's.
+    char **rest = (char**)xmalloc((size_t)argc * sizeof *rest);
+    int nrest = 1, bad = 0;
+    rest[0] = argv[0];
+    for (; i < argc; ++i) {
+        int mb = 0;
+        if (i + 1 < argc && strcmp(argv[i], "--budget") == 0) { bad |= !parse_int_field(argv[++i], 1, 4095, &mb); budget = (size_t)mb << 20; }
+        else if (i + 1 < argc && strcmp(argv[i], "--tmp") == 0) tmpdir = argv[++i];
+        else rest[nrest++] = argv[i];
+    }
+    bad |= !parse_query_args(nrest, rest, 1, &q);
+    free(rest);
+    if (bad) return query_usage();
+    if (!store_exists(path)) { fprintf(stderr, "No tasks at %s\n", path); return 1; }
+    // A snapshot is mapped rather than read in, so it never needs the disk sort.
+    if (budget && !is_snapshot_path(path)) return ext_query(path, &q, budget, tmpdir && *tmpdir ? tmpdir : "/tmp", STDOUT_FILENO) ? 0 : 1;
+    Store S;
+    if (!store_open(&S, path, STORE_READ)) { fprintf(stderr, "Failed to load %s\n", path); store_close(&S); return 1; }
+    simd_init();
+    size_t cap = q.limit && q.limit < S.list.live ? q.limit : S.list.live;
+    uint32_t *slot = (uint32_t*)xmalloc((cap ? cap : 1) * sizeof *slot);
+    size_t n = query_select(&S.list, &q, slot);
+    query_write(&S.list, &q, slot, n);
+    free(slot);
+    store_close(&S);
+    return 0;
+}
+
+static int agenda_usage(void){
+    fprintf(stderr, "usage: todo agenda [file] [--days N | --overdue] [--limit K] [--format table|json|tsv]\n");
+    return 2;
+}
+
+// argv[0] is "agenda": open tasks due from today on for --days (default 7),
+// or before today with --overdue.
+static int run_agenda(int argc, char **argv){
+    Query q = { { INT_MAX, 0, 1 }, VIEW_DUE, 0, FMT_TABLE };
+    const char *path = "tasks.json";
+    int i = 1, days = AGENDA_DAYS, overdue = 0;
+    if (i < argc && strncmp(argv[i], "--", 2) != 0) path = argv[i++];
+    for (; i < argc; ++i) {
+        const char *opt = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--overdue") == 0) { overdue = 1; continue; }
+        if (!val) return agenda_usage();
+        ++i;
+        int k;
+        if (strcmp(opt, "--days") == 0 && parse_int_field(val, 1, 1000000, &days)) continue;
+        if (strcmp(opt, "--limit") == 0 && parse_int_field(val, 0, INT_MAX, &k)) { q.limit = (size_t)k; continue; }
+        if (strcmp(opt, "--format") == 0) {
+            if (strcmp(val, "table") == 0) { q.format = FMT_TABLE; continue; }
+            if (strcmp(val, "json") == 0) { q.format = FMT_JSON; continue; }
+            if (strcmp(val, "tsv") == 0) { q.format = FMT_TSV; continue; }
+        }
+        return agenda_usage();
+    }
+    Store S;
+    if (!store_open(&S, path, 0)) { fprintf(stderr, "Failed to load %s\n", path); store_close(&S); return 1; }
+    int today = today_day();
+    uint32_t *slot;
+    cal_ensure(&S.list);
+    size_t n = overdue ? agenda_select(&S.list, INT_MIN, today, q.limit, &slot)
+                       : agenda_select(&S.list, today, today + days, q.limit, &slot);
+    query_write(&S.list, &q, slot, n);
+    free(slot);
+    store_close(&S);
+    return 0;
+}
+
+/*---------------- External sort ----------------*/
+// query --budget MB lists a JSON file too big to load. The file streams
+// through the parser and matching tasks gather in a run buffer held to the
+// budget. Each full run is sorted by its keys and spilled to an unlinked
+// temporary file, and the runs are then merged through a heap straight into
+// the output, each read sequentially through its own share of the budget.
+// When there are more runs than shares, groups of them are merged into
+// longer runs first. With a limit, a run keeps only its first K records.
+//
+// Edits still in the journal are replayed into memory first and charged to
+// the budget: the tasks they name are skipped as the file streams past, and
+// their state after the edits joins the runs at the end. The budget does not
+// cover the fixed read chunk and the 1 MiB output buffer every path shares.
+//
+// A run record is the key and id, due day (u32 each), priority, done and
+// title length (a byte each), then the title bytes.
+#define EXT_HEAD 19
+#define EXT_REC_COST 36        // key, offset, their radix scratch and growth slack
+#define EXT_MIN_BUF (64 * 1024)
+#define EXT_FANIN_MAX 64
+
+// Resident size of a list, near enough for budgets.
+static size_t list_bytes(const TaskList *L) {
+    size_t b = L->ix_cap * sizeof(IdSlot);
+    if (L->map) return b + L->map_len;
+    return b + L->cap * (4 + 4 + 1 + 4) + done_words(L->cap) * 8 + L->arena_cap;
+}
+
+typedef struct {
+    const Query *q;
+    size_t budget;
+    const char *tmpdir;
+    char *arena; size_t len;   // records of the run being gathered
+    uint64_t *key; uint32_t *off; size_t n, cap;
+    int *run; size_t nrun, run_cap; // fds of spilled runs, read from the start
+    const uint32_t *skip; size_t nskip; // sorted ids whose state is in the journal
+    int err;
+} ExtSort;
+
+typedef struct { uint64_t key; Task t; } ExtRec;
+
+typedef struct {
+    int fd;
+    char *buf; size_t cap, pos, len;
+    int eof;
+} RunReader;
+
+typedef struct {
+    WBuf w;
+    int format;
+    Task held; int have;       // JSON: the last row is only known at the end
+} ExtOut;
+
+static size_t ext_rec_put(char *p, uint64_t key, const Task *t) {
+    size_t n = strlen(t->title);
+    put_u32((unsigned char*)p, (uint32_t)key); put_u32((unsigned char*)p + 4, (uint32_t)(key >> 32));
+    put_u32((unsigned char*)p + 8, (uint32_t)t->id); put_u32((unsigned char*)p + 12, (uint32_t)t->due_day);
+    p[16] = (char)t->priority; p[17] = (char)t->done; p[18] = (char)n;
+    memcpy(p + EXT_HEAD, t->title, n);
+    return EXT_HEAD + n;
+}
+
+static size_t ext_rec_get(const char *p, ExtRec *r) {
+    const unsigned char *u = (const unsigned char*)p;
+    size_t n = u[18];
+    r->key = (uint64_t)get_u32(u + 4) << 32 | get_u32(u);
+    r->t.id = (int)get_u32(u + 8); r->t.due_day = (int)get_u32(u + 12);
+    r->t.priority = u[16]; r->t.done = u[17];
+    memcpy(r->t.title, p + EXT_HEAD, n); r->t.title[n] = '\0';
+    day_to_date(r->t.due_day, r->t.due);
+    return EXT_HEAD + n;
+}
+
+// A temporary file that is gone as soon as it is closed.
+static int ext_tmpfile(const char *dir) {
+    char path[4096];
+    if ((size_t)snprintf(path, sizeof path, "%s/todo-sort-XXXXXX", dir) >= sizeof path) { errno = ENAMETOOLONG; return -1; }
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    return fd;
+}
+
+static void ext_add_run(ExtSort *E, int fd) {
+    if (E->nrun == E->run_cap) {
+        E->run_cap = E->run_cap ? E->run_cap * 2 : 16;
+        E->run = (int*)xrealloc(E->run, E->run_cap * sizeof *E->run);
+    }
+    E->run[E->nrun++] = fd;
+}
+
+static size_t ext_keep(const ExtSort *E, size_t n) {
+    return E->q->limit && E->q->limit < n ? E->q->limit : n;
+}
+
+// Sorts the gathered run and writes it out.
+static void ext_spill(ExtSort *E) {
+    radix_sort(E->key, E->off, E->n, KEY_BITS);
+    int fd = ext_tmpfile(E->tmpdir);
+    if (fd < 0) { perror(E->tmpdir); E->err = 1; return; }
+    WBuf w; wb_init(&w, fd);
+    for (size_t i = 0; i < ext_keep(E, E->n); ++i) {
+        const char *p = E->arena + E->off[i];
+        wb_put(&w, p, EXT_HEAD + (unsigned char)p[18]);
+    }
+    wb_flush(&w);
+    if (w.err || lseek(fd, 0, SEEK_SET) != 0) { errno = w.err ? w.err : errno; perror("spill"); close(fd); E->err = 1; return; }
+    ext_add_run(E, fd);
+    E->n = E->len = 0;
+}
+
+static void ext_sink(void *ctx, const Task *in) {
+    ExtSort *E = (ExtSort*)ctx;
+    const Filter *f = &E->q->filter;
+    Task t = *in;
+    task_normalize(&t);
+    if (E->err || t.due_day >= f->due_limit || t.priority < f->min_priority || (f->only_open && t.done)) return;
+    uint32_t id = (uint32_t)t.id;
+    if (E->nskip && bsearch(&id, E->skip, E->nskip, sizeof *E->skip, cmp_u32)) return;
+    size_t need = EXT_HEAD + strlen(t.title);
+    if (E->len + need + (E->n + 1) * EXT_REC_COST > E->budget && E->n) ext_spill(E);
+    if (E->n == E->cap) {
+        E->cap = E->cap ? E->cap * 2 : 1024;
+        E->key = (uint64_t*)xrealloc(E->key, E->cap * sizeof *E->key);
+        E->off = (uint32_t*)xrealloc(E->off, E->cap * sizeof *E->off);
+    }
+    E->key[E->n] = task_key(t.id, t.due_day, t.priority, E->q->view);
+    E->off[E->n++] = (uint32_t)E->len;
+    E->len += ext_rec_put(E->arena + E->len, E->key[E->n - 1], &t);
+}
+
+// Makes at least need bytes readable at R->pos; 0 at the end of the run.
+static int run_fill(RunReader *R, size_t need) {
+    if (R->len - R->pos >= need) return 1;
+    memmove(R->buf, R->buf + R->pos, R->len - R->pos);
+    R->len -= R->pos; R->pos = 0;
+    while (R->len < need && !R->eof) {
+        ssize_t k = read(R->fd, R->buf + R->len, R->cap - R->len);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) { R->eof = 1; break; }
+        R->len += (size_t)k;
+    }
+    return R->len >= need;
+}
+
+static int run_next(RunReader *R, ExtRec *r) {
+    if (!run_fill(R, EXT_HEAD) || !run_fill(R, EXT_HEAD + (unsigned char)R->buf[R->pos + 18])) return 0;
+    R->pos += ext_rec_get(R->buf + R->pos, r);
+    return 1;
+}
+
+static void ext_out_begin(ExtOut *o, int fd, int format) {
+    wb_init(&o->w, fd);
+    o->format = format; o->have = 0;
+    if (format == FMT_TABLE) { WB_LIT(&o->w, TABLE_RULE); WB_LIT(&o->w, TABLE_HEAD); WB_LIT(&o->w, TABLE_RULE); }
+    else if (format == FMT_JSON) WB_LIT(&o->w, "[\n");
+}
+
+static void ext_out_task(ExtOut *o, const Task *t) {
+    if (o->format == FMT_JSON) {
+        const Task *h = &o->held;
+        if (o->have) wb_task_fields(&o->w, h->id, h->title, h->due_day, h->priority, h->done, 0);
+        o->held = *t; o->have = 1;
+    } else if (o->format == FMT_TABLE) {
+        char row[128];
+        int k = fmt_task_row(row, sizeof row, t);
+        wb_put(&o->w, row, (size_t)k < sizeof row ? (size_t)k : sizeof row - 1);
+    } else wb_tsv_fields(&o->w, t->id, t->title, t->due_day, t->priority, t->done);
+}
+
+static int ext_out_end(ExtOut *o) {
+    const Task *h = &o->held;
+    if (o->format == FMT_JSON) {
+        if (o->have) wb_task_fields(&o->w, h->id, h->title, h->due_day, h->priority, h->done, 1);
+        WB_LIT(&o->w, "]\n");
+    } else if (o->format == FMT_TABLE) WB_LIT(&o->w, TABLE_RULE);
+    wb_flush(&o->w);
+    return !o->w.err;
+}
+
+// Merges runs[0..n) into out_fd as a new run or, with out_fd < 0, into o.
+// Closes the runs.
+static int ext_merge(ExtSort *E, const int *runs, size_t n, size_t bufsize, int out_fd, ExtOut *o) {
+    RunReader *R = (RunReader*)xmalloc(n * sizeof *R);
+    ExtRec *cur = (ExtRec*)xmalloc(n * sizeof *cur);
+    uint64_t *key = (uint64_t*)xmalloc(n * sizeof *key); // complemented: the heap puts the largest first
+    uint32_t *val = (uint32_t*)xmalloc(n * sizeof *val);
+    size_t live = 0, emitted = 0, limit = ext_keep(E, SIZE_MAX);
+    for (size_t i = 0; i < n; ++i) {
+        R[i].fd = runs[i]; R[i].buf = (char*)xmalloc(bufsize); R[i].cap = bufsize;
+        R[i].pos = R[i].len = 0; R[i].eof = 0;
+        if (!run_next(&R[i], &cur[i])) continue;
+        key[live] = ~cur[i].key; val[live] = (uint32_t)i;
+        heap_sift_up(key, val, live++);
+    }
+    WBuf w;
+    if (out_fd >= 0) wb_init(&w, out_fd);
+    char rec[EXT_HEAD + TITLE_MAX];
+    while (live && emitted < limit) {
+        ExtRec *r = &cur[val[0]];
+        if (out_fd >= 0) wb_put(&w, rec, ext_rec_put(rec, r->key, &r->t));
+        else ext_out_task(o, &r->t);
+        emitted++;
+        if (run_next(&R[val[0]], r)) key[0] = ~r->key;
+        else { key[0] = key[live - 1]; val[0] = val[live - 1]; live--; }
+        heap_sift_down(key, val, live, 0);
+    }
+    int ok = 1;
+    if (out_fd >= 0) {
+        wb_flush(&w);
+        if (w.err || lseek(out_fd, 0, SEEK_SET) != 0) { perror("merge"); ok = 0; }
+    }
+    for (size_t i = 0; i < n; ++i) { close(R[i].fd); free(R[i].buf); }
+    free(R); free(cur); free(key); free(val);
+    return ok;
+}
+
+// Writes the rows to out_fd; budget is in bytes.
+static int ext_query(const char *path, const Query *q, size_t budget, const char *tmpdir, int out_fd) {
+    Journal jp;
+    TaskList J; list_init(&J);
+    IdSet seen = { NULL, 0, 0 };
+    if (!journal_paths(&jp, path) || journal_replay(jp.old_path, &J, 0, &seen) < 0 || journal_replay(jp.path, &J, 0, &seen) < 0) {
+        fprintf(stderr, "Failed to read the journal of %s\n", path);
+        list_free(&J); free(seen.id);
+        return 0;
+    }
+    if (seen.n) qsort(seen.id, seen.n, sizeof *seen.id, cmp_u32);
+    size_t held = list_bytes(&J) + seen.cap * sizeof *seen.id;
+    if (held + EXT_MIN_BUF > budget) {
+        fprintf(stderr, "Edits in %s take more than the budget; save the store first\n", jp.path);
+        list_free(&J); free(seen.id);
+        return 0;
+    }
+    budget -= held;
+    ExtSort E;
+    memset(&E, 0, sizeof E);
+    E.q = q; E.budget = budget; E.tmpdir = tmpdir;
+    E.skip = seen.id; E.nskip = seen.n;
+    E.arena = (char*)xmalloc(budget); // pages past the largest run are never touched
+    int ok = stream_tasks(path, ext_sink, &E) && !E.err;
+    if (!ok) fprintf(stderr, "Failed to read %s\n", path);
+    E.nskip = 0;
+    for (size_t i = 0; ok && i < J.len; ++i) if (list_live(&J, i)) { Task t; list_get(&J, i, &t); ext_sink(&E, &t); }
+    ok = ok && !E.err;
+    list_free(&J); free(seen.id);
+    ExtOut o;
+    if (ok && !E.nrun) {
+        // Everything fitted: one sorted run, straight from memory.
+        radix_sort(E.key, E.off, E.n, KEY_BITS);
+        ext_out_begin(&o, out_fd, q->format);
+        for (size_t i = 0; i < ext_keep(&E, E.n); ++i) { ExtRec r; ext_rec_get(E.arena + E.off[i], &r); ext_out_task(&o, &r.t); }
+        ok = ext_out_end(&o);
+    } else if (ok) {
+        if (E.n) ext_spill(&E);
+        free(E.arena); free(E.key); free(E.off);
+        E.arena = NULL; E.key = NULL; E.off = NULL;
+        size_t fanin = budget / EXT_MIN_BUF - 1;
+        if (fanin < 2) fanin = 2;
+        if (fanin > EXT_FANIN_MAX) fanin = EXT_FANIN_MAX;
+        size_t bufsize = budget / (fanin + 1);
+        if (bufsize < EXT_MIN_BUF) bufsize = EXT_MIN_BUF;
+        while (ok && !E.err && E.nrun > fanin) {
+            int fd = ext_tmpfile(tmpdir);
+            if (fd < 0) { perror(tmpdir); ok = 0; break; }
+            ok = ext_merge(&E, E.run, fanin, bufsize, fd, NULL);
+            memmove(E.run, E.run + fanin, (E.nrun - fanin) * sizeof *E.run);
+            E.nrun -= fanin;
+            E.run[E.nrun++] = fd;
+        }
+        if (ok && !E.err) {
+            ext_out_begin(&o, out_fd, q->format);
+            ok = ext_merge(&E, E.run, E.nrun, bufsize, -1, &o);
+            ok = ext_out_end(&o) && ok;
+            E.nrun = 0;
+        }
+        ok = ok && !E.err;
+    }
+    for (size_t i = 0; i < E.nrun; ++i) close(E.run[i]);
+    free(E.run); free(E.arena); free(E.key); free(E.off);
+    return ok;
+}
+
+/*---------------- Daemon ----------------*/
+// todo serve keeps one store in memory and answers thin clients (todo client)
+// over a Unix socket, so the store is loaded once however many commands run
+// against it. One thread runs an epoll loop over the listening socket, the
+// connections and a wakeup pipe; complete request lines go to a pool of
+// workers that hold the store lock shared for reads and exclusive for edits.
+// Edits append to the journal without syncing: the loop issues one fdatasync
+// for all the edits finished since the last one and only then sends their
+// replies, so an OK still means the edit is durable.
+//
+// One request per line, fields separated by tabs and escaped as in query
+// --format tsv. A reply is "OK <n>" and n lines, or "ERR <reason>". Rows are
+// id, title, due, priority, done.
+//   ADD title due priority                         -> id
+//   UPDATE id field value [field value ...]        -> row (title, due, priority, done)
+//   DEL id                                         -> nothing
+//   GET id                                         -> row
+//   QUERY due-before min-priority open sort limit  -> rows (an empty field does not filter)
+//   SEARCH terms                                   -> rows
+//   NEXT [k]                                       -> up to k rows, most urgent first
+//   AGENDA [days]                                  -> open rows due from today on, by due date
+//   OVERDUE                                        -> open rows due before today, oldest first
+//   BULK op arg due-before min-priority state match -> count changed
+//        (op: done, delete, priority, shift; state: open, done or empty)
+#define DAEMON_LINE_MAX 4096
+#define DAEMON_INPUT_MAX (1u << 20)
+#define DAEMON_FIELDS 16
+#define DAEMON_WORKERS_MAX 8
+#define DAEMON_SOCKET "tasks.json.sock"
+
+static void tsv_unescape(char *s){
+    char *w = s;
+    for (; *s; ++s) {
+        if (*s != '\\' || !s[1]) { *w++ = *s; continue; }
+        ++s;
+        *w++ = *s == 't' ? '\t' : *s == 'n' ? '\n' : *s == 'r' ? '\r' : *s;
+    }
+    *w = '\0';
+}
+
+// Splits line in place; returns max + 1 if there are more fields than fit.
+static int split_fields(char *line, char **f, int max){
+    int n = 0;
+    for (char *p = line;; ++p) {
+        if (n == max) return max + 1;
+        f[n++] = p;
+        p = strchr(p, '\t');
+        if (!p) break;
+        *p = '\0';
+    }
+    for (int i = 0; i < n; ++i) tsv_unescape(f[i]);
+    return n;
+}
+
+static int socket_addr(struct sockaddr_un *a, const char *path){
+    memset(a, 0, sizeof *a);
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof a->sun_path) return 0;
+    strcpy(a->sun_path, path);
+    return 1;
+}
+
+static int socket_connect(const char *path){
+    struct sockaddr_un a;
+    if (!socket_addr(&a, path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&a, sizeof a) != 0) { close(fd); return -1; }
+    return fd;
+}
+
+static void reply_err(WBuf *w, const char *why){
+    WB_LIT(w, "ERR "); wb_put(w, why, strlen(why)); WB_LIT(w, "\n");
+}
+
+static void reply_rows(WBuf *w, const TaskList *L, const uint32_t *slot, size_t n){
+    WB_LIT(w, "OK "); wb_int(w, (int)n); WB_LIT(w, "\n");
+    for (size_t i = 0; i < n; ++i) wb_tsv_row(w, L, slot[i]);
+}
+
+static int task_set_field(Task *t, const char *field, const char *val){
+    if (strcmp(field, "title") == 0) {
+        size_t n = strlen(val);
+        if (!n || n > TITLE_MAX) return 0;
+        memcpy(t->title, val, n + 1);
+    } else if (strcmp(field, "due") == 0) {
+        if (val[0] && !valid_date(val)) return 0;
+        snprintf(t->due, sizeof t->due, "%s", val);
+    } else if (strcmp(field, "priority") == 0) {
+        return parse_int_field(val, 1, 5, &t->priority);
+    } else if (strcmp(field, "done") == 0) {
+        return parse_int_field(val, 0, 1, &t->done);
+    } else return 0;
+    return 1;
+}
+
+// Runs under the exclusive lock; returns 1 if a journal record was written.
+static int daemon_edit(Store *S, char **f, int nf, WBuf *w){
+    TaskList *L = &S->list;
+    Task t; memset(&t, 0, sizeof t);
+    if (strcmp(f[0], "ADD") == 0) {
+        if (nf != 4) { reply_err(w, "usage: ADD title due priority"); return 0; }
+        t.priority = 3;
+        if (!task_set_field(&t, "title", f[1]) || !task_set_field(&t, "due", f[2])
+            || (f[3][0] && !task_set_field(&t, "priority", f[3]))) { reply_err(w, "invalid task"); return 0; }
+        t.id = list_next_id(L);
+        list_push(L, t);
+        store_put(S, &t);
+        WB_LIT(w, "OK 1\n"); wb_int(w, t.id); WB_LIT(w, "\n");
+        return 1;
+    }
+    if (strcmp(f[0], "BULK") == 0) {
+        Predicate p = { { INT_MAX, 0, 0 }, 0, NULL };
+        int op, arg, i = 1;
+        if (nf != 7 || !parse_bulk_op(f[2][0] ? 3 : 2, f, &i, &op, &arg)
+            || (f[3][0] && !valid_date(f[3]))
+            || (f[4][0] && !parse_int_field(f[4], 1, 5, &p.filter.min_priority))
+            || (f[5][0] && strcmp(f[5], "open") != 0 && strcmp(f[5], "done") != 0)) {
+            reply_err(w, "usage: BULK op arg due-before min-priority state match");
+            return 0;
+        }
+        if (f[3][0]) p.filter.due_limit = date_to_day(f[3]);
+        p.filter.only_open = strcmp(f[5], "open") == 0;
+        p.only_done = strcmp(f[5], "done") == 0;
+        if (f[6][0]) p.match = f[6];
+        size_t n = store_bulk(S, &p, op, arg);
+        WB_LIT(w, "OK 1\n"); wb_int(w, (int)n); WB_LIT(w, "\n");
+        return n > 0;
+    }
+    int id, idx;
+    if (nf < 2 || !parse_int_field(f[1], 1, INT_MAX, &id)) { reply_err(w, "missing id"); return 0; }
+    if ((idx = list_find_index_by_id(L, id)) < 0) { reply_err(w, "not found"); return 0; }
+    if (strcmp(f[0], "DEL") == 0) {
+        list_delete_at(L, (size_t)idx);
+        store_del(S, id);
+        WB_LIT(w, "OK 0\n");
+        return 1;
+    }
+    if (nf < 4 || nf % 2) { reply_err(w, "usage: UPDATE id field value ..."); return 0; }
+    list_get(L, (size_t)idx, &t);
+    for (int i = 2; i < nf; i += 2)
+        if (!task_set_field(&t, f[i], f[i + 1])) { reply_err(w, "invalid field"); return 0; }
+    list_replace(L, (size_t)idx, &t);
+    store_put(S, &t);
+    uint32_t at = (uint32_t)idx;
+    reply_rows(w, L, &at, 1);
+    return 1;
+}
+
+// Runs under the shared lock, so it must not build anything lazily.
+static void daemon_read(TaskList *L, char **f, int nf, WBuf *w){
+    if (strcmp(f[0], "GET") == 0) {
+        int id, idx;
+        if (nf != 2 || !parse_int_field(f[1], 1, INT_MAX, &id)) { reply_err(w, "usage: GET id"); return; }
+        if ((idx = list_find_index_by_id(L, id)) < 0) { reply_err(w, "not found"); return; }
+        uint32_t at = (uint32_t)idx;
+        reply_rows(w, L, &at, 1);
+    } else if (strcmp(f[0], "QUERY") == 0) {
+        Query q = { { INT_MAX, 0, 0 }, VIEW_DUE, 0, FMT_TSV };
+        int limit = 0;
+        if (nf != 6
+            || (f[1][0] && !valid_date(f[1]))
+            || (f[2][0] && !parse_int_field(f[2], 1, 5, &q.filter.min_priority))
+            || (f[3][0] && !parse_int_field(f[3], 0, 1, &q.filter.only_open))
+            || (f[4][0] && strcmp(f[4], "due") != 0 && strcmp(f[4], "priority") != 0)
+            || (f[5][0] && !parse_int_field(f[5], 0, INT_MAX, &limit))) {
+            reply_err(w, "usage: QUERY due-before min-priority open sort limit");
+            return;
+        }
+        if (f[1][0]) q.filter.due_limit = date_to_day(f[1]);
+        if (strcmp(f[4], "priority") == 0) q.view = VIEW_PRIORITY;
+        q.limit = (size_t)limit;
+        size_t cap = q.limit && q.limit < L->live ? q.limit : L->live;
+        uint32_t *slot = (uint32_t*)xmalloc((cap ? cap : 1) * sizeof *slot);
+        reply_rows(w, L, slot, query_select(L, &q, slot));
+        free(slot);
+    } else if (strcmp(f[0], "NEXT") == 0) {
+        int k = NEXT_DEFAULT;
+        if (nf > 2 || (nf == 2 && f[1][0] && !parse_int_field(f[1], 1, 1000, &k))) { reply_err(w, "usage: NEXT [k]"); return; }
+        uint32_t *slot = (uint32_t*)xmalloc((size_t)k * sizeof *slot);
+        reply_rows(w, L, slot, sched_top(L->sched, (size_t)k, slot));
+        free(slot);
+    } else if (strcmp(f[0], "AGENDA") == 0 || strcmp(f[0], "OVERDUE") == 0) {
+        int days = AGENDA_DAYS, today = today_day();
+        if (f[0][0] == 'A' ? nf > 2 || (nf == 2 && f[1][0] && !parse_int_field(f[1], 1, 1000000, &days)) : nf != 1) {
+            reply_err(w, f[0][0] == 'A' ? "usage: AGENDA [days]" : "usage: OVERDUE");
+            return;
+        }
+        uint32_t *slot;
+        size_t n = f[0][0] == 'A' ? agenda_select(L, today, today + days, 0, &slot) : agenda_select(L, INT_MIN, today, 0, &slot);
+        reply_rows(w, L, slot, n);
+        free(slot);
+    } else if (strcmp(f[0], "SEARCH") == 0) {
+        if (nf != 2) { reply_err(w, "usage: SEARCH terms"); return; }
+        uint32_t *slot;
+        size_t n = title_search(L, f[1], &slot);
+        reply_rows(w, L, slot, n);
+        free(slot);
+    } else reply_err(w, "unknown command");
+}
+
+#ifdef __linux__
+typedef struct Conn {
+    int fd;
+    int busy;        // a request is with a worker
+    int closing;     // unregistered; freed once no worker holds it
+    int want_out;    // EPOLLOUT is registered
+    int needs_sync;  // the reply waits for the journal sync
+    char *in; size_t in_len, in_cap;
+    WBuf out; size_t out_off;
+    struct Conn *next;            // job queue, finished list or dead list
+    struct Conn *all_prev, *all_next;
+    char line[DAEMON_LINE_MAX];   // request being handled
+} Conn;
+
+typedef struct {
+    Store store;
+    const char *sock_path;
+    int listen_fd, ep;
+    int wake[2];     // workers -> loop
+    int quit[2];     // anyone -> loop: shut down
+    pthread_rwlock_t lock;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    Conn *head, *tail;   // waiting for a worker
+    Conn *finished;      // handled, reply not yet sent
+    Conn *dead;          // freed after the current batch of events
+    Conn *all;
+    int stop;
+    int nworkers;
+    pthread_t worker[DAEMON_WORKERS_MAX];
+} Daemon;
+
+static int set_nonblock(int fd){
+    int fl = fcntl(fd, F_GETFL);
+    return fl >= 0 && fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+static void daemon_handle(Daemon *D, Conn *c){
+    char *f[DAEMON_FIELDS];
+    int nf = split_fields(c->line, f, DAEMON_FIELDS);
+    int edit = strcmp(f[0], "ADD") == 0 || strcmp(f[0], "UPDATE") == 0 || strcmp(f[0], "DEL") == 0 || strcmp(f[0], "BULK") == 0;
+    c->needs_sync = 0;
+    if (strcmp(f[0], "NEXT") == 0) {
+        // The first request of a new day moves the urgency keys forward.
+        int today = today_day();
+        pthread_rwlock_rdlock(&D->lock);
+        int stale = D->store.list.sched->today != today;
+        pthread_rwlock_unlock(&D->lock);
+        if (stale) {
+            pthread_rwlock_wrlock(&D->lock);
+            sched_rollover(&D->store.list, today);
+            pthread_rwlock_unlock(&D->lock);
+        }
+    }
+    if (nf > DAEMON_FIELDS) reply_err(&c->out, "too many fields");
+    else if (edit) {
+        pthread_rwlock_wrlock(&D->lock);
+        c->needs_sync = daemon_edit(&D->store, f, nf, &c->out);
+        pthread_rwlock_unlock(&D->lock);
+    } else {
+        pthread_rwlock_rdlock(&D->lock);
+        daemon_read(&D->store.list, f, nf, &c->out);
+        pthread_rwlock_unlock(&D->lock);
+    }
+}
+
+static void *daemon_worker(void *arg){
+    Daemon *D = (Daemon*)arg;
+    for (;;) {
+        pthread_mutex_lock(&D->mu);
+        while (!D->head && !D->stop) pthread_cond_wait(&D->cv, &D->mu);
+        Conn *c = D->head;
+        if (!c) { pthread_mutex_unlock(&D->mu); return NULL; }
+        D->head = c->next;
+        if (!D->head) D->tail = NULL;
+        pthread_mutex_unlock(&D->mu);
+        daemon_handle(D, c);
+        pthread_mutex_lock(&D->mu);
+        c->next = D->finished; D->finished = c;
+        pthread_mutex_unlock(&D->mu);
+        char b = 1;
+        while (write(D->wake[1], &b, 1) < 0 && errno == EINTR) {}
+    }
+}
+
+static void conn_watch(Daemon *D, Conn *c, int out){
+    if (c->want_out == out) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN | (out ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+    epoll_ctl(D->ep, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = out;
+}
+
+static void conn_free(Daemon *D, Conn *c){
+    if (c->all_prev) c->all_prev->all_next = c->all_next; else D->all = c->all_next;
+    if (c->all_next) c->all_next->all_prev = c->all_prev;
+    free(c->in); free(c->out.buf); free(c);
+}
+
+static void conn_close(Daemon *D, Conn *c){
+    if (c->closing) return;
+    c->closing = 1;
+    epoll_ctl(D->ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    if (!c->busy) { c->next = D->dead; D->dead = c; }
+}
+
+// Sends what it can; the rest goes out when the socket reports EPOLLOUT.
+static int conn_flush(Daemon *D, Conn *c){
+    while (c->out_off < c->out.len) {
+        ssize_t k = write(c->fd, c->out.buf + c->out_off, c->out.len - c->out_off);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { conn_watch(D, c, 1); return 1; }
+            return 0;
+        }
+        c->out_off += (size_t)k;
+    }
+    c->out.len = c->out_off = 0;
+    conn_watch(D, c, 0);
+    return 1;
+}
+
+// Returns 0 on end of stream, error or runaway input.
+static int conn_read(Conn *c){
+    for (;;) {
+        if (c->in_cap - c->in_len < 1024) {
+            if (c->in_cap >= DAEMON_INPUT_MAX) return 0;
+            c->in_cap *= 2;
+            c->in = (char*)xrealloc(c->in, c->in_cap);
+        }
+        ssize_t k = read(c->fd, c->in + c->in_len, c->in_cap - c->in_len);
+        if (k > 0) { c->in_len += (size_t)k; continue; }
+        if (k == 0) return 0;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Hands the next complete line to a worker once the previous reply is out,
+// so replies leave in request order. Returns 0 on an overlong line.
+static int conn_dispatch(Daemon *D, Conn *c){
+    if (c->busy || c->closing || c->out.len) return 1;
+    char *nl = (char*)memchr(c->in, '\n', c->in_len);
+    if (!nl) return c->in_len < DAEMON_LINE_MAX;
+    size_t n = (size_t)(nl - c->in);
+    if (n >= DAEMON_LINE_MAX) return 0;
+    memcpy(c->line, c->in, n);
+    c->line[n] = '\0';
+    if (n && c->line[n - 1] == '\r') c->line[n - 1] = '\0';
+    c->in_len -= n + 1;
+    memmove(c->in, nl + 1, c->in_len);
+    c->busy = 1;
+    pthread_mutex_lock(&D->mu);
+    c->next = NULL;
+    if (D->tail) D->tail->next = c; else D->head = c;
+    D->tail = c;
+    pthread_cond_signal(&D->cv);
+    pthread_mutex_unlock(&D->mu);
+    return 1;
+}
+
+static void daemon_accept(Daemon *D){
+    for (;;) {
+        int fd = accept(D->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        Conn *c = (Conn*)xmalloc(sizeof *c);
+        memset(c, 0, sizeof *c);
+        c->fd = fd;
+        c->in_cap = 4096;
+        c->in = (char*)xmalloc(c->in_cap);
+        wb_init_mem(&c->out, 256);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof ev);
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (!set_nonblock(fd) || epoll_ctl(D->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd); free(c->in); free(c->out.buf); free(c);
+            continue;
+        }
+        c->all_next = D->all;
+        if (D->all) D->all->all_prev = c;
+        D->all = c;
+    }
+}
+
+// Collects the handled requests, makes their edits durable with one sync and
+// sends the replies.
+static void daemon_finish(Daemon *D){
+    char drain[256];
+    while (read(D->wake[0], drain, sizeof drain) > 0) {}
+    pthread_mutex_lock(&D->mu);
+    Conn *done = D->finished;
+    D->finished = NULL;
+    pthread_mutex_unlock(&D->mu);
+    int need = 0, synced = 1;
+    for (Conn *c = done; c; c = c->next) need |= c->needs_sync;
+    if (need) {
+        // Shared lock: keeps writers (and a compaction's journal swap) out
+        // while the readers carry on.
+        pthread_rwlock_rdlock(&D->lock);
+        synced = journal_sync(&D->store.journal);
+        pthread_rwlock_unlock(&D->lock);
+    }
+    while (done) {
+        Conn *c = done;
+        done = c->next;
+        c->busy = 0;
+        if (c->closing) { c->next = D->dead; D->dead = c; continue; }
+        if (c->needs_sync && !synced) { c->out.len = 0; reply_err(&c->out, "journal sync failed; change is not yet durable"); }
+        if (!conn_flush(D, c) || !conn_dispatch(D, c)) conn_close(D, c);
+    }
+}
+
+// The file was rewritten by someone else: merge it in as one edit.
+static void daemon_reload(Daemon *D){
+    ReloadStats st;
+    pthread_rwlock_wrlock(&D->lock);
+    int r = store_changed(&D->store) ? store_refresh(&D->store, &st) : 0;
+    pthread_rwlock_unlock(&D->lock);
+    if (r > 0) { print_reload(D->store.path, &st); fflush(stdout); }
+}
+
+static void daemon_loop(Daemon *D){
+    struct epoll_event ev[64];
+    for (int run = 1; run;) {
+        int n = epoll_wait(D->ep, ev, 64, -1);
+        if (n < 0) { if (errno == EINTR) continue; perror("epoll_wait"); break; }
+        for (int k = 0; k < n; ++k) {
+            void *p = ev[k].data.ptr;
+            if (p == &D->listen_fd) { daemon_accept(D); continue; }
+            if (p == D->wake) { daemon_finish(D); continue; }
+            if (p == D->quit) { run = 0; continue; }
+            if (p == &D->store.watch_fd) { daemon_reload(D); continue; }
+            Conn *c = (Conn*)p;
+            if (c->closing) continue;
+            if ((ev[k].events & EPOLLOUT) && !conn_flush(D, c)) { conn_close(D, c); continue; }
+            if ((ev[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !conn_read(c)) { conn_close(D, c); continue; }
+            if (!conn_dispatch(D, c)) conn_close(D, c);
+        }
+        while (D->dead) { Conn *c = D->dead; D->dead = c->next; conn_free(D, c); }
+    }
+}
+
+static int g_quit_fd = -1;
+
+static void on_quit_signal(int sig){
+    (void)sig;
+    char b = 1;
+    if (write(g_quit_fd, &b, 1) < 0) {}
+}
+
+static int daemon_watch(Daemon *D, int fd, void *tag){
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.ptr = tag;
+    return epoll_ctl(D->ep, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+// Binds the socket, refusing to take over one another daemon still answers.
+static int daemon_listen(const char *path){
+    struct sockaddr_un a;
+    if (!socket_addr(&a, path)) { fprintf(stderr, "Socket path too long: %s\n", path); return -1; }
+    int probe = socket_connect(path);
+    if (probe >= 0) { close(probe); fprintf(stderr, "A daemon is already serving %s\n", path); return -1; }
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&a, sizeof a) != 0 || listen(fd, SOMAXCONN) != 0 || !set_nonblock(fd)) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int daemon_open(Daemon *D, const char *path, const char *sock_path){
+    memset(D, 0, sizeof *D);
+    D->listen_fd = D->ep = D->wake[0] = D->wake[1] = D->quit[0] = D->quit[1] = -1;
+    D->sock_path = sock_path;
+    pthread_rwlock_init(&D->lock, NULL);
+    pthread_mutex_init(&D->mu, NULL);
+    pthread_cond_init(&D->cv, NULL);
+    if (!store_open(&D->store, path, STORE_SEARCH | STORE_WATCH)) { fprintf(stderr, "Failed to load %s\n", path); return 0; }
+    // Readers share the list under the shared lock, so everything they would
+    // otherwise build on first use is built now.
+    TaskList *L = &D->store.list;
+    ix_ensure(L);
+    if (!L->tri) tri_build(L);
+    sched_ensure(L, today_day());
+    cal_ensure(L);
+    simd_init();
+    D->store.journal.defer_sync = 1;
+    if (pipe(D->wake) != 0 || pipe(D->quit) != 0
+        || !set_nonblock(D->wake[0]) || !set_nonblock(D->wake[1]) || !set_nonblock(D->quit[0]) || !set_nonblock(D->quit[1])
+        || (D->ep = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || (D->listen_fd = daemon_listen(sock_path)) < 0
+        || !daemon_watch(D, D->listen_fd, &D->listen_fd) || !daemon_watch(D, D->wake[0], D->wake) || !daemon_watch(D, D->quit[0], D->quit)
+        || (D->store.watch_fd >= 0 && !daemon_watch(D, D->store.watch_fd, &D->store.watch_fd)))
+        return 0;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    D->nworkers = cpus < 2 ? 2 : cpus > DAEMON_WORKERS_MAX ? DAEMON_WORKERS_MAX : (int)cpus;
+    for (int i = 0; i < D->nworkers; ++i)
+        if (pthread_create(&D->worker[i], NULL, daemon_worker, D) != 0) die("pthread_create");
+    return 1;
+}
+
+static void daemon_close(Daemon *D){
+    pthread_mutex_lock(&D->mu);
+    D->stop = 1;
+    pthread_cond_broadcast(&D->cv);
+    pthread_mutex_unlock(&D->mu);
+    for (int i = 0; i < D->nworkers; ++i) pthread_join(D->worker[i], NULL);
+    while (D->all) { Conn *c = D->all; if (!c->closing) close(c->fd); conn_free(D, c); }
+    if (D->listen_fd >= 0) { close(D->listen_fd); unlink(D->sock_path); }
+    int fds[] = { D->ep, D->wake[0], D->wake[1], D->quit[0], D->quit[1] };
+    for (size_t i = 0; i < sizeof fds / sizeof *fds; ++i) if (fds[i] >= 0) close(fds[i]);
+    store_close(&D->store); // syncs the journal
+    pthread_rwlock_destroy(&D->lock);
+    pthread_mutex_destroy(&D->mu);
+    pthread_cond_destroy(&D->cv);
+}
+#endif
+
+// argv[0] is "serve".
+static int run_serve(int argc, char **argv){
+    const char *path = "tasks.json", *sock = NULL;
+    char sock_buf[4096];
+    int i = 1;
+    if (i < argc && strncmp(argv[i], "--", 2) != 0) path = argv[i++];
+    if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) { sock = argv[i + 1]; i += 2; }
+    if (i < argc) { fprintf(stderr, "usage: todo serve [file] [--socket PATH]\n"); return 2; }
+    if (!sock) { snprintf(sock_buf, sizeof sock_buf, "%s.sock", path); sock = sock_buf; }
+#ifdef __linux__
+    Daemon D;
+    if (!daemon_open(&D, path, sock)) { daemon_close(&D); return 1; }
+    g_quit_fd = D.quit[1];
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = on_quit_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    printf("[Serve] %zu tasks from %s on %s (%d workers)\n", D.store.list.live, path, sock, D.nworkers);
+    fflush(stdout);
+    daemon_loop(&D);
+    daemon_close(&D);
+    printf("[End]\n");
+    return 0;
+#else
+    fprintf(stderr, "todo serve needs epoll (Linux)\n");
+    return 1;
+#endif
+}
+
+// Sends one request line and reads the complete reply into *r.
+static int client_call(const char *sock, const char *req, size_t len, WBuf *r){
+    int fd = socket_connect(sock);
+    if (fd < 0) return 0;
+    size_t off = 0;
+    while (off < len) {
+        ssize_t k = write(fd, req + off, len - off);
+        if (k < 0) { if (errno == EINTR) continue; close(fd); return 0; }
+        off += (size_t)k;
+    }
+    long want = -1; // lines still expected after the header
+    size_t scanned = 0;
+    r->len = 0;
+    while (want != 0) {
+        char buf[65536];
+        ssize_t k = read(fd, buf, sizeof buf);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) { close(fd); return 0; }
+        wb_put(r, buf, (size_t)k);
+        for (; scanned < r->len && want != 0; ++scanned) {
+            if (r->buf[scanned] != '\n') continue;
+            if (want > 0) { want--; continue; }
+            want = strncmp(r->buf, "OK ", 3) == 0 ? strtol(r->buf + 3, NULL, 10) : 0;
+        }
+    }
+    close(fd);
+    return 1;
+}
+
+static int client_usage(void){
+    fprintf(stderr, "usage: todo client [--socket PATH] add TITLE [--due D] [--priority P]\n"
+                    "                                   update ID [--title T] [--due D] [--priority P] [--done 0|1]\n"
+                    "                                   done ID | delete ID | get ID | next [K] | search TERMS...\n"
+                    "                                   agenda [DAYS] | overdue\n"
+                    "                                   bulk done|delete|priority P|shift DAYS [--due-before D]\n"
+                    "                                        [--min-priority P] [--open|--done] [--match TEXT] [--all]\n"
+                    "                                   query [--due-before D] [--min-priority P] [--open]\n"
+                    "                                         [--sort due|priority] [--limit K]\n");
+    return 2;
+}
+
+static void wb_field(WBuf *w, const char *s){
+    WB_LIT(w, "\t");
+    wb_tsv_str(w, s);
+}
+
+// argv[0] is "client". Rows are printed as query --format tsv does.
+static int run_client(int argc, char **argv){
+    const char *sock = DAEMON_SOCKET;
+    int i = 1;
+    if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) { sock = argv[i + 1]; i += 2; }
+    if (i >= argc) return client_usage();
+    const char *cmd = argv[i++];
+    WBuf req; wb_init_mem(&req, 256);
+    if (strcmp(cmd, "add") == 0) {
+        if (i >= argc) { free(req.buf); return client_usage(); }
+        const char *title = argv[i++], *due = "", *prio = "";
+        for (; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--due") == 0) due = argv[i + 1];
+            else if (strcmp(argv[i], "--priority") == 0) prio = argv[i + 1];
+            else break;
+        }
+        WB_LIT(&req, "ADD"); wb_field(&req, title); wb_field(&req, due); wb_field(&req, prio);
+    } else if (strcmp(cmd, "update") == 0 && i < argc) {
+        WB_LIT(&req, "UPDATE"); wb_field(&req, argv[i++]);
+        size_t base = req.len;
+        for (; i + 1 < argc && strncmp(argv[i], "--", 2) == 0; i += 2) { wb_field(&req, argv[i] + 2); wb_field(&req, argv[i + 1]); }
+        if (req.len == base) i = -1;
+    } else if (strcmp(cmd, "done") == 0 && i < argc) {
+        WB_LIT(&req, "UPDATE"); wb_field(&req, argv[i++]); WB_LIT(&req, "\tdone\t1");
+    } else if ((strcmp(cmd, "delete") == 0 || strcmp(cmd, "get") == 0) && i < argc) {
+        if (cmd[0] == 'd') WB_LIT(&req, "DEL"); else WB_LIT(&req, "GET");
+        wb_field(&req, argv[i++]);
+    } else if (strcmp(cmd, "bulk") == 0) {
+        Predicate p = { { INT_MAX, 0, 0 }, 0, NULL };
+        int op, arg, at = i, given = 0;
+        char due[DATE_LEN + 1] = "", prio[4] = "";
+        if (!parse_bulk_op(argc, argv, &i, &op, &arg)) i = -1;
+        for (; i > 0 && i < argc; ++i) if (!parse_predicate(argc, argv, &i, &p, &given)) i = -1;
+        if (i > 0 && given) {
+            if (p.filter.due_limit != INT_MAX) day_to_date(p.filter.due_limit, due);
+            if (p.filter.min_priority) snprintf(prio, sizeof prio, "%d", p.filter.min_priority);
+            WB_LIT(&req, "BULK"); wb_field(&req, argv[at]); wb_field(&req, op == BULK_DONE || op == BULK_DELETE ? "" : argv[at + 1]);
+            wb_field(&req, due); wb_field(&req, prio);
+            wb_field(&req, p.filter.only_open ? "open" : p.only_done ? "done" : "");
+            wb_field(&req, p.match ? p.match : "");
+        } else i = -1;
+    } else if (strcmp(cmd, "next") == 0 || strcmp(cmd, "agenda") == 0) {
+        if (cmd[0] == 'n') WB_LIT(&req, "NEXT"); else WB_LIT(&req, "AGENDA");
+        if (i < argc) wb_field(&req, argv[i++]);
+    } else if (strcmp(cmd, "overdue") == 0) {
+        WB_LIT(&req, "OVERDUE");
+    } else if (strcmp(cmd, "search") == 0 && i < argc) {
+        WB_LIT(&req, "SEARCH\t");
+        for (int first = 1; i < argc; ++i, first = 0) { if (!first) WB_LIT(&req, " "); wb_tsv_str(&req, argv[i]); }
+    } else if (strcmp(cmd, "query") == 0) {
+        const char *due = "", *prio = "", *open = "", *sort = "", *limit = "";
+        for (; i < argc; ++i) {
+            const char *opt = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+            if (strcmp(opt, "--open") == 0) { open = "1"; continue; }
+            if (!val) break;
+            ++i;
+            if (strcmp(opt, "--due-before") == 0) due = val;
+            else if (strcmp(opt, "--min-priority") == 0) prio = val;
+            else if (strcmp(opt, "--sort") == 0) sort = val;
+            else if (strcmp(opt, "--limit") == 0) limit = val;
+            else { --i; break; }
+        }
+        WB_LIT(&req, "QUERY"); wb_field(&req, due); wb_field(&req, prio); wb_field(&req, open); wb_field(&req, sort); wb_field(&req, limit);
+    } else i = -1;
+    if (i != argc) { free(req.buf); return client_usage(); }
+    WB_LIT(&req, "\n");
+    WBuf r; wb_init_mem(&r, 4096);
+    int ok = client_call(sock, req.buf, req.len, &r);
+    free(req.buf);
+    if (!ok) { fprintf(stderr, "No daemon answering on %s (start one with: todo serve)\n", sock); free(r.buf); return 1; }
+    char *body = (char*)memchr(r.buf, '\n', r.len) + 1;
+    if (strncmp(r.buf, "OK ", 3) != 0) { fwrite(r.buf, 1, r.len, stderr); free(r.buf); return 1; }
+    fwrite(body, 1, r.len - (size_t)(body - r.buf), stdout);
+    free(r.buf);
+    return 0;
+}
+
+/*---------------- Sharded store ----------------*/
+// todo shards DIR ... keeps one store per project in DIR, so a command opens
+// only the projects it touches. A task's project is the first #tag in its
+// title when it is added (lowercased; "inbox" if there is none), and the
+// task stays in that shard if it is retagged later.
+//
+// DIR/manifest is a few lines of text: the next unused id, each shard with
+// its task count, and the id ranges each shard owns, which is how an id is
+// routed without opening anything. A shard takes new ids a block of
+// SHARD_BLOCK at a time, so the manifest is rewritten once per block rather
+// than once per add. An imported store whose projects interleave by id
+// would need a range per id, so then DIR/idmap holds one u16 shard number
+// per imported id instead, mapped on the first lookup that falls in it.
+// Shards are ordinary <name>.tdb stores (snapshot plus journal), opened on
+// first use; once the open ones exceed the memory budget the least recently
+// used are closed. Queries fan out over the shards on a few threads and
+// merge the per-shard top K. The manifest is only rewritten when something
+// in it changed.
+#define SHARD_BLOCK 4096
+#define SHARD_NAME_MAX 48
+#define SHARD_BUDGET_MB 256
+#define SHARD_THREADS_MAX 8
+#define SHARD_RANGES_MAX 4096   // more runs than this on import: use the id map
+#define IDMAP_NONE 0xFFFFu
+static const char IDMAP_MAGIC[8] = { 'T','O','D','O','I','D','M','P' };
+
+typedef struct { int lo, hi; uint32_t shard; } IdRange;
+
+typedef struct {
+    char name[SHARD_NAME_MAX + 1];
+    char path[4096];
+    size_t count;      // live tasks, refreshed whenever the shard is opened
+    Store *store;      // NULL while closed
+    size_t bytes;      // resident estimate while open
+    uint64_t used;     // LRU clock at last use
+} Shard;
+
+typedef struct {
+    char dir[4096], manifest[4096];
+    Shard *shard; size_t n, cap;
+    IdRange *range; size_t nrange, range_cap; // sorted by lo, disjoint
+    int idmap_base; size_t idmap_count;       // span of ids in DIR/idmap
+    const unsigned char *idmap; size_t idmap_len; // mapping, NULL until needed
+    char idmap_path[4096];
+    int next_id;
+    size_t budget, resident;
+    uint64_t clock;
+    int dirty;         // the manifest on disk is out of date
+} ShardSet;
+
+static void project_of(const char *title, char *out) {
+    for (const char *p = title; (p = strchr(p, '#')) != NULL; ++p) {
+        if (p != title && p[-1] != ' ') continue;
+        size_t n = 0;
+        while (n < SHARD_NAME_MAX && (isalnum((unsigned char)p[1 + n]) || p[1 + n] == '_' || p[1 + n] == '-')) {
+            out[n] = (char)tolower((unsigned char)p[1 + n]);
+            n++;
+        }
+        if (n) { out[n] = '\0'; return; }
+    }
+    strcpy(out, "inbox");
+}
+
+static int shard_find(ShardSet *T, const char *name, int create) {
+    for (size_t i = 0; i < T->n; ++i) if (strcmp(T->shard[i].name, name) == 0) return (int)i;
+    if (!create) return -1;
+    if (T->n == T->cap) {
+        T->cap = T->cap ? T->cap * 2 : 16;
+        T->shard = (Shard*)xrealloc(T->shard, T->cap * sizeof *T->shard);
+    }
+    Shard *s = &T->shard[T->n];
+    memset(s, 0, sizeof *s);
+    T->dirty = 1;
+    snprintf(s->name, sizeof s->name, "%s", name);
+    if ((size_t)snprintf(s->path, sizeof s->path, "%s/%s.tdb", T->dir, s->name) >= sizeof s->path) return -1;
+    return (int)T->n++;
+}
+
+static void range_add(ShardSet *T, int lo, int hi, uint32_t shard) {
+    T->dirty = 1;
+    if (T->nrange && T->range[T->nrange - 1].shard == shard && T->range[T->nrange - 1].hi + 1 == lo) {
+        T->range[T->nrange - 1].hi = hi;
+        return;
+    }
+    if (T->nrange == T->range_cap) {
+        T->range_cap = T->range_cap ? T->range_cap * 2 : 64;
+        T->range = (IdRange*)xrealloc(T->range, T->range_cap * sizeof *T->range);
+    }
+    T->range[T->nrange].lo = lo; T->range[T->nrange].hi = hi; T->range[T->nrange].shard = shard;
+    T->nrange++;
+}
+
+// Shard owning id, or -1.
+static int shard_of_id(ShardSet *T, int id) {
+    if (T->idmap_count && id >= T->idmap_base && (size_t)((int64_t)id - T->idmap_base) < T->idmap_count) {
+        if (!T->idmap) {
+            int fd = open(T->idmap_path, O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size != 16 + 2 * T->idmap_count) { if (fd >= 0) close(fd); return -1; }
+            void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (m == MAP_FAILED) return -1;
+            if (memcmp(m, IDMAP_MAGIC, 8) != 0) { munmap(m, (size_t)st.st_size); return -1; }
+            T->idmap = (const unsigned char*)m; T->idmap_len = (size_t)st.st_size;
+        }
+        const unsigned char *e = T->idmap + 16 + 2 * (size_t)((int64_t)id - T->idmap_base);
+        unsigned v = (unsigned)e[0] | (unsigned)e[1] << 8;
+        return v == IDMAP_NONE || v >= T->n ? -1 : (int)v;
+    }
+    size_t lo = 0, hi = T->nrange;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (T->range[mid].hi < id) lo = mid + 1; else hi = mid;
+    }
+    return lo < T->nrange && T->range[lo].lo <= id ? (int)T->range[lo].shard : -1;
+}
+
+static int manifest_save(ShardSet *T) {
+    char tmp[4096];
+    int fd = open_replacement(T->manifest, tmp, sizeof tmp);
+    if (fd < 0) { perror(T->manifest); return 0; }
+    WBuf w; wb_init(&w, fd);
+    WB_LIT(&w, "TODOSHARDS 1\nnext_id "); wb_int(&w, T->next_id); WB_LIT(&w, "\n");
+    if (T->idmap_count) {
+        WB_LIT(&w, "idmap "); wb_int(&w, T->idmap_base);
+        WB_LIT(&w, " "); wb_int(&w, (int)T->idmap_count); WB_LIT(&w, "\n");
+    }
+    for (size_t i = 0; i < T->n; ++i) {
+        WB_LIT(&w, "shard "); wb_put(&w, T->shard[i].name, strlen(T->shard[i].name));
+        WB_LIT(&w, " "); wb_int(&w, (int)T->shard[i].count); WB_LIT(&w, "\n");
+    }
+    for (size_t i = 0; i < T->nrange; ++i) {
+        WB_LIT(&w, "range "); wb_int(&w, (int)T->range[i].shard);
+        WB_LIT(&w, " "); wb_int(&w, T->range[i].lo);
+        WB_LIT(&w, " "); wb_int(&w, T->range[i].hi); WB_LIT(&w, "\n");
+    }
+    wb_flush(&w);
+    if (!commit_replacement(fd, tmp, T->manifest, w.err)) return 0;
+    T->dirty = 0;
+    return 1;
+}
+
+// Reads DIR/manifest (an absent one is an empty set); opens no shards.
+static int shards_open(ShardSet *T, const char *dir, size_t budget) {
+    memset(T, 0, sizeof *T);
+    T->next_id = 1;
+    T->budget = budget;
+    if ((size_t)snprintf(T->dir, sizeof T->dir, "%s", dir) >= sizeof T->dir
+        || (size_t)snprintf(T->manifest, sizeof T->manifest, "%s/manifest", dir) >= sizeof T->manifest
+        || (size_t)snprintf(T->idmap_path, sizeof T->idmap_path, "%s/idmap", dir) >= sizeof T->idmap_path) return 0;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) { perror(dir); return 0; }
+    FILE *f = fopen(T->manifest, "r");
+    if (!f) return errno == ENOENT;
+    char line[256], name[SHARD_NAME_MAX + 1];
+    int ok = fgets(line, sizeof line, f) && strcmp(line, "TODOSHARDS 1\n") == 0;
+    while (ok && fgets(line, sizeof line, f)) {
+        unsigned long count, shard; int lo, hi;
+        if (sscanf(line, "next_id %d", &T->next_id) == 1) continue;
+        if (sscanf(line, "idmap %d %lu", &lo, &count) == 2) { T->idmap_base = lo; T->idmap_count = count; continue; }
+        if (sscanf(line, "shard %48s %lu", name, &count) == 2) {
+            int i = shard_find(T, name, 1);
+            if (i < 0) ok = 0; else T->shard[i].count = count;
+        } else if (sscanf(line, "range %lu %d %d", &shard, &lo, &hi) == 3 && shard < T->n && lo <= hi
+                   && (!T->nrange || T->range[T->nrange - 1].hi < lo)) {
+            range_add(T, lo, hi, (uint32_t)shard);
+        } else ok = 0;
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: not a shard manifest\n", T->manifest);
+    T->dirty = 0;
+    return ok;
+}
+
+static void shard_count(ShardSet *T, size_t i, size_t count) {
+    if (T->shard[i].count != count) { T->shard[i].count = count; T->dirty = 1; }
+}
+
+static void shard_close(ShardSet *T, size_t i) {
+    Shard *s = &T->shard[i];
+    if (!s->store) return;
+    shard_count(T, i, s->store->list.live);
+    store_close(s->store);
+    free(s->store);
+    s->store = NULL;
+    T->resident -= s->bytes;
+    s->bytes = 0;
+}
+
+// Closes least recently used shards, never keep, until under the budget.
+static void shards_evict(ShardSet *T, size_t keep) {
+    while (T->resident > T->budget) {
+        size_t lru = T->n;
+        for (size_t i = 0; i < T->n; ++i)
+            if (i != keep && T->shard[i].store && (lru == T->n || T->shard[i].used < T->shard[lru].used)) lru = i;
+        if (lru == T->n) return;
+        shard_close(T, lru);
+    }
+}
+
+// Takes over an opened store as shard i's and accounts for it.
+static void shard_adopt(ShardSet *T, size_t i, Store *S) {
+    Shard *s = &T->shard[i];
+    s->store = S;
+    shard_count(T, i, S->list.live);
+    s->bytes = list_bytes(&S->list);
+    s->used = ++T->clock;
+    T->resident += s->bytes;
+    shards_evict(T, i);
+}
+
+static Store *shard_store(ShardSet *T, size_t i) {
+    Shard *s = &T->shard[i];
+    if (s->store) { s->used = ++T->clock; return s->store; }
+    Store *S = (Store*)xmalloc(sizeof *S);
+    if (!store_open(S, s->path, 0)) { fprintf(stderr, "Failed to load %s\n", s->path); store_close(S); free(S); return NULL; }
+    shard_adopt(T, i, S);
+    return S;
+}
+
+// After an edit: the shard may have grown past what was accounted for.
+static void shard_touched(ShardSet *T, size_t i) {
+    Shard *s = &T->shard[i];
+    size_t b = list_bytes(&s->store->list);
+    T->resident += b - s->bytes;
+    s->bytes = b;
+    shard_count(T, i, s->store->list.live);
+    shards_evict(T, i);
+}
+
+static void shards_close(ShardSet *T) {
+    for (size_t i = 0; i < T->n; ++i) shard_close(T, i);
+    if (T->dirty) manifest_save(T);
+    if (T->idmap) munmap((void*)T->idmap, T->idmap_len);
+    free(T->shard); free(T->range);
+    memset(T, 0, sizeof *T);
+}
+
+// Next id for shard i: after its highest id, inside a block it owns. A new
+// block is recorded in the manifest before any id from it is used.
+static int shard_next_id(ShardSet *T, size_t i, const TaskList *L) {
+    for (size_t r = T->nrange; r-- > 0;) {
+        if (T->range[r].shard != i) continue;
+        int next = L->max_id + 1 > T->range[r].lo ? L->max_id + 1 : T->range[r].lo;
+        if (next <= T->range[r].hi) return next;
+        break;
+    }
+    int id = T->next_id;
+    range_add(T, id, id + SHARD_BLOCK - 1, (uint32_t)i);
+    T->next_id += SHARD_BLOCK;
+    return manifest_save(T) ? id : -1;
+}
+
+static int shards_add(ShardSet *T, Task *t, const char **shard_name) {
+    char name[SHARD_NAME_MAX + 1];
+    project_of(t->title, name);
+    int i = shard_find(T, name, 1);
+    Store *S = i < 0 ? NULL : shard_store(T, (size_t)i);
+    if (!S || (t->id = shard_next_id(T, (size_t)i, &S->list)) < 0) return 0;
+    list_push(&S->list, *t);
+    store_put(S, t);
+    shard_touched(T, (size_t)i);
+    *shard_name = T->shard[i].name;
+    return 1;
+}
+
+// Opens the shard owning id; returns the store and sets *idx, or NULL.
+static Store *shards_locate(ShardSet *T, int id, int *shard, int *idx) {
+    *shard = shard_of_id(T, id);
+    Store *S = *shard < 0 ? NULL : shard_store(T, (size_t)*shard);
+    if (!S || (*idx = list_find_index_by_id(&S->list, id)) < 0) return NULL;
+    return S;
+}
+
+// pair[] is (id key << 32 | shard), sorted; ids span [lo, lo + span).
+static int idmap_save(ShardSet *T, const uint64_t *pair, size_t n, int lo, size_t span) {
+    unsigned char *m = (unsigned char*)xmalloc(16 + 2 * span);
+    memcpy(m, IDMAP_MAGIC, 8);
+    put_u32(m + 8, (uint32_t)lo);
+    put_u32(m + 12, (uint32_t)span);
+    memset(m + 16, 0xFF, 2 * span);
+    for (size_t k = 0; k < n; ++k) {
+        unsigned char *e = m + 16 + 2 * (size_t)((int64_t)tri_unkey((uint32_t)(pair[k] >> 32)) - lo);
+        e[0] = (unsigned char)pair[k]; e[1] = (unsigned char)(pair[k] >> 8);
+    }
+    char tmp[4096];
+    int fd = open_replacement(T->idmap_path, tmp, sizeof tmp);
+    if (fd < 0) { perror(T->idmap_path); free(m); return 0; }
+    WBuf w; wb_init(&w, fd);
+    wb_put(&w, (const char*)m, 16 + 2 * span);
+    wb_flush(&w);
+    free(m);
+    T->idmap_base = lo; T->idmap_count = span;
+    return commit_replacement(fd, tmp, T->idmap_path, w.err);
+}
+
+// Splits an existing store by project. Ids are kept; the manifest records
+// each shard's runs of consecutive ids, or the id map does.
+static int shards_import(ShardSet *T, const char *path) {
+    if (T->n) { fprintf(stderr, "%s already holds shards\n", T->dir); return 0; }
+    Store src;
+    if (!store_open(&src, path, 0)) { fprintf(stderr, "Failed to load %s\n", path); store_close(&src); return 0; }
+    TaskList *L = &src.list;
+    uint64_t *pair = (uint64_t*)xmalloc((L->live + 1) * sizeof *pair); // id key << 32 | shard
+    TaskList *part = NULL;
+    size_t n = 0;
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i)) continue;
+        char name[SHARD_NAME_MAX + 1];
+        Task t; list_get(L, i, &t);
+        project_of(t.title, name);
+        size_t before = T->n;
+        int s = shard_find(T, name, 1);
+        if (s < 0) { fprintf(stderr, "Shard path too long for %s\n", name); break; }
+        if (T->n != before) { part = (TaskList*)xrealloc(part, T->n * sizeof *part); list_init(&part[s]); }
+        list_push(&part[s], t);
+        pair[n++] = (uint64_t)tri_key(t.id) << 32 | (uint32_t)s;
+    }
+    int ok = n == L->live;
+    qsort(pair, n, sizeof *pair, cmp_u64);
+    size_t runs = 0;
+    for (size_t k = 0; k < n; ++k) runs += !k || (uint32_t)pair[k] != (uint32_t)pair[k - 1];
+    int lo = n ? tri_unkey((uint32_t)(pair[0] >> 32)) : 0, hi = n ? tri_unkey((uint32_t)(pair[n - 1] >> 32)) : 0;
+    size_t span = n ? (size_t)((int64_t)hi - lo + 1) : 0;
+    if (runs > SHARD_RANGES_MAX && span <= 4 * n + SHARD_BLOCK && T->n < IDMAP_NONE) {
+        ok = ok && idmap_save(T, pair, n, lo, span);
+    } else {
+        for (size_t k = 0; k < n; ++k) range_add(T, tri_unkey((uint32_t)(pair[k] >> 32)), tri_unkey((uint32_t)(pair[k] >> 32)), (uint32_t)pair[k]);
+    }
+    T->next_id = L->max_id + 1;
+    for (size_t s = 0; s < T->n; ++s) {
+        shard_count(T, s, part[s].live);
+        ok = ok && save_tasks(T->shard[s].path, &part[s]);
+        list_free(&part[s]);
+    }
+    ok = ok && manifest_save(T);
+    free(part); free(pair);
+    store_close(&src);
+    return ok;
+}
+
+typedef struct { uint64_t key; Task task; } ShardHit;
+
+typedef struct {
+    ShardSet *set;
+    const Query *q;
+    const char *project;  // only this shard, or NULL
+    pthread_mutex_t mu;
+    size_t next;          // next shard to take
+    size_t kept;          // bytes of the opened stores being kept
+    ShardHit **hits; size_t *nhits;
+    Store **opened;       // stores a worker opened and kept, adopted afterwards
+    size_t *live;         // task counts of the shards opened, SIZE_MAX if not opened
+} FanOut;
+
+// Shards already open are only read. Closed ones are opened privately,
+// outside the lock, and kept for the main thread to adopt only if they fit
+// in the budget next to what is resident; otherwise they are closed as soon
+// as they are scanned.
+static void *fanout_worker(void *arg) {
+    FanOut *F = (FanOut*)arg;
+    ShardSet *T = F->set;
+    for (;;) {
+        pthread_mutex_lock(&F->mu);
+        size_t i = F->next++;
+        pthread_mutex_unlock(&F->mu);
+        if (i >= T->n) return NULL;
+        if (F->project && strcmp(T->shard[i].name, F->project) != 0) continue;
+        Store *S = T->shard[i].store, *own = NULL;
+        if (!S) {
+            own = (Store*)xmalloc(sizeof *own);
+            if (!store_open(own, T->shard[i].path, 0)) {
+                fprintf(stderr, "Failed to load %s\n", T->shard[i].path);
+                store_close(own); free(own);
+                continue;
+            }
+            S = own;
+        }
+        const TaskList *L = &S->list;
+        size_t cap = F->q->limit && F->q->limit < L->live ? F->q->limit : L->live;
+        uint32_t *slot = (uint32_t*)xmalloc((cap ? cap : 1) * sizeof *slot);
+        size_t n = query_select(L, F->q, slot);
+        ShardHit *h = (ShardHit*)xmalloc((n ? n : 1) * sizeof *h);
+        for (size_t k = 0; k < n; ++k) { h[k].key = sort_key(L, slot[k], F->q->view); list_get(L, slot[k], &h[k].task); }
+        F->hits[i] = h; F->nhits[i] = n;
+        free(slot);
+        if (!own) continue;
+        size_t bytes = list_bytes(L);
+        F->live[i] = L->live;
+        pthread_mutex_lock(&F->mu);
+        int keep = T->resident + F->kept + bytes <= T->budget;
+        if (keep) { F->kept += bytes; F->opened[i] = own; }
+        pthread_mutex_unlock(&F->mu);
+        if (!keep) { store_close(own); free(own); }
+    }
+}
+
+static int cmp_hit(const void *a, const void *b) {
+    uint64_t x = ((const ShardHit*)a)->key, y = ((const ShardHit*)b)->key;
+    return (x > y) - (x < y);
+}
+
+// Matching tasks from every shard (or just project), in query order, into R.
+static void shards_select(ShardSet *T, const Query *q, const char *project, int threads, TaskList *R) {
+    FanOut F;
+    memset(&F, 0, sizeof F);
+    F.set = T; F.q = q; F.project = project;
+    pthread_mutex_init(&F.mu, NULL);
+    F.hits = (ShardHit**)xmalloc((T->n + 1) * sizeof *F.hits);
+    F.nhits = (size_t*)xmalloc((T->n + 1) * sizeof *F.nhits);
+    F.opened = (Store**)xmalloc((T->n + 1) * sizeof *F.opened);
+    F.live = (size_t*)xmalloc((T->n + 1) * sizeof *F.live);
+    memset(F.hits, 0, (T->n + 1) * sizeof *F.hits);
+    memset(F.nhits, 0, (T->n + 1) * sizeof *F.nhits);
+    memset(F.opened, 0, (T->n + 1) * sizeof *F.opened);
+    for (size_t i = 0; i <= T->n; ++i) F.live[i] = SIZE_MAX;
+    simd_init();
+    pthread_t tid[SHARD_THREADS_MAX];
+    int nt = threads < 1 ? 1 : threads > SHARD_THREADS_MAX ? SHARD_THREADS_MAX : threads;
+    if ((size_t)nt > T->n) nt = T->n ? (int)T->n : 1;
+    for (int k = 0; k < nt; ++k) if (pthread_create(&tid[k], NULL, fanout_worker, &F) != 0) die("pthread_create");
+    for (int k = 0; k < nt; ++k) pthread_join(tid[k], NULL);
+    size_t total = 0;
+    for (size_t i = 0; i < T->n; ++i) total += F.nhits[i];
+    ShardHit *all = (ShardHit*)xmalloc((total ? total : 1) * sizeof *all);
+    total = 0;
+    for (size_t i = 0; i < T->n; ++i) {
+        if (F.nhits[i]) memcpy(all + total, F.hits[i], F.nhits[i] * sizeof *all);
+        total += F.nhits[i];
+        free(F.hits[i]);
+        if (F.opened[i]) shard_adopt(T, i, F.opened[i]);
+        else if (F.live[i] != SIZE_MAX) shard_count(T, i, F.live[i]);
+    }
+    qsort(all, total, sizeof *all, cmp_hit);
+    if (q->limit && total > q->limit) total = q->limit;
+    for (size_t k = 0; k < total; ++k) list_push(R, all[k].task);
+    free(all); free(F.hits); free(F.nhits); free(F.opened); free(F.live);
+    pthread_mutex_destroy(&F.mu);
+}
+
+static void shards_query(ShardSet *T, const Query *q, const char *project, int threads) {
+    TaskList R; list_init(&R);
+    shards_select(T, q, project, threads, &R);
+    uint32_t *slot = (uint32_t*)xmalloc((R.len ? R.len : 1) * sizeof *slot);
+    for (size_t k = 0; k < R.len; ++k) slot[k] = (uint32_t)k;
+    query_write(&R, q, slot, R.len);
+    free(slot);
+    list_free(&R);
+}
+
+static int shards_usage(void){
+    fprintf(stderr, "usage: todo shards DIR import FILE\n"
+                    "       todo shards DIR list\n"
+                    "       todo shards DIR add TITLE [--due D] [--priority P]\n"
+                    "       todo shards DIR done ID | delete ID\n"
+                    "       todo shards DIR query [--project NAME] [--threads T] [query options]\n"
+                    "       (any form also takes --budget MB, default %d)\n", SHARD_BUDGET_MB);
+    return 2;
+}
+
+// argv[0] is "shards".
+static int run_shards(int argc, char **argv){
+    if (argc < 3) return shards_usage();
+    const char *dir = argv[1], *cmd = argv[2], *project = NULL;
+    size_t budget = (size_t)SHARD_BUDGET_MB << 20;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus < 1 ? 1 : (int)cpus;
+    // Pull out the shard options; what remains is the command's own.
+    char **rest = (char**)xmalloc((size_t)argc * sizeof *rest);
+    int nrest = 0;
+    for (int i = 3; i < argc; ++i) {
+        int mb = 0;
+        if (i + 1 < argc && strcmp(argv[i], "--budget") == 0 && parse_int_field(argv[i + 1], 1, 1 << 20, &mb)) { budget = (size_t)mb << 20; ++i; }
+        else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0 && parse_int_field(argv[i + 1], 1, SHARD_THREADS_MAX, &threads)) ++i;
+        else if (i + 1 < argc && strcmp(argv[i], "--project") == 0) project = argv[++i];
+        else rest[nrest++] = argv[i];
+    }
+    ShardSet T;
+    int rc = 0;
+    if (!shards_open(&T, dir, budget)) { free(rest); free(T.shard); free(T.range); return 1; }
+    if (strcmp(cmd, "import") == 0 && nrest == 1) {
+        rc = shards_import(&T, rest[0]) ? 0 : 1;
+        if (!rc) printf("Imported %s into %zu shard%s in %s\n", rest[0], T.n, T.n == 1 ? "" : "s", dir);
+    } else if (strcmp(cmd, "list") == 0 && nrest == 0) {
+        for (size_t i = 0; i < T.n; ++i) printf("%-*s %zu\n", SHARD_NAME_MAX / 2, T.shard[i].name, T.shard[i].count);
+    } else if (strcmp(cmd, "add") == 0 && nrest >= 1 && nrest % 2 == 1) {
+        Task t; memset(&t, 0, sizeof t);
+        t.priority = 3;
+        int valid = task_set_field(&t, "title", rest[0]);
+        for (int i = 1; valid && i < nrest; i += 2)
+            valid = strncmp(rest[i], "--", 2) == 0 && (strcmp(rest[i], "--due") == 0 || strcmp(rest[i], "--priority") == 0)
+                 && task_set_field(&t, rest[i] + 2, rest[i + 1]);
+        const char *name;
+        if (!valid) rc = shards_usage();
+        else if (!shards_add(&T, &t, &name)) rc = 1;
+        else printf("Added id %d to %s.\n", t.id, name);
+    } else if ((strcmp(cmd, "done") == 0 || strcmp(cmd, "delete") == 0) && nrest == 1) {
+        int id, shard, idx;
+        Store *S = parse_int_field(rest[0], 1, INT_MAX, &id) ? shards_locate(&T, id, &shard, &idx) : NULL;
+        if (!S) { fprintf(stderr, "Not found.\n"); rc = 1; }
+        else if (strcmp(cmd, "done") == 0) {
+            Task t; list_get(&S->list, (size_t)idx, &t);
+            t.done = 1;
+            list_replace(&S->list, (size_t)idx, &t);
+            store_put(S, &t);
+            shard_touched(&T, (size_t)shard);
+            printf("Done.\n");
+        } else {
+            list_delete_at(&S->list, (size_t)idx);
+            store_del(S, id);
+            shard_touched(&T, (size_t)shard);
+            printf("Deleted.\n");
+        }
+    } else if (strcmp(cmd, "query") == 0) {
+        // Same options as todo query, parsed by it.
+        char **qargv = (char**)xmalloc((size_t)(nrest + 1) * sizeof *qargv);
+        qargv[0] = (char*)"query";
+        memcpy(qargv + 1, rest, (size_t)nrest * sizeof *rest);
+        Query q;
+        if (!parse_query_args(nrest + 1, qargv, 1, &q)) rc = query_usage();
+        else if (project && shard_find(&T, project, 0) < 0) { fprintf(stderr, "No shard %s\n", project); rc = 1; }
+        else shards_query(&T, &q, project, threads);
+        free(qargv);
+    } else rc = shards_usage();
+    free(rest);
+    shards_close(&T);
+    return rc;
+}
+
+/*---------------- Benchmark ----------------*/
+// todo --bench N [--reps R] [--seed S] generates N tasks from a fixed seed,
+// times the main operations R times each and prints a JSON report (best and
+// median milliseconds, items per second at the median, peak RSS) so runs at
+// different sizes and builds can be compared. The load timings include
+// reading every task back, so a mapped snapshot is not timed as a bare mmap.
+// Scratch files go to the working directory as todo_bench.json /
+// todo_bench.tdb and are removed.
+#define BENCH_REPS 5
+#define BENCH_SEED 20240229u
+#define BENCH_OPS 10
+
+static uint64_t bench_next(uint64_t *s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull); // splitmix64
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned bench_below(uint64_t *s, unsigned n) { return (unsigned)(bench_next(s) % n); }
+
+static const char *const BENCH_WORDS[] = {
+    "review", "fix", "write", "call", "email", "plan", "buy", "book", "update", "clean",
+    "report", "invoice", "dentist", "groceries", "release", "draft", "notes", "meeting",
+    "budget", "tests", "backup", "renew", "passport", "garden", "slides", "quarterly",
+};
+static const char *const BENCH_TAGS[] = { "#work", "#home", "#errands", "#health", "#side" };
+
+// Mostly short titles, a tail of long ones, and the odd character that
+// needs escaping; due dates within a year either side of 2026-01-01 or none;
+// priorities weighted towards 3.
+static void bench_task(uint64_t *s, int id, Task *t) {
+    static const int prio_cdf[5] = { 10, 30, 70, 90, 100 };
+    memset(t, 0, sizeof *t);
+    t->id = id;
+    unsigned r = bench_below(s, 100);
+    unsigned words = r < 70 ? 2 + r % 5 : r < 95 ? 7 + r % 8 : 15 + r % 10;
+    size_t n = 0;
+    for (unsigned w = 0; w < words && n < TITLE_MAX; ++w) {
+        const char *word = BENCH_WORDS[bench_below(s, sizeof BENCH_WORDS / sizeof *BENCH_WORDS)];
+        n += (size_t)snprintf(t->title + n, sizeof t->title - n, "%s%s", w ? " " : "", word);
+    }
+    if (n > TITLE_MAX) n = TITLE_MAX;
+    if (bench_below(s, 4) == 0 && n + 8 < TITLE_MAX)
+        n += (size_t)snprintf(t->title + n, sizeof t->title - n, " %s", BENCH_TAGS[bench_below(s, 5)]);
+    r = bench_below(s, 100);
+    if (r < 8 && n) t->title[bench_below(s, (unsigned)n)] = r < 5 ? '"' : r < 7 ? '\\' : '\t';
+    if (bench_below(s, 5)) day_to_date(date_to_day("2026-01-01") - 365 + (int)bench_below(s, 731), t->due);
+    r = bench_below(s, 100);
+    t->priority = 1;
+    while (r >= (unsigned)prio_cdf[t->priority - 1]) t->priority++;
+    t->done = bench_below(s, 4) == 0;
+}
+
+static double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct { const char *name; size_t items; double best, median; } BenchOp;
+
+// Reads every field of every task, so a load that only maps the file pays for
+// faulting it in like one that parses it. Lists with the same tasks give the
+// same sum, in any order.
+static uint64_t bench_touch(const TaskList *L) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i)) continue;
+        Task t; list_get(L, i, &t);
+        uint64_t x = (uint64_t)crc32_buf((const unsigned char*)t.title, strlen(t.title)) << 32 ^ (uint64_t)(uint32_t)t.id;
+        x ^= (uint64_t)(uint32_t)t.due_day << 16 ^ (uint64_t)t.priority << 8 ^ (uint64_t)t.done;
+        sum += bench_next(&x);
+    }
+    return sum;
+}
+
+static void bench_record(BenchOp *op, const char *name, size_t items, double *ms, int reps) {
+    qsort(ms, (size_t)reps, sizeof *ms, cmp_double);
+    op->name = name; op->items = items;
+    op->best = ms[0];
+    op->median = reps % 2 ? ms[reps / 2] : (ms[reps / 2 - 1] + ms[reps / 2]) / 2;
+}
+
+// argv[0] is "--bench".
+static int run_bench(int argc, char **argv) {
+    int n = 0, reps = BENCH_REPS, valid = argc > 1 && argc % 2 == 0 && parse_int_field(argv[1], 1, INT_MAX / 2, &n);
+    uint64_t seed = BENCH_SEED;
+    for (int i = 2; valid && i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--reps") == 0) valid = parse_int_field(argv[i + 1], 1, 1000, &reps);
+        else if (strcmp(argv[i], "--seed") == 0) {
+            char *end;
+            errno = 0;
+            seed = strtoull(argv[i + 1], &end, 10);
+            valid = isdigit((unsigned char)argv[i + 1][0]) && !*end && errno != ERANGE;
+        } else valid = 0;
+    }
+    if (!valid) {
+        fprintf(stderr, "usage: todo --bench N [--reps R] [--seed S]\n");
+        return 2;
+    }
+    const char *json_path = "todo_bench.json", *snap_path = "todo_bench.tdb";
+    BenchOp op[BENCH_OPS];
+    int nop = 0, ok = 1;
+    double *ms = (double*)xmalloc((size_t)reps * sizeof *ms);
+    uint64_t rng = seed;
+    TaskList L; list_init(&L);
+    double t0 = bench_now_ms();
+    for (int id = 1; id <= n; ++id) { Task t; bench_task(&rng, id, &t); list_push(&L, t); }
+    ms[0] = bench_now_ms() - t0;
+    bench_record(&op[nop++], "generate", L.live, ms, 1);
+    simd_init();
+    uint64_t want = bench_touch(&L);
+
+    const char *path[2] = { json_path, snap_path };
+    static const char *const save_name[2] = { "save_json", "save_snapshot" }, *const load_name[2] = { "load_json", "load_snapshot" };
+    for (int f = 0; f < 2; ++f) {
+        for (int r = 0; r < reps; ++r) {
+            t0 = bench_now_ms();
+            ok = save_tasks(path[f], &L) && ok;
+            ms[r] = bench_now_ms() - t0;
+        }
+        bench_record(&op[nop++], save_name[f], L.live, ms, reps);
+        for (int r = 0; r < reps; ++r) {
+            TaskList R; list_init(&R);
+            t0 = bench_now_ms();
+            ok = load_tasks(path[f], &R) && bench_touch(&R) == want && ok;
+            ms[r] = bench_now_ms() - t0;
+            list_free(&R);
+        }
+        bench_record(&op[nop++], load_name[f], L.live, ms, reps);
+        unlink(path[f]);
+    }
+
+    static const char *const sort_name[VIEW_COUNT] = { "sort_due", "sort_priority" };
+    for (int v = 0; v < VIEW_COUNT; ++v) {
+        for (int r = 0; r < reps; ++r) {
+            list_invalidate_views(&L);
+            t0 = bench_now_ms();
+            ok = list_view(&L, v)->n == L.live && ok;
+            ms[r] = bench_now_ms() - t0;
+        }
+        bench_record(&op[nop++], sort_name[v], L.live, ms, reps);
+    }
+
+    Filter flt = { date_to_day("2026-06-30"), 3, 1 };
+    uint64_t *sel = (uint64_t*)xmalloc((done_words(L.len) + 1) * sizeof *sel);
+    for (int r = 0; r < reps; ++r) {
+        t0 = bench_now_ms();
+        filter_select(&L, &flt, sel);
+        ms[r] = bench_now_ms() - t0;
+    }
+    bench_record(&op[nop++], "filter", L.len, ms, reps);
+    free(sel);
+
+    // Ids drawn up front so the timing is the index alone.
+    size_t nq = (size_t)n;
+    int *ids = (int*)xmalloc(nq * sizeof *ids);
+    for (size_t i = 0; i < nq; ++i) ids[i] = 1 + (int)bench_below(&rng, (unsigned)n);
+    for (int r = 0; r < reps; ++r) {
+        long hits = 0;
+        t0 = bench_now_ms();
+        for (size_t i = 0; i < nq; ++i) hits += list_find_index_by_id(&L, ids[i]) >= 0;
+        ms[r] = bench_now_ms() - t0;
+        ok = hits == (long)nq && ok;
+    }
+    bench_record(&op[nop++], "lookup", nq, ms, reps);
+
+    // A tenth of the tasks, in random order, from a fresh copy each time.
+    size_t nd = (size_t)n / 10 ? (size_t)n / 10 : 1;
+    for (int r = 0; r < reps; ++r) {
+        TaskList C; list_clone(&C, &L);
+        list_find_index_by_id(&C, 1);
+        t0 = bench_now_ms();
+        for (size_t i = 0; i < nd; ++i) {
+            int idx = list_find_index_by_id(&C, ids[i]);
+            if (idx >= 0) list_delete_at(&C, (size_t)idx);
+        }
+        ms[r] = bench_now_ms() - t0;
+        list_free(&C);
+    }
+    bench_record(&op[nop++], "delete", nd, ms, reps);
+    free(ids);
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    static const char *const simd_names[] = { "scalar", "sse2", "avx2" };
+    printf("{\n  \"n\": %d,\n  \"seed\": %llu,\n  \"reps\": %d,\n  \"simd\": \"%s\",\n  \"ops\": [\n",
+           n, (unsigned long long)seed, reps, simd_names[simd_level]);
+    for (int i = 0; i < nop; ++i)
+        printf("    { \"op\": \"%s\", \"items\": %zu, \"best_ms\": %.3f, \"median_ms\": %.3f, \"items_per_s\": %.0f }%s\n",
+               op[i].name, op[i].items, op[i].best, op[i].median,
+               op[i].median > 0 ? op[i].items / (op[i].median / 1e3) : 0.0, i + 1 < nop ? "," : "");
+    // ru_maxrss is KiB on Linux, bytes on macOS.
+    printf("  ],\n  \"ok\": %s,\n  \"peak_rss_kb\": %ld\n}\n", ok ? "true" : "false",
+#ifdef __APPLE__
+           (long)(ru.ru_maxrss / 1024)
+#else
+           (long)ru.ru_maxrss
+#endif
+           );
+    free(ms);
+    list_free(&L);
+    return ok ? 0 : 1;
+}
+
+/*---------------- Tests ----------------*/
+static int tasks_equal(const Task *a, const Task *b){
+    return a->id==b->id && a->priority==b->priority && a->done==b->done && strcmp(a->title,b->title)==0 && strcmp(a->due,b->due)==0;
+}
+
+static int slots_equal(const TaskList *A, size_t i, const TaskList *B, size_t j){
+    Task a, b;
+    list_get(A, i, &a); list_get(B, j, &b);
+    return tasks_equal(&a, &b);
+}
+
+static Task task_at(const TaskList *L, size_t i){
+    Task t; list_get(L, i, &t);
+    return t;
+}
+
+static int run_tests(void){
+    TaskList A; list_init(&A);
+    Task t1 = { .id=1, .title="Write \"docs\" \\ core", .due="2025-08-26", .priority=5, .done=0 };
+    Task t2 = { .id=2, .title="Refactor", .due="", .priority=2, .done=1 };
+    list_push(&A, t1); list_push(&A, t2);
+    const char *path = "tasks_test.json";
+    if (!save_tasks(path, &A)) { list_free(&A); return 0; }
+
+    TaskList B; list_init(&B);
+    if (!load_tasks(path, &B)) { list_free(&A); list_free(&B); return 0; }
+    int ok = (A.len==B.len);
+    if (ok){ for (size_t i=0;i<A.len;i++){ if (!slots_equal(&A, i, &B, i)) { ok=0; break; } } }
+
+    if (ok) printf("Test: round-trip OK (%zu items)\n", A.len);
+    else printf("Test: round-trip FAILED\n");
+
+    list_free(&A); list_free(&B);
+    return ok;
+}
+
+// Chunk boundaries may fall anywhere, including inside escapes and skipped values.
+static int test_stream(void){
+    static const char doc[] =
+        "[ {\"id\": 7, \"x\": {\"a\": [1, \"}]\\\"\"]}, \"title\": \"a\\\"b\\\\c\\u00e9\","
+        " \"due\": \"2025-02-28\", \"priority\": 2, \"done\": true, \"n\": null},\n"
+        "  {\"title\":\"z\",\"id\":8} ] trailing";
+    int ok = 1;
+    for (size_t step = 1; step <= sizeof doc; step += 5) {
+        TaskList L; list_init(&L);
+        TaskStream ts; ts_init(&ts, sink_push, &L);
+        for (size_t i = 0; i < sizeof doc - 1; i += step) {
+            size_t n = sizeof doc - 1 - i < step ? sizeof doc - 1 - i : step;
+            if (!ts_feed(&ts, doc + i, n)) break;
+        }
+        ok = ok && ts_finish(&ts) && L.len == 2;
+        if (ok) {
+            Task a = task_at(&L, 0), b = task_at(&L, 1);
+            ok = a.id == 7 && strcmp(a.title, "a\"b\\c?") == 0 && strcmp(a.due, "2025-02-28") == 0 && a.priority == 2 && a.done == 1
+                && b.id == 8 && strcmp(b.title, "z") == 0 && b.priority == 3;
+        }
+        list_free(&L);
+    }
+    static const char *bad[] = { "", "[", "[{\"id\":1}", "[{\"id\":99999999999}]", "[{\"due\":\"2025-13-01\"}]", "[{\"done\":tru}]" };
+    for (size_t k = 0; k < sizeof bad / sizeof bad[0]; ++k) {
+        TaskList L; list_init(&L);
+        TaskStream ts; ts_init(&ts, sink_push, &L);
+        if (ts_feed(&ts, bad[k], strlen(bad[k])) && ts_finish(&ts)) ok = 0;
+        list_free(&L);
+    }
+    printf("Test: streaming reader %s\n", ok ? "OK" : "FAILED");
+    return ok;
+}
+
+// The threaded loader must give exactly what the sequential stream gives.
+static int test_parallel_load(void){
+    size_t cap = 4u << 20, n = 0;
+    char *doc = (char*)xmalloc(cap);
+    n += (size_t)sprintf(doc + n, "[\n");
+    for (int i = 1; n + 256 < cap; ++i) {
+        n += (size_t)sprintf(doc + n, "%s  { \"id\": %d, \"title\": \"t%d {[\\\"}]\\\\\", \"meta\": {\"k\": [\"}\", {}]}, "
+                             "\"due\": \"\", \"priority\": %d, \"done\": %s }",
+                             i > 1 ? ",\n" : "", i, i, 1 + i % 5, i % 3 ? "false" : "true");
+    }
+    n += (size_t)sprintf(doc + n, "\n]\n");
+    TaskList A; list_init(&A);
+    TaskStream ts; ts_init(&ts, sink_push, &A);
+    int ok = ts_feed(&ts, doc, n) && ts_finish(&ts);
+    simd_init();
+    int saved = simd_level;
+    for (int lvl = SIMD_NONE; ok && lvl <= saved; ++lvl) {
+        simd_force(lvl);
+        TaskList B; list_init(&B);
+        ok = parse_buffer_parallel(doc, n, &B, 4) == 1 && A.len == B.len;
+        for (size_t i = 0; ok && i < A.len; ++i) ok = slots_equal(&A, i, &B, i);
+        list_free(&B);
+    }
+    simd_force(saved);
+    printf("Test: parallel load %s (%zu items)\n", ok ? "OK" : "FAILED", A.len);
+    list_free(&A); free(doc);
+    return ok;
+}
+
+// Replays after a simulated crash, with a torn tail and a half-done compaction.
+static int test_journal(void){
+    const char *path = "tasks_journal_test.json";
+    Store S; int ok = 1;
+    unlink(path);
+    ok = store_open(&S, path, 0);
+    for (int i = 1; ok && i <= 50; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + i % 5; snprintf(t.title, sizeof t.title, "task \"%d\"", i);
+        list_push(&S.list, t); store_put(&S, &t);
+    }
+    ok = ok && store_compact(&S, 1);
+    Task e = task_at(&S.list, (size_t)list_find_index_by_id(&S.list, 7)); strcpy(e.due, "2026-01-31"); e.done = 1;
+    list_replace(&S.list, (size_t)list_find_index_by_id(&S.list, 7), &e); store_put(&S, &e);
+    list_delete_at(&S.list, (size_t)list_find_index_by_id(&S.list, 8)); store_del(&S, 8);
+    store_wait_compaction(&S);
+    rename(S.journal.path, S.journal.old_path); // compaction that died after rotating
+    journal_close(&S.journal);
+    int fd = open(S.journal.path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) { ok = ok && write(fd, "\x20\0\0\0garbage", 11) == 11; close(fd); }
+    if (ok) { // a reader sees the same tasks and leaves both journals as they are
+        Store Q; struct stat js;
+        ok = store_open(&Q, path, STORE_READ) && Q.list.live == 49 && list_find_index_by_id(&Q.list, 8) < 0
+            && access(Q.journal.old_path, F_OK) == 0 && stat(Q.journal.path, &js) == 0 && js.st_size == 11;
+        store_close(&Q);
+        ok = ok && store_exists(path) && !store_exists("tasks_journal_test_missing.json");
+    }
+    Store R;
+    ok = ok && store_open(&R, path, 0) && R.list.live == 49 && list_find_index_by_id(&R.list, 8) < 0;
+    if (ok) {
+        Task t = task_at(&R.list, (size_t)list_find_index_by_id(&R.list, 7));
+        ok = t.done == 1 && strcmp(t.due, "2026-01-31") == 0 && strcmp(t.title, "task \"7\"") == 0
+            && access(R.journal.old_path, F_OK) != 0 && R.journal.size == 0;
+    }
+    printf("Test: journal replay %s\n", ok ? "OK" : "FAILED");
+    store_close(&R); list_free(&S.list);
+    unlink(path); unlink(S.journal.path);
+    return ok;
+}
+
+static int test_index(void){
+    TaskList L; list_init(&L);
+    for (int i = 1; i <= 5000; ++i) { Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 3; list_push(&L, t); }
+    for (int i = 2; i <= 5000; i += 2) list_delete_at(&L, (size_t)list_find_index_by_id(&L, i));
+    list_delete_at(&L, (size_t)list_find_index_by_id(&L, 4999));
+    int ok = L.live == 2499 && list_next_id(&L) == 5001 && list_find_index_by_id(&L, 4) < 0;
+    int prev = 0;
+    for (size_t i = 0; ok && i < L.len; ++i) {
+        if (!list_live(&L, i)) continue;
+        if (L.id[i] <= prev || list_find_index_by_id(&L, L.id[i]) != (int)i) ok = 0;
+        prev = L.id[i];
+    }
+    printf("Test: id index %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+static int cmp_due_ref(const void *a, const void *b){
+    const Task *x=a, *y=b;
+    int c = strcmp(x->due[0]? x->due : "~", y->due[0]? y->due : "~");
+    if (c) return c;
+    if (x->priority!=y->priority) return y->priority - x->priority;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static int cmp_priority_ref(const void *a, const void *b){
+    const Task *x=a, *y=b;
+    if (x->priority!=y->priority) return y->priority - x->priority;
+    return cmp_due_ref(a, b);
+}
+
+// Views must match a plain qsort and survive edits that cannot reorder them.
+static int test_views(void){
+    TaskList L; list_init(&L);
+    unsigned seed = 12345;
+    for (int i = 1; i <= 20000; ++i) {
+        Task t; memset(&t,0,sizeof t);
+        seed = seed * 1103515245u + 12345u;
+        t.id = (i % 97 == 0) ? -i : i; t.priority = 1 + (int)(seed >> 16) % 7; // 6, 7 clamp to 5
+        if ((seed >> 8) % 4) snprintf(t.due, sizeof t.due, "%04u-%02u-%02u", 1900 + (seed >> 4) % 201, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        list_push(&L, t);
+    }
+    for (int i = 3; i <= 20000; i += 3) { int idx = list_find_index_by_id(&L, i); if (idx >= 0) list_delete_at(&L, (size_t)idx); }
+    int ok = 1;
+    for (int d = date_to_day("1900-01-01"); ok && d <= date_to_day("2100-12-31"); ++d) {
+        char buf[DATE_LEN + 1];
+        day_to_date(d, buf);
+        ok = valid_date(buf) && date_to_day(buf) == d;
+    }
+    for (int pass = 0; ok && pass < 2; ++pass) {
+        for (int view = 0; ok && view < VIEW_COUNT; ++view) {
+            Task *ref = (Task*)xmalloc(L.live * sizeof(Task));
+            size_t n = 0;
+            for (size_t i = 0; i < L.len; ++i) if (list_live(&L, i)) ref[n++] = task_at(&L, i);
+            qsort(ref, n, sizeof(Task), view == VIEW_DUE ? cmp_due_ref : cmp_priority_ref);
+            const SortView *v = list_view(&L, view);
+            size_t k = 0;
+            for (size_t i = 0; ok && i < v->n; ++i) {
+                uint32_t slot = v->order[i];
+                if (slot >= L.len || !list_live(&L, slot)) continue;
+                ok = k < n && L.id[slot] == ref[k++].id;
+            }
+            ok = ok && k == n;
+            free(ref);
+        }
+        // Title and done edits keep the views; a priority edit drops them.
+        Task e = task_at(&L, 0); strcpy(e.title, "renamed"); e.done = !e.done; list_replace(&L, 0, &e);
+        list_delete_at(&L, 1);
+        ok = ok && L.view[VIEW_DUE].valid && L.view[VIEW_PRIORITY].valid;
+        e.priority = e.priority == 1 ? 2 : 1; list_replace(&L, 0, &e);
+        ok = ok && !L.view[VIEW_DUE].valid && !L.view[VIEW_PRIORITY].valid;
+    }
+    printf("Test: sorted views %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+// Top-K through the heap must equal the head of the fully sorted, filtered view.
+static int filter_ref(const Filter *f, const Task *t){
+    return t->due_day < f->due_limit && t->priority >= f->min_priority && !(f->only_open && t->done);
+}
+
+static int cmp_u64_desc(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+// The heap's top k against every open task scored from scratch, plus the
+// heap and position invariants.
+static int next_matches(const TaskList *L, int today) {
+    const Sched *S = L->sched;
+    uint64_t *all = (uint64_t*)xmalloc((L->len + 1) * sizeof *all);
+    size_t n = 0;
+    for (size_t i = 0; i < L->len; ++i)
+        if (list_live(L, i) && !list_done(L, i)) all[n++] = urgency_key(today, L->id[i], L->due_day[i], L->priority[i]);
+    qsort(all, n, sizeof *all, cmp_u64_desc);
+    uint32_t top[25];
+    size_t k = sched_top(S, 25, top);
+    int ok = S->n == n && k == (n < 25 ? n : 25) && S->today == today;
+    for (size_t i = 0; ok && i < k; ++i) ok = urgency_key(today, L->id[top[i]], L->due_day[top[i]], L->priority[top[i]]) == all[i];
+    for (size_t i = 1; ok && i < S->n; ++i) ok = S->key[(i - 1) / 2] >= S->key[i] && S->pos[S->heap[i]] == i;
+    free(all);
+    return ok;
+}
+
+static int test_next(void){
+    int today = date_to_day("2026-03-15");
+    TaskList L; list_init(&L);
+    for (int i = 1; i <= 3000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + (i * 7) % 5; t.done = i % 9 == 0;
+        if (i % 5) day_to_date(today - 120 + (i * 37) % 240, t.due);
+        list_push(&L, t);
+    }
+    L.sched = sched_build(&L, today);
+    int ok = next_matches(&L, today);
+    for (int i = 1; i <= 3000; i += 7) {
+        Task t; list_get(&L, (size_t)list_find_index_by_id(&L, i), &t);
+        t.done = !t.done; t.priority = 1 + (t.priority + 2) % 5;
+        if (i % 2) day_to_date(today + i % 40 - 20, t.due); else t.due[0] = '\0';
+        list_replace(&L, (size_t)list_find_index_by_id(&L, i), &t);
+    }
+    for (int i = 3; i <= 3000; i += 11) list_delete_at(&L, (size_t)list_find_index_by_id(&L, i));
+    for (int i = 3001; i <= 3500; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + i % 5;
+        day_to_date(today + i % 30 - 10, t.due);
+        list_push(&L, t);
+    }
+    ok = ok && next_matches(&L, today);
+    static const int step[] = { 1, 2, 7, 30, 200, -40 };
+    for (size_t s = 0; ok && s < sizeof step / sizeof *step; ++s) {
+        today += step[s];
+        sched_rollover(&L, today);
+        ok = next_matches(&L, today);
+    }
+    for (int i = 1; i <= 2900; ++i) { int idx = list_find_index_by_id(&L, i); if (idx >= 0) list_delete_at(&L, (size_t)idx); }
+    ok = ok && next_matches(&L, today); // rebuilt by the compaction
+    printf("Test: urgency scheduler %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+// Ranges against a scan of every open task with a due date.
+static int agenda_matches(const TaskList *L, int lo, int hi, size_t limit) {
+    uint64_t *all = (uint64_t*)xmalloc((L->len + 1) * sizeof *all);
+    size_t n = 0;
+    for (size_t i = 0; i < L->len; ++i)
+        if (list_live(L, i) && !list_done(L, i) && L->due_day[i] != DUE_NONE && L->due_day[i] >= lo && L->due_day[i] < hi) all[n++] = sort_key(L, i, VIEW_DUE);
+    qsort(all, n, sizeof *all, cmp_u64);
+    uint32_t *slot;
+    size_t k = agenda_select(L, lo, hi, limit, &slot);
+    int ok = k == (limit && limit < n ? limit : n);
+    for (size_t i = 0; ok && i < k; ++i) ok = sort_key(L, slot[i], VIEW_DUE) == all[i];
+    free(slot); free(all);
+    return ok;
+}
+
+static int calendar_matches(const TaskList *L, int today) {
+    static const int range[][2] = { { -400, -100 }, { -1, 0 }, { 0, 7 }, { 0, 1 }, { -5000, 5000 }, { 30, 31 }, { 200, 900 } };
+    int ok = 1;
+    for (size_t r = 0; ok && r < sizeof range / sizeof *range; ++r)
+        ok = agenda_matches(L, today + range[r][0], today + range[r][1], 0)
+          && agenda_matches(L, today + range[r][0], today + range[r][1], 5);
+    return ok && agenda_matches(L, INT_MIN, today, 0) && agenda_matches(L, INT_MIN, INT_MAX, 17)
+        && agenda_matches(L, today, INT_MAX, 0);
+}
+
+static int test_calendar(void){
+    int today = date_to_day("2026-03-15");
+    TaskList L; list_init(&L);
+    for (int i = 1; i <= 3000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + (i * 7) % 5; t.done = i % 9 == 0;
+        if (i % 5) day_to_date(today - 300 + (i * 37) % 900, t.due);
+        list_push(&L, t);
+    }
+    // Outside the calendar's span; filed in its end buckets.
+    Task t; memset(&t,0,sizeof t); t.id = 3001; t.priority = 3; strcpy(t.due, "1850-06-01"); list_push(&L, t);
+    t.id = 3002; strcpy(t.due, "2250-06-01"); list_push(&L, t);
+    cal_ensure(&L);
+    int ok = calendar_matches(&L, today);
+    for (int i = 1; i <= 3000; i += 7) {
+        list_get(&L, (size_t)list_find_index_by_id(&L, i), &t);
+        t.done = !t.done; t.priority = 1 + (t.priority + 2) % 5;
+        if (i % 2) day_to_date(today + i % 40 - 20, t.due); else t.due[0] = '\0';
+        list_replace(&L, (size_t)list_find_index_by_id(&L, i), &t);
+    }
+    for (int i = 3; i <= 3000; i += 11) list_delete_at(&L, (size_t)list_find_index_by_id(&L, i));
+    ok = ok && calendar_matches(&L, today);
+    for (int i = 1; i <= 2900; ++i) { int idx = list_find_index_by_id(&L, i); if (idx >= 0) list_delete_at(&L, (size_t)idx); }
+    ok = ok && calendar_matches(&L, today); // rebuilt by the compaction
+    uint32_t *slot = NULL;
+    ok = ok && agenda_select(&L, INT_MIN, INT_MAX, 0, &slot) == L.cal->n;
+    free(slot);
+    printf("Test: calendar index %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+// The disk sort against query_select on the loaded list, with budgets that
+// fit everything, spill many runs, and force merge passes; then again with
+// edits left in the journal.
+static int test_external(void){
+    const char *json = "tasks_ext_test.json", *out = "tasks_ext_test.out";
+    int base = date_to_day("2026-01-01");
+    TaskList L; list_init(&L);
+    for (int i = 1; i <= 20000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + (i * 7) % 5; t.done = i % 3 == 0;
+        snprintf(t.title, sizeof t.title, "task %d%s", i, i % 7 ? "" : " with a \"quote\"\tand tab");
+        if (i % 11) day_to_date(base + (i * 37) % 400, t.due);
+        list_push(&L, t);
+    }
+    int ok = save_json(json, &L);
+    static const size_t budget[] = { 96 << 10, 200 << 10, 64 << 20 };
+    static const size_t limits[] = { 0, 1, 250, 50000 };
+    for (int pass = 0; ok && pass < 2; ++pass) {
+        if (pass) {
+            Store S;
+            ok = store_open(&S, json, 0);
+            for (int id = 2; ok && id <= 20000; id += 97) {
+                Task t; list_get(&L, (size_t)list_find_index_by_id(&L, id), &t);
+                if (id % 2) { list_delete_at(&L, (size_t)list_find_index_by_id(&L, id)); store_del(&S, id); continue; }
+                t.done = !t.done; t.priority = 5; strcpy(t.due, "2026-02-02");
+                list_replace(&L, (size_t)list_find_index_by_id(&L, id), &t); store_put(&S, &t);
+                t.id = list_next_id(&L); list_push(&L, t); store_put(&S, &t);
+            }
+            ok = ok && S.journal.size > 0;
+            store_close(&S);
+        }
+        for (size_t b = 0; ok && b < sizeof budget / sizeof *budget; ++b)
+            for (size_t l = 0; ok && l < sizeof limits / sizeof *limits; ++l) {
+                Query q = { { (int)l % 2 ? base + 200 : INT_MAX, (int)l % 3, (int)b % 2 }, (int)(l + b) % 2 ? VIEW_PRIORITY : VIEW_DUE, limits[l], FMT_TSV };
+                size_t cap = q.limit && q.limit < L.live ? q.limit : L.live;
+                uint32_t *slot = (uint32_t*)xmalloc(cap * sizeof *slot);
+                size_t n = query_select(&L, &q, slot);
+                WBuf want; wb_init_mem(&want, 4096);
+                for (size_t i = 0; i < n; ++i) wb_tsv_row(&want, &L, slot[i]);
+                int fd = open(out, O_RDWR | O_CREAT | O_TRUNC, 0644);
+                ok = fd >= 0 && ext_query(json, &q, budget[b], ".", fd);
+                char *got = (char*)xmalloc(want.len + 2);
+                ok = ok && lseek(fd, 0, SEEK_SET) == 0 && read(fd, got, want.len + 1) == (ssize_t)want.len && memcmp(got, want.buf, want.len) == 0;
+                if (fd >= 0) close(fd);
+                free(got); free(want.buf); free(slot);
+            }
+    }
+    printf("Test: external sort %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    char jpath[4096];
+    snprintf(jpath, sizeof jpath, "%s.journal", json);
+    unlink(json); unlink(jpath); unlink(out);
+    return ok;
+}
+
+static int reload_task(TaskList *L, int id, Task *t){
+    int i = list_find_index_by_id(L, id);
+    if (i >= 0) list_get(L, (size_t)i, t);
+    return i >= 0;
+}
+
+// Another program rewrites a watched store: each merge rule on its own task,
+// the write-back of local edits, our own compaction not counted as a change,
+// and an unreadable file left alone until it is fixed.
+static int test_reload(void){
+    const char *path = "tasks_reload_test.json";
+    TaskList A; list_init(&A);
+    for (int i = 1; i <= 10; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 3;
+        snprintf(t.title, sizeof t.title, "task %d", i);
+        day_to_date(date_to_day("2026-03-01") + i, t.due);
+        list_push(&A, t);
+    }
+    Store S; ReloadStats st; Task t;
+    int ok = save_tasks(path, &A) && store_open(&S, path, STORE_SEARCH | STORE_WATCH) && S.base;
+    // Here: 1 done, 2 and 5 edited, 3 deleted, 11 added.
+    if (ok) {
+        reload_task(&S.list, 1, &t); t.done = 1; list_replace(&S.list, (size_t)list_find_index_by_id(&S.list, 1), &t); store_put(&S, &t);
+        reload_task(&S.list, 2, &t); strcpy(t.title, "mine 2"); list_replace(&S.list, (size_t)list_find_index_by_id(&S.list, 2), &t); store_put(&S, &t);
+        reload_task(&S.list, 5, &t); t.priority = 5; list_replace(&S.list, (size_t)list_find_index_by_id(&S.list, 5), &t); store_put(&S, &t);
+        list_delete_at(&S.list, (size_t)list_find_index_by_id(&S.list, 3)); store_del(&S, 3);
+        memset(&t,0,sizeof t); t.id = list_next_id(&S.list); t.priority = 2; strcpy(t.title, "mine 11");
+        list_push(&S.list, t); store_put(&S, &t);
+    }
+    // There: 1 and 2 and 3 retitled, 6 moved, 4 and 5 deleted, 11 and 20 added.
+    static const char *const title[] = { NULL, "renamed 1", "theirs 2", "edited 3" };
+    for (int id = 1; id <= 3; ++id) { reload_task(&A, id, &t); strcpy(t.title, title[id]); list_replace(&A, (size_t)list_find_index_by_id(&A, id), &t); }
+    reload_task(&A, 6, &t); strcpy(t.due, "2026-12-24"); list_replace(&A, (size_t)list_find_index_by_id(&A, 6), &t);
+    list_delete_at(&A, (size_t)list_find_index_by_id(&A, 4));
+    list_delete_at(&A, (size_t)list_find_index_by_id(&A, 5));
+    memset(&t,0,sizeof t); t.id = 11; t.priority = 1; strcpy(t.title, "theirs 11"); list_push(&A, t);
+    t.id = 20; strcpy(t.title, "new 20"); list_push(&A, t);
+    ok = ok && save_tasks(path, &A) && store_changed(&S) && store_refresh(&S, &st) == 1
+        && st.updated == 2 && st.added == 2 && st.deleted == 1 && st.conflicts == 4 && S.list.live == 12;
+    ok = ok && reload_task(&S.list, 1, &t) && t.done && strcmp(t.title, "renamed 1") == 0
+        && reload_task(&S.list, 2, &t) && strcmp(t.title, "mine 2") == 0
+        && reload_task(&S.list, 3, &t) && strcmp(t.title, "edited 3") == 0
+        && !reload_task(&S.list, 4, &t)
+        && reload_task(&S.list, 5, &t) && t.priority == 5
+        && reload_task(&S.list, 6, &t) && t.due_day == date_to_day("2026-12-24")
+        && reload_task(&S.list, 11, &t) && strcmp(t.title, "mine 11") == 0
+        && reload_task(&S.list, 12, &t) && strcmp(t.title, "theirs 11") == 0
+        && reload_task(&S.list, 20, &t);
+    // The local edits went back to the file; that write is not a change.
+    store_wait_compaction(&S);
+    ok = ok && S.journal.size == 0 && store_refresh(&S, &st) == 0;
+    Store R;
+    ok = ok && store_open(&R, path, 0) && R.list.live == S.list.live;
+    for (size_t i = 0; ok && i < S.list.len; ++i) {
+        if (!list_live(&S.list, i)) continue;
+        int j = list_find_index_by_id(&R.list, S.list.id[i]);
+        ok = j >= 0 && slots_equal(&S.list, i, &R.list, (size_t)j);
+    }
+    store_close(&R);
+    // A change with no local edits is taken as is, and nothing is written.
+    FileStamp before;
+    if (ok) { list_free(&A); list_init(&A); ok = load_tasks(path, &A); }
+    if (ok && (ok = reload_task(&A, 7, &t))) { strcpy(t.title, "renamed 7"); list_replace(&A, (size_t)list_find_index_by_id(&A, 7), &t); }
+    ok = ok && save_tasks(path, &A);
+    file_stamp(path, &before);
+    ok = ok && store_changed(&S) && store_refresh(&S, &st) == 1 && st.updated == 1 && st.conflicts == 0
+        && reload_task(&S.list, 7, &t) && strcmp(t.title, "renamed 7") == 0 && memcmp(&S.stamp, &before, sizeof before) == 0;
+    // Half-written: ignored, and still pending once it is whole.
+    FILE *f = fopen(path, "w");
+    if (f) { fputs("[{\"id\": 1, \"title\": ", f); fclose(f); }
+    ok = ok && f && store_changed(&S) && store_refresh(&S, &st) == -1 && S.list.live == 12 && store_changed(&S);
+    ok = ok && save_tasks(path, &A) && store_refresh(&S, &st) == 1 && st.updated == 0 && st.deleted == 0;
+    printf("Test: live reload %s\n", ok ? "OK" : "FAILED");
+    store_close(&S);
+    list_free(&A);
+    unlink(path); unlink(S.journal.path); unlink(S.journal.old_path); unlink(S.tri_path);
+    return ok;
+}
+
+#ifdef HAVE_ZLIB
+// A .gz store round-trips through both loaders and is far smaller than the
+// JSON; a cut-short file fails to load.
+static int test_compressed(void){
+    const char *gz = "tasks_gz_test.json.gz", *json = "tasks_gz_test.json";
+    TaskList A; list_init(&A);
+    for (int i = 1; i <= 30000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + i % 5; t.done = i % 4 == 0;
+        snprintf(t.title, sizeof t.title, "Task %d \"quoted\" \\ %s", i, i % 3 ? "#work" : "#home");
+        if (i % 6) day_to_date(date_to_day("2026-01-01") + i % 365, t.due);
+        list_push(&A, t);
+    }
+    int ok = save_tasks(gz, &A) && save_tasks(json, &A);
+    struct stat zs, js;
+    int fd = open(gz, O_RDONLY);
+    ok = ok && fd >= 0 && gz_magic(fd) && stat(gz, &zs) == 0 && stat(json, &js) == 0 && zs.st_size * 5 < js.st_size;
+    if (fd >= 0) close(fd);
+    TaskList B; list_init(&B);
+    ok = ok && load_tasks(gz, &B) && B.live == A.live;
+    for (size_t i = 0; ok && i < A.len; ++i) {
+        Task a, b; list_get(&A, i, &a); list_get(&B, i, &b);
+        ok = a.id == b.id && strcmp(a.title, b.title) == 0 && strcmp(a.due, b.due) == 0 && a.priority == b.priority && a.done == b.done;
+    }
+    list_free(&B);
+    // Same bytes under a name that does not say .gz: found by content.
+    ok = ok && rename(gz, json) == 0 && load_tasks(json, &B) && B.live == A.live;
+    list_free(&B);
+    ok = ok && truncate(json, zs.st_size / 2) == 0 && !load_tasks(json, &B);
+    list_free(&B);
+    printf("Test: compressed store %s\n", ok ? "OK" : "FAILED");
+    list_free(&A);
+    unlink(gz); unlink(json);
+    return ok;
+}
+#endif
+
+// Each bulk edit against a per-task check, then a replay of the batched
+// journal against the list in memory.
+static int test_bulk(void){
+    const char *path = "tasks_bulk_test.json";
+    Store S; int ok = 1;
+    unlink(path);
+    ok = store_open(&S, path, STORE_SEARCH);
+    for (int i = 1; ok && i <= 3000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + (i * 7) % 5; t.done = i % 6 == 0;
+        snprintf(t.title, sizeof t.title, "%s task %d", i % 3 ? "home" : "work", i);
+        if (i % 4) day_to_date(date_to_day("2026-01-01") + i % 90, t.due);
+        list_push(&S.list, t); store_put(&S, &t);
+    }
+    int limit = date_to_day("2026-02-01");
+    size_t want = 0;
+    for (size_t i = 0; i < S.list.len; ++i)
+        want += !list_done(&S.list, i) && S.list.due_day[i] < limit && S.list.priority[i] >= 4;
+    Predicate p = { { limit, 4, 0 }, 0, NULL };
+    off_t before = S.journal.size;
+    ok = ok && store_bulk(&S, &p, BULK_DONE, 0) == want && S.journal.size > before && !S.journal.batch;
+    for (size_t i = 0; ok && i < S.list.len; ++i)
+        if (S.list.due_day[i] < limit && S.list.priority[i] >= 4) ok = list_done(&S.list, i);
+    Predicate work = { { INT_MAX, 0, 1 }, 0, "WORK" };
+    ok = ok && store_bulk(&S, &work, BULK_PRIORITY, 5) > 0;
+    for (size_t i = 0; ok && i < S.list.len; ++i)
+        if (!list_done(&S.list, i) && strncmp(list_title(&S.list, i), "work", 4) == 0) ok = S.list.priority[i] == 5;
+    Task first = task_at(&S.list, (size_t)list_find_index_by_id(&S.list, 1));
+    Predicate all = { { INT_MAX, 0, 0 }, 0, NULL };
+    ok = ok && store_bulk(&S, &all, BULK_SHIFT, -10) > 0
+        && S.list.due_day[list_find_index_by_id(&S.list, 1)] == first.due_day - 10;
+    Predicate done = { { INT_MAX, 0, 0 }, 1, NULL };
+    size_t ndone = 0;
+    for (size_t i = 0; i < S.list.len; ++i) ndone += list_done(&S.list, i);
+    ok = ok && store_bulk(&S, &done, BULK_DELETE, 0) == ndone && S.list.live == 3000 - ndone;
+    Store R;
+    ok = ok && store_open(&R, path, 0) && R.list.live == S.list.live;
+    for (size_t i = 0, j = 0; ok && i < S.list.len; ++i) {
+        if (!list_live(&S.list, i)) continue;
+        while (!list_live(&R.list, j)) j++;
+        ok = slots_equal(&S.list, i, &R.list, j++);
+    }
+    printf("Test: bulk edits %s\n", ok ? "OK" : "FAILED");
+    store_close(&R);
+    store_close(&S);
+    unlink(path); unlink(S.journal.path); unlink(S.tri_path);
+    return ok;
+}
+
+// Import, routing by id, adds past an id block, and fan-out queries under a
+// budget small enough to force evictions, all against one unsharded store.
+static int test_shards(void){
+    const char *path = "tasks_shard_test.json", *dir = "tasks_shard_test.d";
+    static const char *const tag[] = { "", " #work", " #Home", " #side-project", " #work" };
+    Store S; int ok = 1;
+    unlink(path);
+    ok = store_open(&S, path, 0);
+    for (int i = 1; ok && i <= 6000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i * 3; t.priority = 1 + (i * 7) % 5; t.done = i % 5 == 0;
+        snprintf(t.title, sizeof t.title, "task %d%s", i, tag[(i / 7) % 5]);
+        if (i % 4) day_to_date(date_to_day("2026-01-01") + i % 120, t.due);
+        list_push(&S.list, t); store_put(&S, &t);
+    }
+    ShardSet T;
+    ok = ok && shards_open(&T, dir, 1) && shards_import(&T, path) && T.n == 4;
+    shards_close(&T);
+    ok = ok && shards_open(&T, dir, 1) && T.n == 4 && shard_of_id(&T, 21) == shard_find(&T, "work", 0) && shard_of_id(&T, 22) < 0;
+    for (int i = 0; ok && i < SHARD_BLOCK + 10; ++i) {
+        Task t; memset(&t,0,sizeof t); t.priority = 2;
+        snprintf(t.title, sizeof t.title, "new %d #%s", i, i % 2 ? "home" : "errands");
+        const char *name;
+        ok = shards_add(&T, &t, &name) && strcmp(name, i % 2 ? "home" : "errands") == 0 && t.id > 18000;
+        list_push(&S.list, t);
+    }
+    int shard, idx;
+    Store *D = ok ? shards_locate(&T, 21, &shard, &idx) : NULL;
+    ok = D && strcmp(T.shard[shard].name, "work") == 0;
+    if (ok) {
+        list_delete_at(&D->list, (size_t)idx); store_del(D, 21); shard_touched(&T, (size_t)shard);
+        list_delete_at(&S.list, (size_t)list_find_index_by_id(&S.list, 21));
+    }
+    shards_close(&T);
+    static const size_t limits[] = { 0, 7, 100 };
+    char manifest[256]; struct stat before, after;
+    snprintf(manifest, sizeof manifest, "%s/manifest", dir);
+    ok = ok && stat(manifest, &before) == 0 && shards_open(&T, dir, 1) && T.n == 5;
+    for (size_t l = 0; ok && l < sizeof limits / sizeof *limits; ++l) {
+        Query q = { { date_to_day("2026-03-01"), 2, 1 }, (int)l % 2 ? VIEW_PRIORITY : VIEW_DUE, limits[l], FMT_TSV };
+        TaskList R; list_init(&R);
+        shards_select(&T, &q, NULL, 3, &R);
+        uint32_t *slot = (uint32_t*)xmalloc((S.list.live + 1) * sizeof *slot);
+        size_t n = query_select(&S.list, &q, slot);
+        ok = n == R.len;
+        for (size_t k = 0; ok && k < n; ++k) ok = slots_equal(&S.list, slot[k], &R, k);
+        free(slot); list_free(&R);
+        size_t open = 0;
+        for (size_t i = 0; i < T.n; ++i) open += T.shard[i].store != NULL;
+        ok = ok && open == 0 && T.resident == 0; // nothing fits in a one-byte budget
+    }
+    shards_close(&T);
+    // Queries changed nothing, so the manifest was not rewritten.
+    ok = ok && stat(manifest, &after) == 0 && before.st_ino == after.st_ino && before.st_mtim.tv_nsec == after.st_mtim.tv_nsec;
+    printf("Test: sharded store %s\n", ok ? "OK" : "FAILED");
+    static const char *const files[] = { "manifest", "idmap", "inbox.tdb", "work.tdb", "home.tdb", "side-project.tdb", "errands.tdb" };
+    for (size_t i = 0; i < sizeof files / sizeof *files; ++i) {
+        char f[256];
+        snprintf(f, sizeof f, "%s/%s", dir, files[i]); unlink(f);
+        snprintf(f, sizeof f, "%s/%s.journal", dir, files[i]); unlink(f);
+    }
+    rmdir(dir);
+    store_close(&S);
+    unlink(path); unlink(S.journal.path);
+    return ok;
+}
+
+// Every SIMD level must select what the per-task predicate selects, and top-K
+// through the heap must equal the head of the fully sorted, filtered view.
+static int test_query(void){
+    TaskList L; list_init(&L);
+    for (int i = 1; i <= 5000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + (i * 7) % 5; t.done = i % 4 == 0;
+        if (i % 3) snprintf(t.due, sizeof t.due, "2025-%02d-%02d", 1 + i % 12, 1 + i % 28);
+        list_push(&L, t);
+    }
+    for (int i = 11; i <= 5000; i += 13) list_delete_at(&L, (size_t)list_find_index_by_id(&L, i));
+    static const size_t limits[] = { 0, 1, 17, 4999, 100000 };
+    int ok = 1;
+    simd_init();
+    int saved = simd_level;
+    for (int lvl = SIMD_NONE; lvl <= saved; ++lvl) {
+        simd_force(lvl);
+        for (int view = 0; view < VIEW_COUNT; ++view) {
+            for (size_t li = 0; ok && li < sizeof limits / sizeof limits[0]; ++li) {
+                Query q = { { date_to_day("2025-09-15"), 2, (int)li % 2 }, view, limits[li], FMT_TSV };
+                uint32_t *got = (uint32_t*)xmalloc(L.live * sizeof *got);
+                size_t n = query_select(&L, &q, got), k = 0;
+                const SortView *v = list_view(&L, view);
+                for (size_t i = 0; ok && i < v->n && (!q.limit || k < q.limit); ++i) {
+                    uint32_t slot = v->order[i];
+                    if (slot >= L.len || !list_live(&L, slot)) continue;
+                    Task t = task_at(&L, slot);
+                    if (!filter_ref(&q.filter, &t)) continue;
+                    ok = k < n && got[k++] == slot;
+                }
+                ok = ok && k == n && n > 0;
+                free(got);
+            }
+        }
+    }
+    simd_force(saved);
+    printf("Test: filters and top-K %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+static size_t search_brute(const TaskList *L, const char *query, uint32_t *out){
+    char q[256]; snprintf(q, sizeof q, "%s", query);
+    for (char *p = q; *p; ++p) *p = (char)fold((unsigned char)*p);
+    size_t n = 0;
+    for (size_t i = 0; i < L->len; ++i) {
+        if (!list_live(L, i)) continue;
+        int hit = 1;
+        char tmp[256]; strcpy(tmp, q);
+        for (char *t = strtok(tmp, " \t"); t && hit; t = strtok(NULL, " \t")) hit = contains_folded(list_title(L, i), t, strlen(t));
+        if (hit) out[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+// A real daemon over its socket: each request kind, a bad one, concurrent
+// clients, and every acknowledged edit found again after a reopen.
+#ifdef __linux__
+static void *test_daemon_loop(void *arg){ daemon_loop((Daemon*)arg); return NULL; }
+
+static int daemon_expect(const char *sock, const char *req, const char *want){
+    WBuf r; wb_init_mem(&r, 256);
+    int ok = client_call(sock, req, strlen(req), &r) && r.len == strlen(want) && memcmp(r.buf, want, r.len) == 0;
+    if (!ok) fprintf(stderr, "  %s-> %.*s", req, (int)r.len, r.buf);
+    free(r.buf);
+    return ok;
+}
+
+static void *test_daemon_adder(void *arg){
+    static const char req[] = "ADD\tbatch\t\t\n";
+    WBuf r; wb_init_mem(&r, 256);
+    for (int i = 0; i < 50; ++i) client_call((const char*)arg, req, sizeof req - 1, &r);
+    free(r.buf);
+    return NULL;
+}
+
+static int test_daemon(void){
+    const char *path = "tasks_daemon_test.json", *sock = "tasks_daemon_test.sock";
+    Daemon D; pthread_t loop, adder[4];
+    int ok = daemon_open(&D, path, sock) && pthread_create(&loop, NULL, test_daemon_loop, &D) == 0;
+    if (ok) {
+        ok = daemon_expect(sock, "ADD\tbuy milk\t2026-03-01\t2\n", "OK 1\n1\n")
+            && daemon_expect(sock, "ADD\tfile\\ttaxes\t\t\n", "OK 1\n2\n")
+            && daemon_expect(sock, "ADD\tbad\t2026-02-30\t\n", "ERR invalid task\n")
+            && daemon_expect(sock, "UPDATE\t1\tdone\t1\n", "OK 1\n1\tbuy milk\t2026-03-01\t2\t1\n")
+            && daemon_expect(sock, "QUERY\t\t\t1\tpriority\t\n", "OK 1\n2\tfile\\ttaxes\t\t3\t0\n")
+            && daemon_expect(sock, "SEARCH\tMILK\n", "OK 1\n1\tbuy milk\t2026-03-01\t2\t1\n")
+            && daemon_expect(sock, "DEL\t2\n", "OK 0\n")
+            && daemon_expect(sock, "GET\t2\n", "ERR not found\n");
+        for (int i = 0; i < 4; ++i) pthread_create(&adder[i], NULL, test_daemon_adder, (void*)sock);
+        for (int i = 0; i < 4; ++i) pthread_join(adder[i], NULL);
+        ok = daemon_expect(sock, "QUERY\t\t\t\t\t1\n", "OK 1\n1\tbuy milk\t2026-03-01\t2\t1\n") && ok;
+        char b = 1;
+        ok = write(D.quit[1], &b, 1) == 1 && ok;
+        pthread_join(loop, NULL);
+    }
+    daemon_close(&D);
+    Store R;
+    ok = ok && store_open(&R, path, 0) && R.list.live == 201 && list_next_id(&R.list) == 203
+        && task_at(&R.list, (size_t)list_find_index_by_id(&R.list, 1)).done == 1;
+    printf("Test: daemon %s\n", ok ? "OK" : "FAILED");
+    store_close(&R);
+    unlink(path); unlink(R.journal.path); unlink(R.tri_path);
+    return ok;
+}
+#endif
+
+// The index must agree with a brute-force scan through edits and a save/load.
+static int test_search(void){
+    static const char *words[] = { "Alpha", "beta", "GAMMA", "delta", "epsilon", "zeta", "éclair", "tax" };
+    static const char *queries[] = { "alp", "ALPHA gam", "ta", "eps zeta", "éCl", "x", "nothing here", "a b", "tax beta" };
+    TaskList L; list_init(&L);
+    L.tri = tri_new();
+    for (int i = 1; i <= 3000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 3;
+        snprintf(t.title, sizeof t.title, "%s %s #%d", words[i % 8], words[(i / 8) % 8], i);
+        list_push(&L, t);
+    }
+    int ok = 1;
+    uint32_t *want = (uint32_t*)xmalloc(4000 * sizeof *want);
+    for (int round = 0; ok && round < 3; ++round) {
+        if (round == 1) {
+            for (int i = 5; i <= 3000; i += 5) {
+                int idx = list_find_index_by_id(&L, i);
+                if (i % 10) list_delete_at(&L, (size_t)idx);
+                else { Task e = task_at(&L, (size_t)idx); snprintf(e.title, sizeof e.title, "renamed TAX %d", i); list_replace(&L, (size_t)idx, &e); }
+            }
+            Task t; memset(&t,0,sizeof t); t.id = -4; strcpy(t.title, "negative alpha"); list_push(&L, t);
+        }
+        if (round == 2) {
+            FileStamp fs; memset(&fs, 0, sizeof fs); fs.size = 42;
+            ok = tri_save("tasks_test.tri", L.tri, &fs);
+            tri_free(L.tri);
+            L.tri = tri_load("tasks_test.tri", &fs);
+            fs.size = 43;
+            TriIndex *stale = tri_load("tasks_test.tri", &fs);
+            ok = ok && L.tri && !stale;
+            tri_free(stale);
+            unlink("tasks_test.tri");
+            if (!ok) break;
+        }
+        for (size_t k = 0; ok && k < sizeof queries / sizeof queries[0]; ++k) {
+            uint32_t *got;
+            size_t n = title_search(&L, queries[k], &got), m = search_brute(&L, queries[k], want);
+            // Both are complete; compare as sets.
+            if (n) qsort(got, n, sizeof *got, cmp_u32);
+            ok = n == m && (n == 0 || memcmp(got, want, n * sizeof *got) == 0);
+            free(got);
+        }
+    }
+    free(want);
+    printf("Test: title search %s\n", ok ? "OK" : "FAILED");
+    list_free(&L);
+    return ok;
+}
+
+// Snapshot round-trip, edits on the mapped list, JSON conversion and a bad header.
+static int test_snapshot(void){
+    const char *bin = "tasks_snap_test.tdb", *json = "tasks_snap_test.json";
+    TaskList A; list_init(&A);
+    for (int i = 1; i <= 3000; ++i) {
+        Task t; memset(&t,0,sizeof t); t.id = i; t.priority = 1 + i % 5; t.done = i % 2;
+        snprintf(t.title, sizeof t.title, "snap \"%d\"", i);
+        if (i % 7 == 0) strcpy(t.due, "2025-12-31");
+        list_push(&A, t);
+    }
+    for (int i = 10; i <= 3000; i += 10) list_delete_at(&A, (size_t)list_find_index_by_id(&A, i));
+    list_delete_at(&A, (size_t)list_find_index_by_id(&A, 3000));
+    TaskList B; list_init(&B);
+    int ok = save_tasks(bin, &A) && load_tasks(bin, &B) && B.map && B.live == A.live && B.max_id == 3000;
+    for (size_t i = 0, j = 0; ok && i < A.len; ++i) {
+        if (!list_live(&A, i)) continue;
+        ok = slots_equal(&A, i, &B, j++);
+    }
+    ok = ok && list_find_index_by_id(&B, 2999) >= 0 && list_find_index_by_id(&B, 20) < 0;
+    if (ok) {
+        Task e = task_at(&B, 0); e.done = 1; list_replace(&B, 0, &e);
+        ok = B.map != NULL;
+        e = task_at(&B, 1); strcpy(e.title, "retitled while mapped"); list_replace(&B, 1, &e);
+        Task n; memset(&n,0,sizeof n); n.id = list_next_id(&B); strcpy(n.title, "after map"); n.priority = 3;
+        list_push(&B, n);
+        ok = ok && !B.map && n.id == 3001 && list_done(&B, 0) && strcmp(list_title(&B, 1), e.title) == 0
+            && list_find_index_by_id(&B, 3001) == (int)B.len - 1;
+    }
+    list_free(&A);
+    TaskList C; list_init(&C);
+    ok = ok && save_tasks(json, &B) && load_tasks(json, &C) && C.live == B.live && !C.map;
+    for (size_t i = 0; ok && i < B.len; ++i) ok = slots_equal(&B, i, &C, i);
+    FILE *f = fopen(bin, "r+b");
+    if (f) { fseek(f, 12, SEEK_SET); fputc(0x7F, f); fclose(f); }
+    ok = ok && load_tasks(bin, &A) == 0;
+    printf("Test: binary snapshot %s\n", ok ? "OK" : "FAILED");
+    list_free(&A); list_free(&B); list_free(&C);
+    unlink(bin); unlink(json);
+    return ok;
+}
+
+/*---------------- Main ----------------*/
+int main(int argc, char **argv){
+    if (argc>=2 && strcmp(argv[1],"--test")==0){
+        int ok = run_tests();
+        ok = test_index() && ok;
+        ok = test_stream() && ok;
+        ok = test_parallel_load() && ok;
+        ok = test_journal() && ok;
+        ok = test_snapshot() && ok;
+        ok = test_views() && ok;
+        ok = test_query() && ok;
+        ok = test_search() && ok;
+        ok = test_next() && ok;
+        ok = test_calendar() && ok;
+        ok = test_external() && ok;
+        ok = test_reload() && ok;
+#ifdef HAVE_ZLIB
+        ok = test_compressed() && ok;
+#endif
+        ok = test_bulk() && ok;
+        ok = test_shards() && ok;
+#ifdef __linux__
+        ok = test_daemon() && ok;
+#endif
+        return ok? 0: 1;
+    }
+    if (argc>=4 && strcmp(argv[1],"--convert")==0){
+        // Goes through the store so pending journal edits are carried over.
+        Store S;
+        int ok = store_open(&S, argv[2], 0) && save_tasks(argv[3], &S.list);
+        if (ok) printf("Converted %zu tasks: %s -> %s\n", S.list.live, argv[2], argv[3]);
+        else fprintf(stderr, "Failed to convert %s to %s\n", argv[2], argv[3]);
+        store_close(&S);
+        return ok? 0: 1;
+    }
+    if (argc>=2 && strcmp(argv[1],"--bench")==0) return run_bench(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"query")==0) return run_query(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"agenda")==0) return run_agenda(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"bulk")==0) return run_bulk(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"shards")==0) return run_shards(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"serve")==0) return run_serve(argc-1, argv+1);
+    if (argc>=2 && strcmp(argv[1],"client")==0) return run_client(argc-1, argv+1);
+    const char *path = (argc>=2 ? argv[1] : "tasks.json");
+    Store S;
+    if (!store_open(&S, path, STORE_SEARCH | STORE_WATCH)) {
+        fprintf(stderr, "Failed to load %s\n", path);
+        store_close(&S);
+        return 1;
+    }
+    printf("[Start] Loaded %zu tasks from %s\n", S.list.live, path);
+    menu_loop(&S);
+    store_close(&S);
     printf("[End]\n");
     return 0;
 }
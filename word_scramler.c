@@ -1,16 +1,21 @@
 // path: src/word-scramble-game.c
 // Build: cc -std=c11 -O2 -Wall -Wextra -Wpedantic -o word_scramble src/word-scramble-game.c
-// Run:   ./word_scramble
+// Run:   ./word_scramble [--seed S]
 // Notes:
 //  - Score = remaining tries when you guess correctly.
 //  - Timer shows total elapsed seconds for the round.
 //  - Type "quit" to exit at any prompt.
+//  - --seed S replays the same words and scrambles (rng.h).
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "rng.h"
 
 #define MAX_WORD_LEN 64
 #define MAX_TRIES 6
@@ -23,6 +28,8 @@ static const char *WORDS[] = {
 };
 static const size_t WORDS_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
 
+static Rng rng;
+
 // Trims trailing newline from fgets
 static void chomp(char *s) {
     size_t n = strlen(s);
@@ -41,11 +48,11 @@ static int ci_strcmp(const char *a, const char *b) {
            (int)(unsigned char)tolower((unsigned char)*b);
 }
 
-// Fisher-Yates shuffle
+// Fisher-Yates shuffle; every order is equally likely because rng_below is unbiased
 static void shuffle_in_place(char *s, size_t len) {
     if (len < 2) return;
     for (size_t i = len - 1; i > 0; --i) {
-        size_t j = (size_t)(rand() % (int)(i + 1));
+        size_t j = (size_t)rng_below(&rng, i + 1);
         char tmp = s[i];
         s[i] = s[j];
         s[j] = tmp;
@@ -95,7 +102,7 @@ static void print_hint(const char *word) {
 }
 
 static void play_round(void) {
-    const char *target = WORDS[rand() % WORDS_COUNT];
+    const char *target = WORDS[rng_below(&rng, WORDS_COUNT)];
 
     char scrambled[MAX_WORD_LEN];
     scramble_word(target, scrambled, sizeof(scrambled));
@@ -144,9 +151,22 @@ static void play_round(void) {
     }
 }
 
-int main(void) {
-    // Seed RNG using time
-    srand((unsigned int)time(NULL));
+int main(int argc, char **argv) {
+    // Seed RNG using time, unless given a seed
+    uint64_t seed = (uint64_t)time(NULL);
+    int args_ok = argc == 1;
+    // strtoull would take "-5" as 2^64 - 5 and skip leading spaces: digits only
+    if (argc == 3 && strcmp(argv[1], "--seed") == 0 && isdigit((unsigned char)argv[2][0])) {
+        char *end;
+        errno = 0;
+        seed = strtoull(argv[2], &end, 10);
+        args_ok = !*end && errno != ERANGE;
+    }
+    if (!args_ok) {
+        fprintf(stderr, "Usage: %s [--seed S]\n", argv[0]);
+        return 2;
+    }
+    rng_seed(&rng, seed);
 
     printf("Word Scramble — type 'quit' to exit.\n\n");
 